@@ -0,0 +1,654 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal 
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* *******************************************************************
+ * includes
+ * ******************************************************************/
+
+/* c -runtime */
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/* frame */
+#include <lib_convention__errno.h>
+#include <mini-printf.h>
+
+/* project */
+#include "lib_ttyportmux.h"
+#include "tty_portmux_fmt.h"
+
+/* *******************************************************************
+ * defines
+ * ******************************************************************/
+#define M_BENCH_CALLS_DEFAULT		100000
+#define M_BENCH_THREADS_MAX			64
+#define M_BENCH_LINE_SIZE			256
+#define M_BENCH_DEVLOG_PRIVATE		"/tmp/ttyportmux_bench_%d.sock"
+
+/* *******************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ******************************************************************/
+enum bench_op {
+	BENCH_OP_print,
+	BENCH_OP_vprint,
+	BENCH_OP_putchar,
+	BENCH_OP_CNT
+};
+
+enum bench_fmt {
+	BENCH_FMT_glibc,
+	BENCH_FMT_mini_printf,
+	BENCH_FMT_builtin,
+	BENCH_FMT_CNT
+};
+
+struct bench_run {
+	enum bench_op op;
+	unsigned int calls;
+	pthread_barrier_t barrier;
+};
+
+struct bench_worker {
+	struct bench_run *run;
+	pthread_t thread;
+	uint64_t start;
+	uint64_t end;
+};
+
+struct bench_drain {
+	int fd;
+	pthread_t thread;
+};
+
+/* *******************************************************************
+ * static function declarations
+ * ******************************************************************/
+static uint64_t lib_ttyportmux_bench__now(void);
+static void* lib_ttyportmux_bench__worker(void *_arg);
+static int lib_ttyportmux_bench__vprint(const char *_format, ...);
+static void lib_ttyportmux_bench__run(enum bench_op _op, const char *_device, unsigned int _threads, unsigned int _calls);
+static void lib_ttyportmux_bench__getline(unsigned int _calls);
+static int lib_ttyportmux_bench__map_info(enum ttyDeviceType _deviceType);
+static int lib_ttyportmux_bench__redirect_stdout(const char *_sink);
+static void lib_ttyportmux_bench__restore_stdout(void);
+static int lib_ttyportmux_bench__devlog_open(void);
+static void lib_ttyportmux_bench__devlog_close(void);
+static void* lib_ttyportmux_bench__drain(void *_arg);
+static void lib_ttyportmux_bench__allocs(const char *_device, unsigned int _calls);
+static int lib_ttyportmux_bench__format_one(enum bench_fmt _fmt, char *_buf, size_t _size, const char *_format, ...);
+static void lib_ttyportmux_bench__format(unsigned int _calls);
+
+/* *******************************************************************
+ * static data
+ * ******************************************************************/
+static const char * const s_opName[BENCH_OP_CNT] = { "print", "vprint", "putchar" };
+static const char * const s_fmtName[BENCH_FMT_CNT] = { "glibc", "mini_printf", "builtin" };
+static FILE *s_report = NULL;
+static const char *s_sink = "null";
+static const char *s_mode = "sync";
+static struct bench_drain s_pipeDrain = { .fd = -1 };
+static struct bench_drain s_devlogDrain = { .fd = -1 };
+static char s_devlogPath[108];
+static atomic_int s_allocCounting = 0;
+static atomic_ullong s_allocCount = 0;
+
+#if defined(__GLIBC__)
+/* *******************************************************************
+ * heap interposition, counts the allocations of the process while
+ * s_allocCounting is set
+ * ******************************************************************/
+extern void *__libc_malloc(size_t _size);
+extern void *__libc_calloc(size_t _n, size_t _size);
+extern void *__libc_realloc(void *_ptr, size_t _size);
+extern void __libc_free(void *_ptr);
+
+void *malloc(size_t _size)
+{
+	if (atomic_load_explicit(&s_allocCounting, memory_order_relaxed)) {
+		atomic_fetch_add_explicit(&s_allocCount, 1, memory_order_relaxed);
+	}
+	return __libc_malloc(_size);
+}
+
+void *calloc(size_t _n, size_t _size)
+{
+	if (atomic_load_explicit(&s_allocCounting, memory_order_relaxed)) {
+		atomic_fetch_add_explicit(&s_allocCount, 1, memory_order_relaxed);
+	}
+	return __libc_calloc(_n, _size);
+}
+
+void *realloc(void *_ptr, size_t _size)
+{
+	if (atomic_load_explicit(&s_allocCounting, memory_order_relaxed)) {
+		atomic_fetch_add_explicit(&s_allocCount, 1, memory_order_relaxed);
+	}
+	return __libc_realloc(_ptr, _size);
+}
+
+void free(void *_ptr)
+{
+	if ((_ptr != NULL) && atomic_load_explicit(&s_allocCounting, memory_order_relaxed)) {
+		atomic_fetch_add_explicit(&s_allocCount, 1, memory_order_relaxed);
+	}
+	__libc_free(_ptr);
+}
+#endif
+
+/* *******************************************************************
+ * function definition
+ * ******************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Throughput and call cost of the dispatch path of each ttydevice
+ *
+ * Usage: lib_ttyportmux_bench [-n calls] [-t threads] [-s null|pipe] [-a]
+ *
+ * Stdout is redirected to the sink so the unix port does not write to the
+ * terminal, the results are written as one JSON object per line to the
+ * original stdout. The "allocs" runs count the heap calls of the process
+ * per message, which are expected to be 0 and are checked by ctest with
+ * "lib_ttyportmux_check allocs". The native syslog port is redirected to a
+ * private stand-in socket. With vsyslog() the syslog runs are skipped, the
+ * system logger is never written to.
+ * ****************************************************************************/
+int main(int argc, char *argv[])
+{
+	struct ttyStreamMap map[TTYSTREAM_CNT];
+	struct ttyMuxConfig config = M_TTYMUX_CONFIG_DEFAULT;
+	struct list_node *node;
+	struct ttyDeviceInfo *info;
+	unsigned int calls = M_BENCH_CALLS_DEFAULT, threads, maxThreads = 4;
+	int opt, i, count, ret, devlog;
+	enum bench_op op;
+
+	while ((opt = getopt(argc, argv, "n:t:s:a")) != -1) {
+		switch (opt) {
+			case 'n': calls = (unsigned int)strtoul(optarg, NULL, 0); break;
+			case 't': maxThreads = (unsigned int)strtoul(optarg, NULL, 0); break;
+			case 's': s_sink = optarg; break;
+			case 'a':
+				config.mode = TTYMUX_MODE_async;
+				config.overflow = TTYMUX_OVERFLOW_block;
+				s_mode = "async";
+				break;
+			default:
+				fprintf(stderr, "usage: %s [-n calls] [-t threads] [-s null|pipe] [-a]\n", argv[0]);
+				return EXIT_FAILURE;
+		}
+	}
+
+	if ((calls == 0) || (maxThreads == 0) || (maxThreads > M_BENCH_THREADS_MAX)) {
+		fprintf(stderr, "invalid arguments\n");
+		return EXIT_FAILURE;
+	}
+
+	s_report = fdopen(dup(STDOUT_FILENO), "w");
+	if (s_report == NULL) {
+		return EXIT_FAILURE;
+	}
+
+	if (lib_ttyportmux_bench__redirect_stdout(s_sink) < EOK) {
+		fprintf(stderr, "invalid sink %s\n", s_sink);
+		return EXIT_FAILURE;
+	}
+	devlog = lib_ttyportmux_bench__devlog_open();
+
+	for (i = 0; i < TTYSTREAM_CNT; i++) {
+		map[i] = (struct ttyStreamMap)M_STREAM_MAPPING_ENTRY(TTYDEVICE_unix);
+	}
+
+	ret = lib_ttyportmux__init_ext(&map[0], sizeof(map), &config);
+	if (ret < EOK) {
+		fprintf(stderr, "init failed %d\n", ret);
+		return EXIT_FAILURE;
+	}
+
+	/* baseline: stream disabled by the enable mask, no dispatch at all */
+	lib_ttyportmux__set_stream_enable(M_TTYSTREAM_ENABLE_ALL & ~M_TTYSTREAM_BIT(TTYSTREAM_info));
+	for (threads = 1; threads <= maxThreads; threads = (threads < maxThreads) ? maxThreads : threads + 1) {
+		for (op = 0; op < BENCH_OP_CNT; op++) {
+			lib_ttyportmux_bench__run(op, "disabled", threads, calls);
+		}
+	}
+	lib_ttyportmux__set_stream_enable(M_TTYSTREAM_ENABLE_ALL);
+
+	count = lib_ttyportmux__ttydevice_count();
+	node = lib_ttyportmux__get_ttydevice_listentry();
+	for (i = 0; (i < count) && (node != NULL); i++, node = lib_ttyportmux__get_ttydevice_next(node)) {
+		info = lib_ttyportmux__get_ttydevice_info(node);
+		if (lib_ttyportmux_bench__map_info(info->deviceType) < EOK) {
+			continue;
+		}
+		/* the system logger is not flooded */
+		if ((info->deviceType == TTYDEVICE_syslog) && (devlog < EOK)) {
+			fprintf(s_report, "{\"bench\":\"skipped\",\"device\":\"%s\",\"reason\":\"syslog transport not redirected\"}\n", info->deviceName);
+			continue;
+		}
+		for (threads = 1; threads <= maxThreads; threads = (threads < maxThreads) ? maxThreads : threads + 1) {
+			for (op = 0; op < BENCH_OP_CNT; op++) {
+				lib_ttyportmux_bench__run(op, info->deviceName, threads, calls);
+			}
+		}
+		lib_ttyportmux_bench__allocs(info->deviceName, calls);
+	}
+
+	if (lib_ttyportmux_bench__map_info(TTYDEVICE_unix) == EOK) {
+		lib_ttyportmux_bench__getline(calls);
+	}
+	lib_ttyportmux_bench__format(calls);
+
+	lib_ttyportmux__cleanup();
+	lib_ttyportmux_bench__restore_stdout();
+	lib_ttyportmux_bench__devlog_close();
+	fclose(s_report);
+	return EXIT_SUCCESS;
+}
+
+/* *******************************************************************
+ * static function definitions
+ * ******************************************************************/
+
+static uint64_t lib_ttyportmux_bench__now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+static void* lib_ttyportmux_bench__worker(void *_arg)
+{
+	struct bench_worker *worker = (struct bench_worker*)_arg;
+	struct bench_run *run = worker->run;
+	unsigned int i;
+
+	pthread_barrier_wait(&run->barrier);
+	worker->start = lib_ttyportmux_bench__now();
+	switch (run->op) {
+		case BENCH_OP_print:
+			for (i = 0; i < run->calls; i++) {
+				lib_ttyportmux__print(TTYSTREAM_info, "bench %u %s\n", i, "print");
+			}
+			break;
+		case BENCH_OP_vprint:
+			for (i = 0; i < run->calls; i++) {
+				lib_ttyportmux_bench__vprint("bench %u %s\n", i, "vprint");
+			}
+			break;
+		case BENCH_OP_putchar:
+			for (i = 0; i < run->calls; i++) {
+				lib_ttyportmux__putchar(TTYSTREAM_info, ((i & 63) == 63) ? '\n' : 'x');
+			}
+			break;
+		default:
+			break;
+	}
+	worker->end = lib_ttyportmux_bench__now();
+	return NULL;
+}
+
+static int lib_ttyportmux_bench__vprint(const char *_format, ...)
+{
+	int ret;
+	va_list ap;
+
+	va_start(ap, _format);
+	ret = lib_ttyportmux__vprint(TTYSTREAM_info, _format, ap);
+	va_end(ap);
+	return ret;
+}
+
+/* ************************************************************************//**
+ * \brief	Timed run of _threads threads with _calls calls each
+ *
+ * The time is taken from the first thread leaving the start barrier to the
+ * last thread finishing its calls. Records still queued in an async ring
+ * are not included.
+ * ****************************************************************************/
+static void lib_ttyportmux_bench__run(enum bench_op _op, const char *_device, unsigned int _threads, unsigned int _calls)
+{
+	struct bench_worker worker[M_BENCH_THREADS_MAX];
+	struct bench_run run = { .op = _op, .calls = _calls };
+	uint64_t start = UINT64_MAX, end = 0, elapsed, total;
+	unsigned int i;
+
+	pthread_barrier_init(&run.barrier, NULL, _threads);
+	for (i = 0; i < _threads; i++) {
+		worker[i].run = &run;
+		pthread_create(&worker[i].thread, NULL, &lib_ttyportmux_bench__worker, &worker[i]);
+	}
+
+	for (i = 0; i < _threads; i++) {
+		pthread_join(worker[i].thread, NULL);
+		start = (worker[i].start < start) ? worker[i].start : start;
+		end = (worker[i].end > end) ? worker[i].end : end;
+	}
+	pthread_barrier_destroy(&run.barrier);
+	elapsed = (end > start) ? (end - start) : 1;
+
+	total = (uint64_t)_calls * _threads;
+	fprintf(s_report, "{\"bench\":\"%s\",\"device\":\"%s\",\"mode\":\"%s\",\"sink\":\"%s\",\"threads\":%u,\"calls\":%llu,"
+			"\"elapsed_ns\":%llu,\"ns_per_call\":%.1f,\"calls_per_sec\":%.0f}\n",
+			s_opName[_op], _device, s_mode, s_sink, _threads, (unsigned long long)total, (unsigned long long)elapsed,
+			((double)elapsed * _threads) / (double)total, ((double)total * 1e9) / (double)elapsed);
+	fflush(s_report);
+}
+
+/* ************************************************************************//**
+ * \brief	Timed read of _calls lines through lib_ttyportmux__getline
+ *
+ * Stdin is replaced by a temporary file with the prepared lines.
+ * ****************************************************************************/
+static void lib_ttyportmux_bench__getline(unsigned int _calls)
+{
+	char *line;
+	size_t n = M_BENCH_LINE_SIZE;
+	uint64_t start, elapsed;
+	unsigned int i;
+	FILE *input;
+
+	input = tmpfile();
+	if (input == NULL) {
+		return;
+	}
+	for (i = 0; i < _calls; i++) {
+		fprintf(input, "bench line %u of the getline read path\n", i);
+	}
+	fflush(input);
+	rewind(input);
+
+	if (dup2(fileno(input), STDIN_FILENO) < 0) {
+		fclose(input);
+		return;
+	}
+	clearerr(stdin);
+	fseek(stdin, 0, SEEK_SET);
+
+	line = (char*)malloc(n);
+	if (line == NULL) {
+		fclose(input);
+		return;
+	}
+
+	start = lib_ttyportmux_bench__now();
+	for (i = 0; i < _calls; i++) {
+		lib_ttyportmux__getline(TTYSTREAM_info, line, &n);
+	}
+	elapsed = lib_ttyportmux_bench__now() - start;
+
+	fprintf(s_report, "{\"bench\":\"getline\",\"device\":\"TTYDEVICE_unix\",\"mode\":\"%s\",\"sink\":\"file\",\"threads\":1,\"calls\":%u,"
+			"\"elapsed_ns\":%llu,\"ns_per_call\":%.1f,\"calls_per_sec\":%.0f}\n",
+			s_mode, _calls, (unsigned long long)elapsed, (double)elapsed / _calls, ((double)_calls * 1e9) / (double)elapsed);
+	fflush(s_report);
+
+	free(line);
+	fclose(input);
+}
+
+/* ************************************************************************//**
+ * \brief	Map of TTYSTREAM_info to a single ttydevice type
+ * ****************************************************************************/
+static int lib_ttyportmux_bench__map_info(enum ttyDeviceType _deviceType)
+{
+	struct ttyStreamMap map[TTYSTREAM_CNT];
+	int ret;
+
+	ret = lib_ttyportmux__get_stream_mapping(&map[0], sizeof(map));
+	if (ret < EOK) {
+		return ret;
+	}
+
+	map[TTYSTREAM_info].deviceType = _deviceType;
+	map[TTYSTREAM_info].deviceMask = 0;
+	return lib_ttyportmux__set_stream_mapping(&map[0], sizeof(map));
+}
+
+/* ************************************************************************//**
+ * \brief	Redirect of stdout to /dev/null or to a pipe drained by a thread
+ * ****************************************************************************/
+static int lib_ttyportmux_bench__redirect_stdout(const char *_sink)
+{
+	int fd[2];
+
+	fflush(stdout);
+	if (strcmp(_sink, "null") == 0) {
+		fd[1] = open("/dev/null", O_WRONLY);
+		if (fd[1] < 0) {
+			return convert_std_errno(errno);
+		}
+	}
+	else if (strcmp(_sink, "pipe") == 0) {
+		if (pipe(fd) < 0) {
+			return convert_std_errno(errno);
+		}
+		s_pipeDrain.fd = fd[0];
+		pthread_create(&s_pipeDrain.thread, NULL, &lib_ttyportmux_bench__drain, &s_pipeDrain);
+	}
+	else {
+		return -ESTD_INVAL;
+	}
+
+	dup2(fd[1], STDOUT_FILENO);
+	close(fd[1]);
+	return EOK;
+}
+
+/* ************************************************************************//**
+ * \brief	Return of stdout to the report, the drain of a pipe reads to its
+ * 			end and is joined
+ * ****************************************************************************/
+static void lib_ttyportmux_bench__restore_stdout(void)
+{
+	fflush(stdout);
+	fflush(s_report);
+	dup2(fileno(s_report), STDOUT_FILENO);
+
+	if (s_pipeDrain.fd < 0) {
+		return;
+	}
+
+	pthread_join(s_pipeDrain.thread, NULL);
+	close(s_pipeDrain.fd);
+	s_pipeDrain.fd = -1;
+}
+
+/* ************************************************************************//**
+ * \brief	Bind of the private datagram socket the syslog port writes to
+ *
+ * Only the native syslog port can be redirected. vsyslog() always writes
+ * to the system logger, the syslog runs are skipped then.
+ *
+ * \return	EOK if the syslog port is redirected, or negative errno value
+ * ****************************************************************************/
+static int lib_ttyportmux_bench__devlog_open(void)
+{
+#if defined(M_TTY_PORT_SYSLOG_NATIVE)
+	struct sockaddr_un addr;
+	int fd, len;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	len = snprintf(&addr.sun_path[0], sizeof(addr.sun_path), M_BENCH_DEVLOG_PRIVATE, (int)getpid());
+	if ((len < 0) || ((size_t)len >= sizeof(addr.sun_path))) {
+		return -ESTD_INVAL;
+	}
+
+	fd = socket(AF_UNIX, SOCK_DGRAM, 0);
+	if (fd < 0) {
+		return convert_std_errno(errno);
+	}
+
+	if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+		close(fd);
+		return convert_std_errno(errno);
+	}
+
+	memcpy(&s_devlogPath[0], &addr.sun_path[0], (size_t)len + 1);
+	setenv("TTYPORTMUX_SYSLOG_SOCKET", &s_devlogPath[0], 1);
+
+	s_devlogDrain.fd = fd;
+	pthread_create(&s_devlogDrain.thread, NULL, &lib_ttyportmux_bench__drain, &s_devlogDrain);
+	return EOK;
+#else
+	return -ESTD_NOSYS;
+#endif
+}
+
+static void lib_ttyportmux_bench__devlog_close(void)
+{
+	if (s_devlogDrain.fd < 0) {
+		return;
+	}
+
+	shutdown(s_devlogDrain.fd, SHUT_RDWR);
+	pthread_cancel(s_devlogDrain.thread);
+	pthread_join(s_devlogDrain.thread, NULL);
+	close(s_devlogDrain.fd);
+	unlink(&s_devlogPath[0]);
+}
+
+static void* lib_ttyportmux_bench__drain(void *_arg)
+{
+	struct bench_drain *drain = (struct bench_drain*)_arg;
+	char buf[4096];
+
+	while (read(drain->fd, &buf[0], sizeof(buf)) > 0);
+	return NULL;
+}
+
+/* ************************************************************************//**
+ * \brief	Heap calls of the process per message
+ *
+ * A first message takes the scratch arena of the thread, the following
+ * messages are counted without and with the message prefix and include
+ * messages exceeding the scratch arena.
+ * ****************************************************************************/
+static void lib_ttyportmux_bench__allocs(const char *_device, unsigned int _calls)
+{
+	static const char * const name[2] = { "allocs", "allocs_prefix" };
+	char longArg[4096];
+	unsigned long long count;
+	unsigned int i, run;
+
+	memset(&longArg[0], 'x', sizeof(longArg) - 1);
+	longArg[sizeof(longArg) - 1] = '\0';
+
+	for (run = 0; run < 2; run++) {
+		lib_ttyportmux__set_prefix((run == 0) ? 0 : M_TTYPREFIX_ALL);
+		lib_ttyportmux__print(TTYSTREAM_info, "bench warmup %u\n", run);
+
+		atomic_store(&s_allocCount, 0);
+		atomic_store(&s_allocCounting, 1);
+		for (i = 0; i < _calls; i++) {
+			if ((i & 1023) == 1023) {
+				lib_ttyportmux__print(TTYSTREAM_info, "bench %u %s\n", i, &longArg[0]);
+			}
+			else if (i & 1) {
+				lib_ttyportmux_bench__vprint("bench %u %s %f\n", i, "vprint", (double)i);
+			}
+			else {
+				lib_ttyportmux__print(TTYSTREAM_info, "bench %u %s\n", i, "print");
+			}
+		}
+		atomic_store(&s_allocCounting, 0);
+		count = atomic_load(&s_allocCount);
+
+		fprintf(s_report, "{\"bench\":\"%s\",\"device\":\"%s\",\"mode\":\"%s\",\"sink\":\"%s\",\"calls\":%u,"
+				"\"allocs\":%llu,\"allocs_per_call\":%.3f}\n",
+				name[run], _device, s_mode, s_sink, _calls, count, (double)count / (double)_calls);
+		fflush(s_report);
+	}
+	lib_ttyportmux__set_prefix(0);
+}
+
+/* ************************************************************************//**
+ * \brief	Formatting of typical messages by vsnprintf of the c-runtime,
+ * 			by mini_vsnprintf and by tty_portmux_fmt__vformat
+ *
+ * The formats are restricted to the conversions supported by mini_printf.
+ * ****************************************************************************/
+static void lib_ttyportmux_bench__format(unsigned int _calls)
+{
+	static const char * const name[3] = { "fmt_str", "fmt_int", "fmt_hex" };
+	char buf[M_BENCH_LINE_SIZE];
+	uint64_t start, elapsed;
+	unsigned int i, j, sum;
+	enum bench_fmt fmt;
+
+	for (j = 0; j < 3; j++) {
+		for (fmt = 0; fmt < BENCH_FMT_CNT; fmt++) {
+			sum = 0;
+			start = lib_ttyportmux_bench__now();
+			for (i = 0; i < _calls; i++) {
+				switch (j) {
+					case 0:
+						sum += (unsigned int)lib_ttyportmux_bench__format_one(fmt, &buf[0], sizeof(buf), "bench %s: %s\n", "format", "a message of the bench");
+						break;
+					case 1:
+						sum += (unsigned int)lib_ttyportmux_bench__format_one(fmt, &buf[0], sizeof(buf), "bench %u %d %5d %s\n", i, -(int)i, (int)(i & 0xfff), "int");
+						break;
+					default:
+						sum += (unsigned int)lib_ttyportmux_bench__format_one(fmt, &buf[0], sizeof(buf), "reg 0x%08x = 0x%x %c\n", i * 2654435761U, i, 'h');
+						break;
+				}
+			}
+			elapsed = lib_ttyportmux_bench__now() - start;
+
+			fprintf(s_report, "{\"bench\":\"%s\",\"formatter\":\"%s\",\"calls\":%u,\"bytes\":%u,"
+					"\"elapsed_ns\":%llu,\"ns_per_call\":%.1f,\"calls_per_sec\":%.0f}\n",
+					name[j], s_fmtName[fmt], _calls, sum, (unsigned long long)elapsed,
+					(double)elapsed / _calls, ((double)_calls * 1e9) / (double)elapsed);
+			fflush(s_report);
+		}
+	}
+}
+
+static int lib_ttyportmux_bench__format_one(enum bench_fmt _fmt, char *_buf, size_t _size, const char *_format, ...)
+{
+	va_list ap;
+	int ret;
+
+	va_start(ap, _format);
+	switch (_fmt) {
+		case BENCH_FMT_glibc: ret = vsnprintf(_buf, _size, _format, ap); break;
+		case BENCH_FMT_mini_printf: ret = mini_vsnprintf(_buf, (unsigned int)_size, _format, ap); break;
+		default: ret = tty_portmux_fmt__vformat(_buf, _size, _format, ap); break;
+	}
+	va_end(ap);
+	return ret;
+}
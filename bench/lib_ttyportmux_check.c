@@ -0,0 +1,1121 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal 
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* *******************************************************************
+ * includes
+ * ******************************************************************/
+
+/* c -runtime */
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <wchar.h>
+#include <dirent.h>
+#include <sys/wait.h>
+#if defined(M_CHECK_SYSLOG)
+#include <ctype.h>
+#include <syslog.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+/* frame */
+#include <lib_convention__errno.h>
+
+/* project */
+#include "lib_ttyportmux.h"
+#include "lib_ttyportmux_memory.h"
+#include "tty_portmux_fmt.h"
+
+/* *******************************************************************
+ * defines
+ * ******************************************************************/
+#define M_CHECK_LINE_SIZE			512
+#define M_CHECK_ERRNO				ENOENT
+#define M_CHECK_SCRATCH_SIZE		256
+#define M_CHECK_RECORD_LEN			3000
+#define M_CHECK_ALLOC_CALLS			4096
+#define M_CHECK_REINIT_RUNS			6
+#define M_CHECK_PRODUCERS			4
+#define M_CHECK_MMAP_RECORD_MAX		512		/*!< M_TTY_PORT_MMAP_RECORD_MAX of the mmap ttydevice */
+#define M_CHECK_MMAP_LONG_LEN		600
+#define M_CHECK_MMAP_RING			"ttyportmux.ring"	/*!< M_TTY_PORT_MMAP_PATH of the mmap ttydevice */
+#define M_CHECK_SYSLOG_SOCKET		"ttyportmux_check.sock"	/*!< bound by the check, given by TTYPORTMUX_SYSLOG_SOCKET */
+#define M_CHECK_SKIP				77		/*!< exit code of a check not supported by the platform, see SKIP_RETURN_CODE */
+
+/* configuration of the native syslog ttydevice */
+#if defined(M_CHECK_SYSLOG)
+	#ifndef M_TTY_PORT_SYSLOG_BATCH
+		#define M_TTY_PORT_SYSLOG_BATCH		1
+	#endif
+	#ifndef M_TTY_PORT_SYSLOG_RFC5424
+		#define M_TTY_PORT_SYSLOG_RFC5424	0
+	#endif
+#endif
+
+/* the sanitizers replace the heap themselves */
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__) && !defined(__SANITIZE_THREAD__)
+	#define M_CHECK_HEAP_COUNT
+#endif
+
+/* *******************************************************************
+ * static function declarations
+ * ******************************************************************/
+static int lib_ttyportmux_check__format(void);
+static int lib_ttyportmux_check__compare(int _render, const char *_format, ...);
+static int lib_ttyportmux_check__windows(const char *_expect, size_t _len, const char *_format, va_list _ap);
+#if defined(M_CHECK_MEMORY)
+static int lib_ttyportmux_check__records(void);
+static int lib_ttyportmux_check__record(const char *_name, int _buffered, const char *_record, size_t _expectLen);
+static int lib_ttyportmux_check__fork(void);
+static int lib_ttyportmux_check__reinit(void);
+static int lib_ttyportmux_check__threads(void);
+#if defined(M_TTYPORTMUX_ASYNC)
+static int lib_ttyportmux_check__reinit_async(void);
+static void* lib_ttyportmux_check__producer(void *_arg);
+#endif
+#if defined(M_TTYPORTMUX_COALESCE)
+static int lib_ttyportmux_check__coalesce(void);
+#endif
+#if defined(M_CHECK_HEAP_COUNT)
+static int lib_ttyportmux_check__allocs(void);
+static int lib_ttyportmux_check__allocs_run(const char *_name, enum ttyMuxMode _mode, unsigned int _prefix);
+static void lib_ttyportmux_check__vprint(const char *_format, ...);
+#endif
+#endif
+#if defined(M_CHECK_MMAP)
+static int lib_ttyportmux_check__mmap(const char *_decoder);
+#endif
+#if defined(M_CHECK_SYSLOG)
+static int lib_ttyportmux_check__syslog(void);
+static int lib_ttyportmux_check__syslog_record(int _fd, int _priority, const char *_tag, const char *_body);
+#endif
+
+/* *******************************************************************
+ * static data
+ * ******************************************************************/
+static const size_t s_checkSize[] = { 0, 1, 8, M_CHECK_LINE_SIZE };
+static const size_t s_checkWindow[] = { 1, 7, 64 };
+#if defined(M_CHECK_MEMORY)
+static char s_record[M_CHECK_RECORD_LEN + 1];
+static char s_capture[2 * M_CHECK_RECORD_LEN];
+#endif
+static atomic_int s_producing = 0;
+static atomic_int s_allocCounting = 0;
+static atomic_ullong s_allocCount = 0;
+
+#if defined(M_CHECK_HEAP_COUNT)
+/* *******************************************************************
+ * heap interposition, counts the allocations of the process while
+ * s_allocCounting is set
+ * ******************************************************************/
+extern void *__libc_malloc(size_t _size);
+extern void *__libc_calloc(size_t _n, size_t _size);
+extern void *__libc_realloc(void *_ptr, size_t _size);
+extern void __libc_free(void *_ptr);
+
+void *malloc(size_t _size)
+{
+	if (atomic_load_explicit(&s_allocCounting, memory_order_relaxed)) {
+		atomic_fetch_add_explicit(&s_allocCount, 1, memory_order_relaxed);
+	}
+	return __libc_malloc(_size);
+}
+
+void *calloc(size_t _n, size_t _size)
+{
+	if (atomic_load_explicit(&s_allocCounting, memory_order_relaxed)) {
+		atomic_fetch_add_explicit(&s_allocCount, 1, memory_order_relaxed);
+	}
+	return __libc_calloc(_n, _size);
+}
+
+void *realloc(void *_ptr, size_t _size)
+{
+	if (atomic_load_explicit(&s_allocCounting, memory_order_relaxed)) {
+		atomic_fetch_add_explicit(&s_allocCount, 1, memory_order_relaxed);
+	}
+	return __libc_realloc(_ptr, _size);
+}
+
+void free(void *_ptr)
+{
+	if ((_ptr != NULL) && atomic_load_explicit(&s_allocCounting, memory_order_relaxed)) {
+		atomic_fetch_add_explicit(&s_allocCount, 1, memory_order_relaxed);
+	}
+	__libc_free(_ptr);
+}
+#endif
+
+/* *******************************************************************
+ * function definition
+ * ******************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Checks of the tty port multiplexer, run by ctest
+ *
+ * Usage: lib_ttyportmux_check format|records|reinit|coalesce|allocs|mmap|syslog [decoder]
+ *
+ * format  : tty_portmux_fmt__vformat, its windows and the pack and render of
+ *           the deferred mode against vsnprintf of the c-runtime
+ * records : records exceeding the formatting buffer, written to the memory
+ *           ttydevice
+ * reinit  : init and cleanup repeated, each init opens the same ttydevices
+ *           and maps the streams to the memory ttydevice, in asynchronous
+ *           mode the cleanup runs while threads print
+ * mmap    : records of the mmap ttydevice read back by the decoder given as
+ *           second argument, ttyportmux_mmap_decode
+ * syslog  : datagrams of the native syslog ttydevice received at a bound
+ *           socket, their header, tag and the batches of sendmmsg()
+ * coalesce: repeats of a quiet stream reported in sync mode by the next
+ *           message of another stream
+ * allocs  : no heap calls of the process per message after the warm-up,
+ *           requires the heap interposition of glibc without sanitizer
+ *
+ * \return	EXIT_SUCCESS if all checks passed, M_CHECK_SKIP if the check is
+ * 			not supported
+ * ****************************************************************************/
+int main(int argc, char *argv[])
+{
+	int fails;
+
+	if ((argc < 2) || (argc > 3)) {
+		fprintf(stderr, "usage: %s format|records|reinit|coalesce|allocs|mmap|syslog [decoder]\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (strcmp(argv[1], "format") == 0) {
+		fails = lib_ttyportmux_check__format();
+	}
+#if defined(M_CHECK_MEMORY)
+	else if (strcmp(argv[1], "records") == 0) {
+		fails = lib_ttyportmux_check__records();
+	}
+	else if (strcmp(argv[1], "reinit") == 0) {
+		fails = lib_ttyportmux_check__reinit();
+#if defined(M_TTYPORTMUX_ASYNC)
+		fails += lib_ttyportmux_check__reinit_async();
+#endif
+	}
+	else if (strcmp(argv[1], "coalesce") == 0) {
+#if defined(M_TTYPORTMUX_COALESCE)
+		fails = lib_ttyportmux_check__coalesce();
+#else
+		printf("%s: not built\n", argv[1]);
+		return M_CHECK_SKIP;
+#endif
+	}
+	else if (strcmp(argv[1], "allocs") == 0) {
+#if defined(M_CHECK_HEAP_COUNT)
+		fails = lib_ttyportmux_check__allocs();
+#else
+		printf("%s: heap calls are not counted in this build\n", argv[1]);
+		return M_CHECK_SKIP;
+#endif
+	}
+#endif
+#if defined(M_CHECK_MMAP)
+	else if ((strcmp(argv[1], "mmap") == 0) && (argc == 3)) {
+		fails = lib_ttyportmux_check__mmap(argv[2]);
+	}
+#endif
+#if defined(M_CHECK_SYSLOG)
+	else if (strcmp(argv[1], "syslog") == 0) {
+		fails = lib_ttyportmux_check__syslog();
+	}
+#endif
+	else {
+		fprintf(stderr, "unknown check %s\n", argv[1]);
+		return EXIT_FAILURE;
+	}
+
+	printf("%s: %d failures\n", argv[1], fails);
+	return (fails == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* *******************************************************************
+ * static function definitions
+ * ******************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Formatting of the conversions of the fast path, of the snprintf
+ * 			fallback and of unknown conversions
+ *
+ * The arguments behind a wide, "%m" or unknown conversion must still be
+ * formatted from the right position of the argument list.
+ *
+ * \return	number of failed comparisons
+ * ****************************************************************************/
+static int lib_ttyportmux_check__format(void)
+{
+	int fails = 0, dn;
+
+	fails += lib_ttyportmux_check__compare(1, "plain text");
+	fails += lib_ttyportmux_check__compare(1, "%d %i %u %x %X", 0, -1, 4000000000u, 0xdeadbeefu, 0xabcu);
+	fails += lib_ttyportmux_check__compare(1, "%ld %lu %lx %lld %jd %zu %td", (long)LONG_MIN, (unsigned long)ULONG_MAX, 0x12345678ul, -5ll, (intmax_t)-99, (size_t)12345, (ptrdiff_t)-7);
+	fails += lib_ttyportmux_check__compare(1, "%hd %hu %hhd %hhu %hx", 70000, 70000, 300, -1, 0x1ff);
+	fails += lib_ttyportmux_check__compare(1, "[%5d][%-5d|][%05d][%+d][% d][%.3d][%8.3d][%.0d]", 42, 42, -42, 42, 42, 5, -5, 0);
+	fails += lib_ttyportmux_check__compare(1, "[%#x][%#X][%#08x][%#.5x][%08X]", 255, 255, 255, 255, 0xab);
+	fails += lib_ttyportmux_check__compare(1, "[%s][%10s][%-10s|][%.2s][%s][%.3s]", "hello", "hi", "hi", "hello", (char*)NULL, (char*)NULL);
+	fails += lib_ttyportmux_check__compare(1, "[%c][%3c][%%][%p][%p][%20p]", 'x', 'y', (void*)0x1234, (void*)NULL, (void*)0xabcdef);
+	fails += lib_ttyportmux_check__compare(1, "[%*d][%-*d|][%.*d][%*.*s]", 6, 3, 6, 3, 4, 7, 8, 2, "abcdef");
+	fails += lib_ttyportmux_check__compare(1, "[%o][%#o][%5.2f][%e][%g][%Lf][%a]", 8, 8, 3.14159, 1e10, 0.0001, (long double)2.5, 1.0);
+	fails += lib_ttyportmux_check__compare(1, "a%nb %d", &dn, 7);
+
+	/* wide conversions by the snprintf fallback, the following arguments stay aligned */
+	fails += lib_ttyportmux_check__compare(1, "%ls n=%d %s", L"wide", 42, "end");
+	fails += lib_ttyportmux_check__compare(1, "[%10ls][%-10ls|][%.2ls][%*ls][%.*ls] %d", L"abc", L"abc", L"abcdef", 6, L"ab", 3, L"abcdef", 5);
+	fails += lib_ttyportmux_check__compare(1, "[%ls][%S] %u", (wchar_t*)NULL, L"upper", 9u);
+	fails += lib_ttyportmux_check__compare(1, "[%lc][%3lc][%C] %s", (wint_t)L'q', (wint_t)L'r', (wint_t)L's', "end");
+	fails += lib_ttyportmux_check__compare(1, "%ls %d", L"été", 1);
+
+	/* "%m" is the message of errno at the time of the call */
+	fails += lib_ttyportmux_check__compare(1, "open: %m %d", 3);
+	fails += lib_ttyportmux_check__compare(1, "[%30m][%-30m|][%.4m] %s", "end");
+
+	/* unknown conversions, the whole message is formatted by vsnprintf */
+	fails += lib_ttyportmux_check__compare(0, "bad %y here %d %s", 5, "end");
+	fails += lib_ttyportmux_check__compare(0, "%d trailing %", 5);
+	fails += lib_ttyportmux_check__compare(0, "%s %ls %k %d", "str", L"wide", 7);
+
+	return fails;
+}
+
+/* ************************************************************************//**
+ * \brief	Comparison of a format with vsnprintf at several buffer sizes
+ *
+ * \param	_render	: non zero also compares the windows and the pack and
+ * 					  render of the deferred mode, which stop at an unknown
+ * 					  conversion
+ * \return	number of failed comparisons
+ * ****************************************************************************/
+static int lib_ttyportmux_check__compare(int _render, const char *_format, ...)
+{
+	char expect[M_CHECK_LINE_SIZE], result[M_CHECK_LINE_SIZE], rec[2 * M_CHECK_LINE_SIZE];
+	size_t i, len;
+	int fails = 0, expectRet, resultRet, recLen;
+	va_list ap, ap2;
+
+	for (i = 0; i < (sizeof(s_checkSize) / sizeof(s_checkSize[0])); i++) {
+		memset(&expect[0], 'A', sizeof(expect));
+		memset(&result[0], 'A', sizeof(result));
+
+		va_start(ap, _format);
+		va_copy(ap2, ap);
+		errno = M_CHECK_ERRNO;
+		expectRet = vsnprintf(&expect[0], s_checkSize[i], _format, ap);
+		errno = M_CHECK_ERRNO;
+		resultRet = tty_portmux_fmt__vformat(&result[0], s_checkSize[i], _format, ap2);
+		va_end(ap2);
+		va_end(ap);
+
+		if ((expectRet < 0) || (resultRet < 0)) {
+			if ((expectRet < 0) != (resultRet < 0)) {
+				fprintf(stderr, "FAIL vformat size %zu \"%s\": c-runtime %d, builtin %d\n", s_checkSize[i], _format, expectRet, resultRet);
+				fails++;
+			}
+			continue;
+		}
+
+		if ((expectRet != resultRet) || (memcmp(&expect[0], &result[0], sizeof(expect)) != 0)) {
+			fprintf(stderr, "FAIL vformat size %zu \"%s\": c-runtime %d \"%.*s\", builtin %d \"%.*s\"\n", s_checkSize[i], _format,
+					expectRet, (s_checkSize[i] > 0) ? (int)sizeof(expect) : 0, &expect[0],
+					resultRet, (s_checkSize[i] > 0) ? (int)sizeof(result) : 0, &result[0]);
+			fails++;
+		}
+	}
+
+	if (!_render) {
+		return fails;
+	}
+
+	va_start(ap, _format);
+	va_copy(ap2, ap);
+	errno = M_CHECK_ERRNO;
+	expectRet = vsnprintf(&expect[0], sizeof(expect), _format, ap);
+	errno = M_CHECK_ERRNO;
+	recLen = tty_portmux_fmt__pack(&rec[0], sizeof(rec), _format, ap2);
+	va_end(ap2);
+	va_end(ap);
+
+	if (expectRet < 0) {
+		return fails;
+	}
+
+	va_start(ap, _format);
+	fails += lib_ttyportmux_check__windows(&expect[0], (size_t)expectRet, _format, ap);
+	va_end(ap);
+
+	/* errno differs at the time of the rendering */
+	errno = 0;
+	len = tty_portmux_fmt__render(&result[0], sizeof(result), &rec[0], (recLen < 0) ? 0 : (size_t)recLen);
+	if ((len != (size_t)expectRet) || (strcmp(&expect[0], &result[0]) != 0)) {
+		fprintf(stderr, "FAIL render \"%s\": c-runtime \"%s\", builtin \"%s\"\n", _format, &expect[0], &result[0]);
+		fails++;
+	}
+	return fails;
+}
+
+/* ************************************************************************//**
+ * \brief	Reassembly of a message from its windows of several sizes
+ *
+ * \return	number of failed comparisons
+ * ****************************************************************************/
+static int lib_ttyportmux_check__windows(const char *_expect, size_t _len, const char *_format, va_list _ap)
+{
+	char result[M_CHECK_LINE_SIZE];
+	size_t i, offset, window;
+	int fails = 0, ret;
+	va_list ap;
+
+	for (i = 0; i < (sizeof(s_checkWindow) / sizeof(s_checkWindow[0])); i++) {
+		memset(&result[0], 'A', sizeof(result));
+		for (offset = 0; offset < _len; offset += window) {
+			window = ((_len - offset) < s_checkWindow[i]) ? (_len - offset) : s_checkWindow[i];
+			va_copy(ap, _ap);
+			errno = M_CHECK_ERRNO;
+			ret = tty_portmux_fmt__vformat_at(&result[offset], window, offset, _format, ap);
+			va_end(ap);
+			if (ret != (int)_len) {
+				break;
+			}
+		}
+
+		if ((offset < _len) || (memcmp(_expect, &result[0], _len) != 0) || (result[_len] != 'A')) {
+			fprintf(stderr, "FAIL windows of %zu \"%s\": c-runtime \"%.*s\", builtin \"%.*s\"\n", s_checkWindow[i], _format,
+					(int)_len, _expect, (int)_len, &result[0]);
+			fails++;
+		}
+	}
+	return fails;
+}
+
+#if defined(M_CHECK_MEMORY)
+/* ************************************************************************//**
+ * \brief	Records exceeding the formatting buffer
+ *
+ * Without a prefix the record is formatted by the driver and written
+ * completely. A prefixed record is cut to the formatting buffer, it keeps
+ * its newline and is counted as truncated. The thread id of the prefix
+ * is the one of the child after a fork.
+ *
+ * \return	number of failed checks
+ * ****************************************************************************/
+static int lib_ttyportmux_check__records(void)
+{
+	struct ttyStreamMap map[TTYSTREAM_CNT];
+	struct ttyMuxConfig config = M_TTYMUX_CONFIG_DEFAULT;
+	unsigned int i;
+	int fails = 0, ret;
+
+	for (i = 0; i < TTYSTREAM_CNT; i++) {
+		map[i] = (struct ttyStreamMap)M_STREAM_MAPPING_ENTRY(TTYDEVICE_memory);
+		map[i].streamType = (enum ttyStreamType)i;
+	}
+	config.scratchSize = M_CHECK_SCRATCH_SIZE;
+
+	ret = lib_ttyportmux__init_ext(&map[0], sizeof(map), &config);
+	if (ret < EOK) {
+		fprintf(stderr, "FAIL init %d\n", ret);
+		return 1;
+	}
+
+	memset(&s_record[0], 'r', M_CHECK_RECORD_LEN - 1);
+	memcpy(&s_record[M_CHECK_RECORD_LEN - 6], "<end>\n", 6);
+	s_record[M_CHECK_RECORD_LEN] = '\0';
+
+	fails += lib_ttyportmux_check__record("driver", 0, &s_record[0], M_CHECK_RECORD_LEN);
+	if (lib_ttyportmux__set_prefix(M_TTYPREFIX_STREAM) == EOK) {
+		fails += lib_ttyportmux_check__record("prefixed", 0, &s_record[0], M_CHECK_SCRATCH_SIZE - 1);
+		fails += lib_ttyportmux_check__record("prefixed buffer", 1, &s_record[0], M_CHECK_SCRATCH_SIZE - 1);
+		fails += lib_ttyportmux_check__fork();
+	}
+
+	lib_ttyportmux__cleanup();
+	return fails;
+}
+
+/* ************************************************************************//**
+ * \brief	Write of a record to the memory ttydevice and check of the
+ * 			captured bytes
+ *
+ * \param	_buffered	: non zero writes the record by print_buf
+ * \param	_expectLen	: length of the captured record, a shorter one was cut
+ * \return	number of failed checks
+ * ****************************************************************************/
+static int lib_ttyportmux_check__record(const char *_name, int _buffered, const char *_record, size_t _expectLen)
+{
+	struct ttyStats stats;
+	size_t recordLen, tail;
+	int len;
+
+	recordLen = strlen(_record);
+	lib_ttyportmux_memory__reset();
+	lib_ttyportmux__reset_stats();
+	if (_buffered) {
+		lib_ttyportmux__print_buf(TTYSTREAM_info, _record, recordLen);
+	}
+	else {
+		lib_ttyportmux__print(TTYSTREAM_info, "%s", _record);
+	}
+
+	len = lib_ttyportmux_memory__get(&s_capture[0], sizeof(s_capture));
+	if ((len < 0) || ((size_t)len != _expectLen) || (s_capture[len - 1] != '\n')) {
+		fprintf(stderr, "FAIL %s record: %d bytes, expected %zu ending with a newline\n", _name, len, _expectLen);
+		return 1;
+	}
+
+	/* a cut record is compared at its kept newline, a complete one as a whole */
+	tail = (_expectLen < recordLen) ? 1 : recordLen;
+	if (memcmp(&s_capture[_expectLen - tail], &_record[recordLen - tail], tail) != 0) {
+		fprintf(stderr, "FAIL %s record: content differs\n", _name);
+		return 1;
+	}
+
+#if defined(M_TTYPORTMUX_STATS)
+	lib_ttyportmux__get_stats(TTYSTREAM_info, &stats);
+	if (stats.truncated != ((_expectLen < recordLen) ? 1u : 0u)) {
+		fprintf(stderr, "FAIL %s record: %llu truncated\n", _name, (unsigned long long)stats.truncated);
+		return 1;
+	}
+#else
+	(void)stats;
+#endif
+	return 0;
+}
+
+/* ************************************************************************//**
+ * \brief	Thread id prefix of a record written by the child of a fork
+ *
+ * The parent requests its thread id before the fork, the single thread
+ * of the child has the pid of the child as its id.
+ *
+ * \return	number of failed checks
+ * ****************************************************************************/
+static int lib_ttyportmux_check__fork(void)
+{
+	char expect[32];
+	pid_t pid;
+	int len, status;
+
+	lib_ttyportmux__set_prefix(M_TTYPREFIX_TID);
+	lib_ttyportmux__print(TTYSTREAM_info, "parent\n");
+
+	pid = fork();
+	if (pid == 0) {
+		snprintf(&expect[0], sizeof(expect), "[%d] child\n", (int)getpid());
+		lib_ttyportmux_memory__reset();
+		lib_ttyportmux__print(TTYSTREAM_info, "child\n");
+		len = lib_ttyportmux_memory__get(&s_capture[0], sizeof(s_capture));
+		if ((len < 0) || ((size_t)len != strlen(&expect[0])) || (memcmp(&s_capture[0], &expect[0], (size_t)len) != 0)) {
+			fprintf(stderr, "FAIL fork: \"%.*s\", expected \"%s\"\n", (len < 0) ? 0 : len, &s_capture[0], &expect[0]);
+			_exit(EXIT_FAILURE);
+		}
+		_exit(EXIT_SUCCESS);
+	}
+
+	lib_ttyportmux__set_prefix(0);
+	if ((pid < 0) || (waitpid(pid, &status, 0) != pid) || !WIFEXITED(status) || (WEXITSTATUS(status) != EXIT_SUCCESS)) {
+		fprintf(stderr, "FAIL fork: child %d failed\n", (int)pid);
+		return 1;
+	}
+	return 0;
+}
+
+/* ************************************************************************//**
+ * \brief	Repeated init and cleanup
+ *
+ * Each cleanup closes the ttydevices, so every init opens the devices of
+ * the first one again and a message reaches the memory ttydevice. The
+ * runs alternate the size and the pool of the scratch arenas, a prefixed
+ * record is cut to the arena of the current init.
+ *
+ * \return	number of failed checks
+ * ****************************************************************************/
+static int lib_ttyportmux_check__reinit(void)
+{
+	struct ttyStreamMap map[TTYSTREAM_CNT];
+	struct ttyMuxConfig config = M_TTYMUX_CONFIG_DEFAULT;
+	struct list_node *node;
+	struct ttyStreamInfo info;
+	struct ttyStats stats;
+	unsigned int i, run;
+	int fails = 0, ret, len, devices = 0;
+	char expect[32];
+
+	memset(&s_record[0], 'r', M_CHECK_RECORD_LEN - 1);
+	memcpy(&s_record[M_CHECK_RECORD_LEN - 6], "<end>\n", 6);
+	s_record[M_CHECK_RECORD_LEN] = '\0';
+
+	for (run = 0; run < M_CHECK_REINIT_RUNS; run++) {
+		for (i = 0; i < TTYSTREAM_CNT; i++) {
+			map[i] = (struct ttyStreamMap)M_STREAM_MAPPING_ENTRY(TTYDEVICE_memory);
+			map[i].streamType = (enum ttyStreamType)i;
+		}
+		config.scratchSize = (size_t)M_CHECK_SCRATCH_SIZE << (run & 1);
+		config.scratchArenas = (run & 2) ? 0 : ((struct ttyMuxConfig)M_TTYMUX_CONFIG_DEFAULT).scratchArenas;
+
+		ret = lib_ttyportmux__init_ext(&map[0], sizeof(map), &config);
+		if (ret < EOK) {
+			fprintf(stderr, "FAIL init %u: %d\n", run, ret);
+			return fails + 1;
+		}
+		lib_ttyportmux__set_prefix(0);
+
+		ret = lib_ttyportmux__ttydevice_count();
+		if (run == 0) {
+			devices = ret;
+		}
+		else if (ret != devices) {
+			fprintf(stderr, "FAIL init %u: %d ttydevices, expected %d\n", run, ret, devices);
+			fails++;
+		}
+
+		if ((map[TTYSTREAM_info].ttydevice == NULL) || (lib_ttyportmux__get_stream_info(&map[TTYSTREAM_info], &info) < EOK) ||
+			(info.deviceType != TTYDEVICE_memory)) {
+			fprintf(stderr, "FAIL init %u: info stream not mapped\n", run);
+			fails++;
+		}
+
+		lib_ttyportmux_memory__reset();
+		lib_ttyportmux__reset_stats();
+		snprintf(&expect[0], sizeof(expect), "run %u\n", run);
+		lib_ttyportmux__print(TTYSTREAM_info, "run %u\n", run);
+		len = lib_ttyportmux_memory__get(&s_capture[0], sizeof(s_capture));
+		if ((len < 0) || (strcmp(&s_capture[0], &expect[0]) != 0)) {
+			fprintf(stderr, "FAIL init %u: \"%s\", expected \"%s\"\n", run, (len < 0) ? "" : &s_capture[0], &expect[0]);
+			fails++;
+		}
+
+#if defined(M_TTYPORTMUX_STATS)
+		/* the deviceIds of each init stay in the range of the counters */
+		for (node = lib_ttyportmux__get_ttydevice_listentry(); node != NULL; node = lib_ttyportmux__get_ttydevice_next(node)) {
+			if (lib_ttyportmux__get_ttydevice_info(node)->deviceType == TTYDEVICE_memory) {
+				break;
+			}
+		}
+		if ((node == NULL) || (lib_ttyportmux__get_ttydevice_stats(node, &stats) < EOK) || (stats.messages != 1)) {
+			fprintf(stderr, "FAIL init %u: message not counted at the memory ttydevice\n", run);
+			fails++;
+		}
+#else
+		(void)node;
+		(void)stats;
+#endif
+
+		/* an arena of the previous init is not used */
+		if (lib_ttyportmux__set_prefix(M_TTYPREFIX_STREAM) == EOK) {
+			fails += lib_ttyportmux_check__record("reinit", 0, &s_record[0], config.scratchSize - 1);
+			lib_ttyportmux__set_prefix(0);
+		}
+
+		lib_ttyportmux__cleanup();
+
+		/* entry of a stream without an opened ttydevice */
+		map[TTYSTREAM_info].ttydevice = NULL;
+		if (lib_ttyportmux__get_stream_info(&map[TTYSTREAM_info], &info) != -ESTD_NODEV) {
+			fprintf(stderr, "FAIL cleanup %u: unresolved stream info\n", run);
+			fails++;
+		}
+
+		if (lib_ttyportmux__print(TTYSTREAM_info, "closed\n") != -EEXEC_NOINIT) {
+			fprintf(stderr, "FAIL cleanup %u: print accepted\n", run);
+			fails++;
+		}
+
+		/* the flusher and maintenance threads of the ttydevices are stopped */
+		ret = lib_ttyportmux_check__threads();
+		if (ret > 1) {
+			fprintf(stderr, "FAIL cleanup %u: %d threads left\n", run, ret);
+			fails++;
+		}
+	}
+	return fails;
+}
+
+/* ************************************************************************//**
+ * \brief	Number of threads of the process
+ *
+ * \return	number of threads, or 0 if /proc is not available
+ * ****************************************************************************/
+static int lib_ttyportmux_check__threads(void)
+{
+	struct dirent *entry;
+	DIR *dir;
+	int count = 0;
+
+	dir = opendir("/proc/self/task");
+	if (dir == NULL) {
+		return 0;
+	}
+	while ((entry = readdir(dir)) != NULL) {
+		if (entry->d_name[0] != '.') {
+			count++;
+		}
+	}
+	closedir(dir);
+	return count;
+}
+
+#if defined(M_TTYPORTMUX_ASYNC)
+/* ************************************************************************//**
+ * \brief	Cleanup of the asynchronous mode while threads print
+ *
+ * The prints of the threads either complete before the cleanup or return
+ * -EEXEC_NOINIT, none may reach the ring after it is freed.
+ *
+ * \return	number of failed checks
+ * ****************************************************************************/
+static int lib_ttyportmux_check__reinit_async(void)
+{
+	struct ttyStreamMap map[TTYSTREAM_CNT];
+	struct ttyMuxConfig config = M_TTYMUX_CONFIG_DEFAULT;
+	pthread_t thread[M_CHECK_PRODUCERS];
+	unsigned int i, run;
+	int fails = 0, ret;
+
+	config.mode = TTYMUX_MODE_async;
+
+	for (run = 0; run < M_CHECK_REINIT_RUNS; run++) {
+		for (i = 0; i < TTYSTREAM_CNT; i++) {
+			map[i] = (struct ttyStreamMap)M_STREAM_MAPPING_ENTRY(TTYDEVICE_memory);
+			map[i].streamType = (enum ttyStreamType)i;
+		}
+
+		ret = lib_ttyportmux__init_ext(&map[0], sizeof(map), &config);
+		if (ret < EOK) {
+			fprintf(stderr, "FAIL async init %u: %d\n", run, ret);
+			return fails + 1;
+		}
+
+		atomic_store(&s_producing, 1);
+		for (i = 0; i < M_CHECK_PRODUCERS; i++) {
+			pthread_create(&thread[i], NULL, &lib_ttyportmux_check__producer, NULL);
+		}
+		usleep(10000);
+
+		lib_ttyportmux__cleanup();
+
+		atomic_store(&s_producing, 0);
+		for (i = 0; i < M_CHECK_PRODUCERS; i++) {
+			pthread_join(thread[i], NULL);
+		}
+	}
+	return fails;
+}
+
+static void* lib_ttyportmux_check__producer(void *_arg)
+{
+	unsigned int i = 0;
+
+	(void)_arg;
+	while (atomic_load(&s_producing)) {
+		lib_ttyportmux__print(TTYSTREAM_info, "producer %u\n", i++);
+	}
+	return NULL;
+}
+#endif
+
+#if defined(M_TTYPORTMUX_COALESCE)
+/* ************************************************************************//**
+ * \brief	Repeats of a stream which went quiet in sync mode
+ *
+ * A change of the mask reports the pending repeats, a stream coalesced
+ * again writes its first message even if it equals the previous one.
+ *
+ * \return	number of failed checks
+ * ****************************************************************************/
+static int lib_ttyportmux_check__coalesce(void)
+{
+	static const char * const expect = "same\nlast message repeated 4 times\nother\n"
+			"last message repeated 2 times\nsame\n";
+	struct ttyStreamMap map[TTYSTREAM_CNT];
+	unsigned int i;
+	int ret, len;
+
+	for (i = 0; i < TTYSTREAM_CNT; i++) {
+		map[i] = (struct ttyStreamMap)M_STREAM_MAPPING_ENTRY(TTYDEVICE_memory);
+		map[i].streamType = (enum ttyStreamType)i;
+	}
+
+	ret = lib_ttyportmux__init(&map[0], sizeof(map));
+	if (ret < EOK) {
+		fprintf(stderr, "FAIL init %d\n", ret);
+		return 1;
+	}
+	lib_ttyportmux__set_prefix(0);
+	lib_ttyportmux__set_stream_coalesce(M_TTYSTREAM_BIT(TTYSTREAM_info), 20);
+	lib_ttyportmux_memory__reset();
+
+	for (i = 0; i < 5; i++) {
+		lib_ttyportmux__print(TTYSTREAM_info, "same\n");
+	}
+	usleep(100000);
+	lib_ttyportmux__print(TTYSTREAM_warning, "other\n");
+
+	lib_ttyportmux__print(TTYSTREAM_info, "same\n");
+	lib_ttyportmux__print(TTYSTREAM_info, "same\n");
+	lib_ttyportmux__set_stream_coalesce(0, 0);
+	lib_ttyportmux__set_stream_coalesce(M_TTYSTREAM_BIT(TTYSTREAM_info), 20);
+	lib_ttyportmux__print(TTYSTREAM_info, "same\n");
+
+	len = lib_ttyportmux_memory__get(&s_capture[0], sizeof(s_capture));
+	lib_ttyportmux__set_stream_coalesce(0, 0);
+	lib_ttyportmux__cleanup();
+
+	if ((len < 0) || (strcmp(&s_capture[0], expect) != 0)) {
+		fprintf(stderr, "FAIL coalesce: \"%s\", expected \"%s\"\n", (len < 0) ? "" : &s_capture[0], expect);
+		return 1;
+	}
+	return 0;
+}
+#endif
+
+#if defined(M_CHECK_HEAP_COUNT)
+/* ************************************************************************//**
+ * \brief	Heap calls of the process per message on the memory ttydevice
+ *
+ * Each run counts the heap calls of M_CHECK_ALLOC_CALLS messages after a
+ * warm-up message, which takes the formatting arena of the thread. The
+ * messages include records exceeding the formatting buffer.
+ *
+ * \return	number of runs with heap calls
+ * ****************************************************************************/
+static int lib_ttyportmux_check__allocs(void)
+{
+	int fails = 0;
+
+	memset(&s_record[0], 'a', M_CHECK_RECORD_LEN - 1);
+	s_record[M_CHECK_RECORD_LEN - 1] = '\0';
+
+	fails += lib_ttyportmux_check__allocs_run("sync", TTYMUX_MODE_sync, 0);
+	fails += lib_ttyportmux_check__allocs_run("sync prefixed", TTYMUX_MODE_sync, M_TTYPREFIX_ALL);
+#if defined(M_TTYPORTMUX_ASYNC)
+	fails += lib_ttyportmux_check__allocs_run("async", TTYMUX_MODE_async, 0);
+	fails += lib_ttyportmux_check__allocs_run("async prefixed", TTYMUX_MODE_async, M_TTYPREFIX_ALL);
+#endif
+	return fails;
+}
+
+/* ************************************************************************//**
+ * \brief	Heap calls of a run in a mode, with or without prefix
+ *
+ * \return	1 if a heap call was counted, 0 otherwise
+ * ****************************************************************************/
+static int lib_ttyportmux_check__allocs_run(const char *_name, enum ttyMuxMode _mode, unsigned int _prefix)
+{
+	struct ttyStreamMap map[TTYSTREAM_CNT];
+	struct ttyMuxConfig config = M_TTYMUX_CONFIG_DEFAULT;
+	unsigned long long count;
+	unsigned int i;
+	int ret;
+
+	for (i = 0; i < TTYSTREAM_CNT; i++) {
+		map[i] = (struct ttyStreamMap)M_STREAM_MAPPING_ENTRY(TTYDEVICE_memory);
+		map[i].streamType = (enum ttyStreamType)i;
+	}
+	config.mode = _mode;
+	config.overflow = TTYMUX_OVERFLOW_block;
+	config.scratchSize = M_CHECK_SCRATCH_SIZE;
+
+	ret = lib_ttyportmux__init_ext(&map[0], sizeof(map), &config);
+	if (ret < EOK) {
+		fprintf(stderr, "FAIL %s: init %d\n", _name, ret);
+		return 1;
+	}
+	lib_ttyportmux__set_prefix(_prefix);
+
+	/* the drain thread of the async mode takes its arena at the first record */
+	lib_ttyportmux__print(TTYSTREAM_info, "warmup %s %f\n", s_record, 1.0);
+	if (_mode == TTYMUX_MODE_async) {
+		usleep(100000);
+	}
+
+	atomic_store(&s_allocCount, 0);
+	atomic_store(&s_allocCounting, 1);
+	for (i = 0; i < M_CHECK_ALLOC_CALLS; i++) {
+		if ((i & 63) == 63) {
+			lib_ttyportmux__print(TTYSTREAM_info, "check %u %s\n", i, s_record);
+		}
+		else if ((i & 63) == 31) {
+			lib_ttyportmux__print_buf(TTYSTREAM_info, s_record, M_CHECK_RECORD_LEN - 1);
+		}
+		else if (i & 1) {
+			lib_ttyportmux_check__vprint("check %u %s %f\n", i, "vprint", (double)i);
+		}
+		else {
+			lib_ttyportmux__print(TTYSTREAM_info, "check %u %s\n", i, "print");
+		}
+	}
+	if (_mode == TTYMUX_MODE_async) {
+		usleep(100000);
+	}
+	atomic_store(&s_allocCounting, 0);
+	count = atomic_load(&s_allocCount);
+	lib_ttyportmux__cleanup();
+
+	if (count > 0) {
+		fprintf(stderr, "FAIL %s: %llu heap calls in %u messages\n", _name, count, M_CHECK_ALLOC_CALLS);
+		return 1;
+	}
+	return 0;
+}
+
+static void lib_ttyportmux_check__vprint(const char *_format, ...)
+{
+	va_list ap;
+
+	va_start(ap, _format);
+	lib_ttyportmux__vprint(TTYSTREAM_info, _format, ap);
+	va_end(ap);
+}
+#endif /* M_CHECK_HEAP_COUNT */
+#endif /* M_CHECK_MEMORY */
+
+#if defined(M_CHECK_MMAP)
+/* ************************************************************************//**
+ * \brief	Records of the mmap ttydevice read back from the ring file
+ *
+ * The second init opens the ring again, the ring of the first one is kept
+ * as <path>.1. A record longer than the ring record is cut, keeps its
+ * newline and is counted as truncated.
+ *
+ * \param	_decoder : path of ttyportmux_mmap_decode
+ * \return	number of failed checks
+ * ****************************************************************************/
+static int lib_ttyportmux_check__mmap(const char *_decoder)
+{
+	static char longRecord[M_CHECK_MMAP_LONG_LEN + 1];
+	static char expect[M_CHECK_MMAP_RECORD_MAX + 64];
+	static char decoded[2 * M_CHECK_MMAP_LONG_LEN];
+	struct ttyStreamMap map[TTYSTREAM_CNT];
+	struct ttyStats stats;
+	char command[512];
+	unsigned int i, run;
+	int fails = 0, ret;
+	size_t len;
+	FILE *fp;
+
+	memset(&longRecord[0], 'm', M_CHECK_MMAP_LONG_LEN);
+
+	for (run = 0; run < 2; run++) {
+		for (i = 0; i < TTYSTREAM_CNT; i++) {
+			map[i] = (struct ttyStreamMap)M_STREAM_MAPPING_ENTRY(TTYDEVICE_mmap);
+			map[i].streamType = (enum ttyStreamType)i;
+		}
+
+		ret = lib_ttyportmux__init(&map[0], sizeof(map));
+		if (ret < EOK) {
+			fprintf(stderr, "FAIL init %u: %d\n", run, ret);
+			return 1;
+		}
+		lib_ttyportmux__set_prefix(0);
+		lib_ttyportmux__reset_stats();
+
+		lib_ttyportmux__print(TTYSTREAM_info, "first %u\n", run);
+		lib_ttyportmux__print(TTYSTREAM_info, "%s\n", &longRecord[0]);
+		lib_ttyportmux__print_buf(TTYSTREAM_info, "last\n", 5);
+
+#if defined(M_TTYPORTMUX_STATS)
+		lib_ttyportmux__get_stats(TTYSTREAM_info, &stats);
+		if (stats.truncated != 1) {
+			fprintf(stderr, "FAIL mmap %u: %llu truncated\n", run, (unsigned long long)stats.truncated);
+			fails++;
+		}
+#else
+		(void)stats;
+#endif
+		lib_ttyportmux__cleanup();
+	}
+
+	len = (size_t)snprintf(&expect[0], sizeof(expect), "first 1\n%.*s\nlast\n", M_CHECK_MMAP_RECORD_MAX - 2, &longRecord[0]);
+
+	snprintf(&command[0], sizeof(command), "%s %s", _decoder, M_CHECK_MMAP_RING);
+	fp = popen(&command[0], "r");
+	if (fp == NULL) {
+		fprintf(stderr, "FAIL mmap: %s not started\n", _decoder);
+		return fails + 1;
+	}
+	ret = (int)fread(&decoded[0], 1, sizeof(decoded) - 1, fp);
+	decoded[ret] = '\0';
+	if ((pclose(fp) != 0) || ((size_t)ret != len) || (memcmp(&decoded[0], &expect[0], len) != 0)) {
+		fprintf(stderr, "FAIL mmap: decoded \"%s\", expected \"%s\"\n", &decoded[0], &expect[0]);
+		fails++;
+	}
+	return fails;
+}
+#endif
+
+#if defined(M_CHECK_SYSLOG)
+/* ************************************************************************//**
+ * \brief	Datagrams of the native syslog ttydevice
+ *
+ * The ttydevice is connected to a socket bound by the check. Each record
+ * carries the RFC 3164 or RFC 5424 header and the tag cached at the open.
+ * With M_TTY_PORT_SYSLOG_BATCH > 1 the records are held back until the
+ * batch is full, an error is sent at once and the cleanup sends the rest.
+ *
+ * \return	number of failed checks
+ * ****************************************************************************/
+static int lib_ttyportmux_check__syslog(void)
+{
+	struct ttyStreamMap map[TTYSTREAM_CNT];
+	struct sockaddr_un addr;
+	char tag[256], host[64], body[32];
+	unsigned int i;
+	int fails = 0, fd, ret;
+
+	fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		fprintf(stderr, "FAIL syslog: socket: %s\n", strerror(errno));
+		return 1;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(&addr.sun_path[0], M_CHECK_SYSLOG_SOCKET);
+	unlink(M_CHECK_SYSLOG_SOCKET);
+	if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+		fprintf(stderr, "FAIL syslog: bind %s: %s\n", M_CHECK_SYSLOG_SOCKET, strerror(errno));
+		close(fd);
+		return 1;
+	}
+	setenv("TTYPORTMUX_SYSLOG_SOCKET", M_CHECK_SYSLOG_SOCKET, 1);
+
+	if (M_TTY_PORT_SYSLOG_RFC5424) {
+		if (gethostname(&host[0], sizeof(host)) != 0) {
+			strcpy(&host[0], "-");
+		}
+		host[sizeof(host) - 1] = '\0';
+		snprintf(&tag[0], sizeof(tag), "%s %s %d - - ", &host[0], program_invocation_short_name, (int)getpid());
+	}
+	else {
+		snprintf(&tag[0], sizeof(tag), "%s[%d]: ", program_invocation_short_name, (int)getpid());
+	}
+
+	for (i = 0; i < TTYSTREAM_CNT; i++) {
+		map[i] = (struct ttyStreamMap)M_STREAM_MAPPING_ENTRY(TTYDEVICE_syslog);
+		map[i].streamType = (enum ttyStreamType)i;
+	}
+
+	ret = lib_ttyportmux__init(&map[0], sizeof(map));
+	if (ret < EOK) {
+		fprintf(stderr, "FAIL syslog: init %d\n", ret);
+		close(fd);
+		unlink(M_CHECK_SYSLOG_SOCKET);
+		return 1;
+	}
+	lib_ttyportmux__set_prefix(0);
+
+	/* a batch is sent by its last record */
+	for (i = 0; i < M_TTY_PORT_SYSLOG_BATCH; i++) {
+		lib_ttyportmux__print(TTYSTREAM_info, "record %u\n", i);
+		if (((i + 1) < M_TTY_PORT_SYSLOG_BATCH) && (recv(fd, &body[0], sizeof(body), MSG_DONTWAIT | MSG_PEEK) >= 0)) {
+			fprintf(stderr, "FAIL syslog: record %u sent before the batch of %d is full\n", i, M_TTY_PORT_SYSLOG_BATCH);
+			fails++;
+		}
+	}
+	for (i = 0; i < M_TTY_PORT_SYSLOG_BATCH; i++) {
+		snprintf(&body[0], sizeof(body), "record %u\n", i);
+		fails += lib_ttyportmux_check__syslog_record(fd, LOG_INFO, &tag[0], &body[0]);
+	}
+
+	/* an error is not held back */
+	lib_ttyportmux__print(TTYSTREAM_error, "urgent\n");
+	fails += lib_ttyportmux_check__syslog_record(fd, LOG_ERR, &tag[0], "urgent\n");
+
+	/* a queued record is sent by the cleanup */
+	lib_ttyportmux__print_buf(TTYSTREAM_warning, "cleanup\n", 8);
+	lib_ttyportmux__cleanup();
+	fails += lib_ttyportmux_check__syslog_record(fd, LOG_WARNING, &tag[0], "cleanup\n");
+
+	if (recv(fd, &body[0], sizeof(body), MSG_DONTWAIT) >= 0) {
+		fprintf(stderr, "FAIL syslog: unexpected record\n");
+		fails++;
+	}
+
+	unsetenv("TTYPORTMUX_SYSLOG_SOCKET");
+	close(fd);
+	unlink(M_CHECK_SYSLOG_SOCKET);
+	return fails;
+}
+
+/* ************************************************************************//**
+ * \brief	Comparison of the next datagram with "<PRI>", the timestamp of
+ * 			the header, _tag and _body
+ *
+ * The timestamp is compared against a pattern: 'a' letter, 'd' digit,
+ * 's' digit or space, 'z' sign of the zone, any other character itself.
+ *
+ * \return	0 if the datagram matches, otherwise 1
+ * ****************************************************************************/
+static int lib_ttyportmux_check__syslog_record(int _fd, int _priority, const char *_tag, const char *_body)
+{
+	const char *stamp = M_TTY_PORT_SYSLOG_RFC5424 ? "dddd-dd-ddTdd:dd:dd.ddddddzdd:dd " : "aaa sd dd:dd:dd ";
+	char rec[M_CHECK_LINE_SIZE], pri[16];
+	size_t len, pos, tagLen;
+	ssize_t n;
+	int match;
+
+	n = recv(_fd, &rec[0], sizeof(rec) - 1, MSG_DONTWAIT);
+	if (n < 0) {
+		fprintf(stderr, "FAIL syslog: \"%s\" not received\n", _body);
+		return 1;
+	}
+	rec[n] = '\0';
+
+	len = (size_t)snprintf(&pri[0], sizeof(pri), M_TTY_PORT_SYSLOG_RFC5424 ? "<%d>1 " : "<%d>", LOG_USER | _priority);
+	match = (strncmp(&rec[0], &pri[0], len) == 0);
+
+	for (pos = 0; match && (stamp[pos] != '\0'); pos++) {
+		char c = rec[len + pos];
+
+		switch (stamp[pos])
+		{
+			case 'a': match = isalpha((unsigned char)c); break;
+			case 'd': match = isdigit((unsigned char)c); break;
+			case 's': match = isdigit((unsigned char)c) || (c == ' '); break;
+			case 'z': match = (c == '+') || (c == '-'); break;
+			default: match = (c == stamp[pos]); break;
+		}
+	}
+	len += pos;
+
+	tagLen = strlen(_tag);
+	match = match && (strncmp(&rec[len], _tag, tagLen) == 0) && (strcmp(&rec[len + tagLen], _body) == 0);
+	if (!match) {
+		fprintf(stderr, "FAIL syslog: \"%s\", expected %s<stamp>%s%s", &rec[0], &pri[0], _tag, _body);
+		return 1;
+	}
+	return 0;
+}
+#endif
@@ -0,0 +1,156 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* *******************************************************************
+ * includes
+ * ******************************************************************/
+
+/* c -runtime */
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+/* frame */
+#include <lib_convention__errno.h>
+
+/* project */
+#include <lib_ttyportmux.hpp>
+#include <lib_ttyportmux_memory.h>
+
+/* *******************************************************************
+ * defines
+ * ******************************************************************/
+#define M_CHECK_CAPTURE_SIZE		(2 * ttyportmux::buffer_size)
+
+/* *******************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ******************************************************************/
+enum class check_color : int { red = 3 };
+
+/* *******************************************************************
+ * static function declarations
+ * ******************************************************************/
+static int lib_ttyportmux_check_cpp__compare(int _ret, const char *_expect, std::size_t _expectLen);
+
+/* *******************************************************************
+ * static data
+ * ******************************************************************/
+static char s_capture[M_CHECK_CAPTURE_SIZE];
+
+/* *******************************************************************
+ * function definition
+ * ******************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Check of the C++ front-end, run by ctest
+ *
+ * Each message is printed by ttyportmux::print into the memory ttydevice
+ * and compared with the expected output.
+ *
+ * \return	EXIT_SUCCESS if all checks passed
+ * ****************************************************************************/
+int main()
+{
+	struct ttyStreamMap map[TTYSTREAM_CNT];
+	std::string str = "string";
+	std::string_view view = "view";
+	const char *none = nullptr;
+	std::string longMsg(ttyportmux::buffer_size + 16, 'l');
+	unsigned int i;
+	int fails = 0, ret;
+
+	for (i = 0; i < TTYSTREAM_CNT; i++) {
+		map[i] = (struct ttyStreamMap)M_STREAM_MAPPING_ENTRY(TTYDEVICE_memory);
+		map[i].streamType = static_cast<enum ttyStreamType>(i);
+	}
+
+	ret = lib_ttyportmux__init(&map[0], sizeof(map));
+	if (ret < EOK) {
+		std::fprintf(stderr, "FAIL init: %d\n", ret);
+		return EXIT_FAILURE;
+	}
+	lib_ttyportmux__set_prefix(0);
+	lib_ttyportmux_memory__reset();
+
+	ret = ttyportmux::print<TTYSTREAM_info>("{{}} {{{}}} }}{{\n", 7);
+	fails += lib_ttyportmux_check_cpp__compare(ret, "{} {7} }{\n", 0);
+
+	ret = ttyportmux::print<TTYSTREAM_info>("{:x} {:X} {:x} {:x}\n", 255u, 0xabcLL, -1, static_cast<unsigned char>(0));
+	fails += lib_ttyportmux_check_cpp__compare(ret, "ff ABC ffffffff 0\n", 0);
+
+	ret = ttyportmux::print<TTYSTREAM_info>("{} {} {} {}\n", LLONG_MIN, LLONG_MAX, ULLONG_MAX, INT_MIN);
+	fails += lib_ttyportmux_check_cpp__compare(ret, "-9223372036854775808 9223372036854775807 18446744073709551615 -2147483648\n", 0);
+
+	ret = ttyportmux::print<TTYSTREAM_info>("{} {} {} {} {} {}\n", "literal", str, view, none, 'c', true);
+	fails += lib_ttyportmux_check_cpp__compare(ret, "literal string view (null) c true\n", 0);
+
+	ret = ttyportmux::print<TTYSTREAM_info>("{} {} {} {}\n", 3.25, static_cast<short>(-5), check_color::red, nullptr);
+	fails += lib_ttyportmux_check_cpp__compare(ret, "3.25 -5 3 (nil)\n", 0);
+
+	ret = ttyportmux::print<TTYSTREAM_warning>("no arguments\n");
+	fails += lib_ttyportmux_check_cpp__compare(ret, "no arguments\n", 0);
+
+	/* a longer message is cut at the buffer of the call site */
+	ret = ttyportmux::print<TTYSTREAM_info>("{}\n", longMsg);
+	fails += lib_ttyportmux_check_cpp__compare(ret, longMsg.c_str(), ttyportmux::buffer_size);
+
+	lib_ttyportmux__cleanup();
+
+	std::printf("cpp: %d failures\n", fails);
+	return (fails == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* *******************************************************************
+ * static function definitions
+ * ******************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Comparison of the captured output with _expect, the capture is
+ * 			reset afterwards
+ *
+ * \param	_ret		: return value of ttyportmux::print
+ * \param	_expect		: expected output
+ * \param	_expectLen	: compared length of _expect, 0 compares all of it
+ * \return	0 if the output matches, otherwise 1
+ * ****************************************************************************/
+static int lib_ttyportmux_check_cpp__compare(int _ret, const char *_expect, std::size_t _expectLen)
+{
+	int len;
+
+	if (_expectLen == 0) {
+		_expectLen = std::strlen(_expect);
+	}
+
+	len = lib_ttyportmux_memory__get(&s_capture[0], sizeof(s_capture));
+	lib_ttyportmux_memory__reset();
+	if ((_ret < EOK) || (len < 0) || (static_cast<std::size_t>(len) != _expectLen) || (std::memcmp(&s_capture[0], _expect, _expectLen) != 0)) {
+		std::fprintf(stderr, "FAIL \"%s\" (%d), expected \"%.*s\"\n", (len < 0) ? "" : &s_capture[0], _ret, static_cast<int>(_expectLen), _expect);
+		return 1;
+	}
+	return 0;
+}
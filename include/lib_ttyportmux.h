@@ -61,16 +61,28 @@ extern "C" {
 int lib_ttyportmux__init(struct ttyStreamMap *_map, size_t _mapSize);
 
 /* ************************************************************************//**
- * \brief	Cleanup of the tty port multiplexer
+ * \brief	Initialization of the tty port multiplexer with an operation mode
+ *
+ * In TTYMUX_MODE_async the message is formatted into a lock-free ring on the
+ * thread of the caller and written to the ttydevice by a drain thread.
+ * With TTYMUX_FORMAT_deferred only the arguments are captured and the text
+ * is rendered by the drain thread; the format string must stay valid for
+ * the lifetime of the program (string literal).
  *
- * \param	_deviceID_out : deviceID for
- * \brief Printout a message on the serial console
+ * \param	_map	 : ttystream to ttydevice mapping table
+ * \param 	_mapSize : size of the mapping table
+ * \param 	_config	 : operation mode, NULL selects M_TTYMUX_CONFIG_DEFAULT
  *
- * \param   _format 		"printf" style formatted string argument
  * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+int lib_ttyportmux__init_ext(struct ttyStreamMap *_map, size_t _mapSize, const struct ttyMuxConfig *_config);
+
+/* ************************************************************************//**
+ * \brief	Cleanup of the tty port multiplexer
  *
- *  out channel
- * \param 	_deviceID_in_out : deviceID for in out channel
+ * Prints started before the cleanup are completed, later ones return
+ * -EEXEC_NOINIT. The queued records of the asynchronous mode are written,
+ * then the ttydevices are closed.
  *
  * \return	EOK if successful, or negative errno value on error
  * ****************************************************************************/
@@ -111,6 +123,18 @@ int lib_ttyportmux__vprint(enum ttyStreamType _streamType, const char * const _f
  * ****************************************************************************/
 int lib_ttyportmux__putchar(enum ttyStreamType _streamType, char _c);
 
+/* ************************************************************************//**
+ *  \brief	Printout of an already formatted message through the tty port
+ *  		multiplexer, like the messages of lib_ttyportmux.hpp
+ *
+ * \param   _streamType	Categorization of the requirements at the stdio device
+ * \param   _buf		formatted message, not zero terminated
+ * \param   _len		number of bytes of the message
+ * \return	EOK if successful, or negative errno value on error
+ *
+ * ****************************************************************************/
+int lib_ttyportmux__print_buf(enum ttyStreamType _streamType, const char *_buf, size_t _len);
+
 /* ************************************************************************//**
  *  \brief	Read of a full console log until the newline is reached
  *
@@ -177,6 +201,124 @@ struct ttyDeviceInfo* lib_ttyportmux__get_ttydevice_info(struct list_node *_node
  * ****************************************************************************/
 int lib_ttyportmux__get_stream_count();
 
+/* ************************************************************************//**
+ *  \brief	 Set of the streams which are written at all
+ *
+ * A disabled stream returns EOK from the print functions before the
+ * arguments are touched or a ttydevice is called.
+ *
+ * \param   _mask : M_TTYSTREAM_BIT() of each enabled stream
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+int lib_ttyportmux__set_stream_enable(unsigned int _mask);
+
+/* ************************************************************************//**
+ *  \brief	 Request of the streams which are written at all
+ *
+ * \return	M_TTYSTREAM_BIT() of each enabled stream
+ * ****************************************************************************/
+unsigned int lib_ttyportmux__get_stream_enable(void);
+
+/* ************************************************************************//**
+ *  \brief	 Setup of the rate limit of a stream
+ *
+ * Messages of lib_ttyportmux__print() and lib_ttyportmux__vprint() beyond
+ * the limit return EOK without a ttydevice call. The first message written
+ * after a suppression is preceded by a line
+ * "N messages suppressed on TTYSTREAM_<name>". Messages of a captured
+ * stream, see lib_ttyportmux__set_stream_capture(), are not limited.
+ *
+ * \param   _streamType	: stream to limit
+ * \param   _rate		: messages per second, 0 disables the limit
+ * \param   _burst		: messages written at once after an idle period
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+int lib_ttyportmux__set_stream_ratelimit(enum ttyStreamType _streamType, unsigned int _rate, unsigned int _burst);
+
+/* ************************************************************************//**
+ *  \brief	 Request of the rate limit of a stream
+ *
+ * \param   _streamType	: stream to request
+ * \param   _rate [out]	: messages per second, 0 if not limited
+ * \param   _burst [out]	: messages written at once after an idle period
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+int lib_ttyportmux__get_stream_ratelimit(enum ttyStreamType _streamType, unsigned int *_rate, unsigned int *_burst);
+
+/* ************************************************************************//**
+ *  \brief	 Set of the streams whose repeated messages are coalesced
+ *
+ * A message equal to the previous one of its stream is not written, the
+ * repeats are reported as "last message repeated N times" before the next
+ * different message, each interval during a repetition and at cleanup.
+ * Repeats of a stream which went quiet are reported once the interval is
+ * over, in async mode by the drain thread, in sync mode by the next message
+ * of any stream as the sync mode has no timer.
+ * Messages are compared by a hash of the format pointer and the formatted
+ * bytes, messages longer than the scratch buffer are not coalesced.
+ *
+ * \param   _mask		: M_TTYSTREAM_BIT() of each coalesced stream
+ * \param   _intervalMs	: report interval during a repetition, 0 reports at a change only
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+int lib_ttyportmux__set_stream_coalesce(unsigned int _mask, unsigned int _intervalMs);
+
+/* ************************************************************************//**
+ *  \brief	 Request of the coalesced streams
+ *
+ * \return	M_TTYSTREAM_BIT() of each coalesced stream
+ * ****************************************************************************/
+unsigned int lib_ttyportmux__get_stream_coalesce(void);
+
+/* ************************************************************************//**
+ *  \brief	 Set of the prefix written in front of each message
+ *
+ * The prefix is rendered on the thread of the caller, also in async mode.
+ * The date and time are taken from a coarse realtime clock and rendered
+ * once per second, the thread id is requested once per thread.
+ *
+ * \param   _flags	: M_TTYPREFIX_* of each field, 0 disables the prefix
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+int lib_ttyportmux__set_prefix(unsigned int _flags);
+
+/* ************************************************************************//**
+ *  \brief	 Request of the fields of the message prefix
+ *
+ * \return	M_TTYPREFIX_* of each field
+ * ****************************************************************************/
+unsigned int lib_ttyportmux__get_prefix(void);
+
+/* ************************************************************************//**
+ *  \brief	 Set of the streams which are captured per thread
+ *
+ * A message of a captured stream is not written, it is kept in a bounded
+ * ring of the calling thread. If the same thread prints to
+ * TTYSTREAM_critical or TTYSTREAM_error the kept records are written first,
+ * oldest first, to the devices of their streams. The arguments are captured
+ * like in TTYMUX_FORMAT_deferred: only the pointer of the format string is
+ * kept, so the format strings of captured streams must have static storage
+ * duration, e.g. string literals. Longer records are truncated.
+ *
+ * Captured messages are not subject to the rate limit of their stream, they
+ * are written as the context of an error. A change of the depth keeps the
+ * records pending in each ring, up to the new depth.
+ *
+ * \param   _mask		: M_TTYSTREAM_BIT() of each captured stream, the
+ * 						  critical and error streams can not be captured
+ * \param   _depth		: records kept per thread, the oldest is overwritten
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+int lib_ttyportmux__set_stream_capture(unsigned int _mask, unsigned int _depth);
+
+/* ************************************************************************//**
+ *  \brief	 Request of the captured streams
+ *
+ * \param   _depth [out]	: records kept per thread, optional
+ * \return	M_TTYSTREAM_BIT() of each captured stream
+ * ****************************************************************************/
+unsigned int lib_ttyportmux__get_stream_capture(unsigned int *_depth);
+
 /* ************************************************************************//**
  *  \brief	 Request of the current ttystream to ttydevice mapping table
  *
@@ -200,10 +342,138 @@ int lib_ttyportmux__set_stream_mapping(const struct ttyStreamMap *const _map, si
  *
  * \param   _map [in]		:	map entry to stream to request
  * \param	_streamInfo[OUT]:	return corresponding meta info of a streamInfo 
- * \return	EOK if successful, or negative errno value on error
+ * \return	EOK if successful, -ESTD_NODEV if the stream is not resolved to an
+ * 			opened ttydevice, or negative errno value on error
  * ****************************************************************************/
 int lib_ttyportmux__get_stream_info(const struct ttyStreamMap *const _map, struct ttyStreamInfo * const _streamInfo);
 
+/* ************************************************************************//**
+ *  \brief	 Request of the message counters of a stream
+ *
+ * The counters are summed over all thread shards, the snapshot is not
+ * atomic against concurrent writers.
+ *
+ * \param   _streamType		:	stream to request
+ * \param	_stats[OUT]		:	messages, bytes, errors, drops, suppressed, truncated and max payload
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+int lib_ttyportmux__get_stats(enum ttyStreamType _streamType, struct ttyStats * const _stats);
+
+/* ************************************************************************//**
+ *  \brief	 Request of the message counters of a ttydevice
+ *
+ * \param   _node [in]		:	list entry of the ttydevice
+ * \param	_stats[OUT]		:	messages, bytes, errors and max payload
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+int lib_ttyportmux__get_ttydevice_stats(struct list_node *_node, struct ttyStats * const _stats);
+
+/* ************************************************************************//**
+ *  \brief	 Reset of the message counters of all streams and ttydevices
+ *
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+int lib_ttyportmux__reset_stats(void);
+
+/* ************************************************************************//**
+ *  \brief	 Request of the driver call latency of a ttydevice
+ *
+ * Percentiles are upper bounds of log-linear buckets of ~6% width, max is
+ * exact.
+ *
+ * \param   _node [in]		:	list entry of the ttydevice
+ * \param	_latency[OUT]	:	p50, p99, p999 and max in nanoseconds
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+int lib_ttyportmux__get_ttydevice_latency(struct list_node *_node, struct ttyLatency * const _latency);
+
+/* ************************************************************************//**
+ *  \brief	 Reset of the latency histograms of all ttydevices
+ *
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+int lib_ttyportmux__reset_latency(void);
+
+/* *******************************************************************
+ * static inline function definition
+ * ******************************************************************/
+
+/* enabled streams, written by lib_ttyportmux__set_stream_enable() only */
+extern unsigned int g_ttyportmux_streamEnable;
+
+/* ************************************************************************//**
+ *  \brief	 Check if a stream is enabled, a single relaxed load
+ *
+ * \param   _streamType	Categorization of the requirements at the stdio device
+ * \return	non zero if the stream is enabled
+ * ****************************************************************************/
+static inline int lib_ttyportmux__stream_enabled(enum ttyStreamType _streamType)
+{
+	return (__atomic_load_n(&g_ttyportmux_streamEnable, __ATOMIC_RELAXED) & M_TTYSTREAM_BIT(_streamType)) != 0;
+}
+
+/* print wrappers, the arguments are not evaluated if the stream is disabled */
+#define M_TTYPORTMUX_PRINT(__stream_type, ...) \
+	(lib_ttyportmux__stream_enabled(__stream_type) ? lib_ttyportmux__print((__stream_type), __VA_ARGS__) : 0)
+
+#define M_TTYPORTMUX_VPRINT(__stream_type, __format, __ap) \
+	(lib_ttyportmux__stream_enabled(__stream_type) ? lib_ttyportmux__vprint((__stream_type), (__format), (__ap)) : 0)
+
+#define M_TTYPORTMUX_PUTCHAR(__stream_type, __c) \
+	(lib_ttyportmux__stream_enabled(__stream_type) ? lib_ttyportmux__putchar((__stream_type), (__c)) : 0)
+
+/* ************************************************************************//**
+ * COMPILE TIME STREAM LEVEL
+ *
+ * Streams with a level above M_TTYPORTMUX_COMPILED_LEVEL are removed by the
+ * preprocessor, including their arguments and format strings. The level is
+ * set by the CMake cache variable TTYPORTMUX_COMPILED_LEVEL or defined
+ * before this header is included. The control stream is always compiled.
+ * ****************************************************************************/
+
+/* levels of the streams, equal to the values of enum ttyStreamType */
+#define M_TTYSTREAM_LEVEL_critical		0
+#define M_TTYSTREAM_LEVEL_error			1
+#define M_TTYSTREAM_LEVEL_warning		2
+#define M_TTYSTREAM_LEVEL_info			3
+#define M_TTYSTREAM_LEVEL_debug			4
+
+#ifndef M_TTYPORTMUX_COMPILED_LEVEL
+	#define M_TTYPORTMUX_COMPILED_LEVEL	M_TTYSTREAM_LEVEL_debug
+#endif
+
+#define M_TTYPORTMUX_CONTROL(...)	((void)M_TTYPORTMUX_PRINT(TTYSTREAM_control, __VA_ARGS__))
+
+#if M_TTYPORTMUX_COMPILED_LEVEL >= M_TTYSTREAM_LEVEL_critical
+	#define M_TTYPORTMUX_CRITICAL(...)	((void)M_TTYPORTMUX_PRINT(TTYSTREAM_critical, __VA_ARGS__))
+#else
+	#define M_TTYPORTMUX_CRITICAL(...)	((void)0)
+#endif
+
+#if M_TTYPORTMUX_COMPILED_LEVEL >= M_TTYSTREAM_LEVEL_error
+	#define M_TTYPORTMUX_ERROR(...)		((void)M_TTYPORTMUX_PRINT(TTYSTREAM_error, __VA_ARGS__))
+#else
+	#define M_TTYPORTMUX_ERROR(...)		((void)0)
+#endif
+
+#if M_TTYPORTMUX_COMPILED_LEVEL >= M_TTYSTREAM_LEVEL_warning
+	#define M_TTYPORTMUX_WARNING(...)	((void)M_TTYPORTMUX_PRINT(TTYSTREAM_warning, __VA_ARGS__))
+#else
+	#define M_TTYPORTMUX_WARNING(...)	((void)0)
+#endif
+
+#if M_TTYPORTMUX_COMPILED_LEVEL >= M_TTYSTREAM_LEVEL_info
+	#define M_TTYPORTMUX_INFO(...)		((void)M_TTYPORTMUX_PRINT(TTYSTREAM_info, __VA_ARGS__))
+#else
+	#define M_TTYPORTMUX_INFO(...)		((void)0)
+#endif
+
+#if M_TTYPORTMUX_COMPILED_LEVEL >= M_TTYSTREAM_LEVEL_debug
+	#define M_TTYPORTMUX_DEBUG(...)		((void)M_TTYPORTMUX_PRINT(TTYSTREAM_debug, __VA_ARGS__))
+#else
+	#define M_TTYPORTMUX_DEBUG(...)		((void)0)
+#endif
+
 
 #ifdef __cplusplus
 }
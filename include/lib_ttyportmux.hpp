@@ -0,0 +1,395 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal 
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _LIB_TTYPORTMUX_HPP_
+#define _LIB_TTYPORTMUX_HPP_
+
+#if (__cplusplus < 202002L)
+	#error "lib_ttyportmux.hpp requires C++20"
+#endif
+
+/* *******************************************************************
+ * includes
+ * *******************************************************************/
+
+/* c++ -runtime */
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+/*project*/
+#include <lib_ttyportmux.h>
+
+/* ************************************************************************//**
+ * Type safe C++ front-end of the tty port multiplexer
+ *
+ *	ttyportmux::print<TTYSTREAM_info>("x={} y={:x}\n", x, y);
+ *
+ * The format string is parsed at compile time, the number of the
+ * placeholders and their conversions are checked against the arguments.
+ * Each call site gets a writer specialized to its argument types, the
+ * message is formatted in place and passed to lib_ttyportmux__print_buf.
+ *
+ * Placeholders are "{}", "{:x}" and "{:X}" for hexadecimal integers,
+ * braces are escaped by "{{" and "}}". Streams above
+ * M_TTYPORTMUX_COMPILED_LEVEL are removed at compile time, except the
+ * control stream.
+ * ****************************************************************************/
+namespace ttyportmux {
+
+/* longer messages are truncated */
+inline constexpr std::size_t buffer_size = 512;
+
+namespace detail {
+
+/* *******************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ******************************************************************/
+enum class conv : unsigned char {
+	dflt,
+	hex,
+	HEX
+};
+
+/* literal text in front of a placeholder */
+struct field {
+	std::size_t begin;
+	std::size_t len;
+	bool escaped;		/*!< literal contains "{{" or "}}" */
+	conv c;
+};
+
+template<typename T>
+concept formattable = std::is_arithmetic_v<std::remove_cvref_t<T>> ||
+		std::is_enum_v<std::remove_cvref_t<T>> ||
+		std::is_pointer_v<std::decay_t<T>> ||
+		std::is_null_pointer_v<std::remove_cvref_t<T>> ||
+		std::is_convertible_v<const T&, std::string_view>;
+
+/* *******************************************************************
+ * static data
+ * ******************************************************************/
+inline constexpr char dec2[] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+/* ************************************************************************//**
+ * \brief	Called only on an invalid format string, it is not constexpr and
+ * 			fails the compile time evaluation with the message as context
+ * ****************************************************************************/
+inline void format_error(const char *) {}
+
+/* ************************************************************************//**
+ * \brief	Output of a message into a fixed buffer, truncated at its end
+ * ****************************************************************************/
+class writer
+{
+public:
+	writer(char *_buf, std::size_t _size) : m_buf(_buf), m_size(_size), m_pos(0) {}
+
+	std::size_t length() const { return m_pos; }
+
+	void put(const char *_src, std::size_t _len)
+	{
+		if (_len > (m_size - m_pos)) {
+			_len = m_size - m_pos;
+		}
+		std::memcpy(&m_buf[m_pos], _src, _len);
+		m_pos += _len;
+	}
+
+	void literal(const char *_src, std::size_t _len, bool _escaped)
+	{
+		std::size_t i;
+
+		if (!_escaped) {
+			put(_src, _len);
+			return;
+		}
+		for (i = 0; i < _len; i++) {
+			put(&_src[i], 1);
+			if (((_src[i] == '{') || (_src[i] == '}')) && ((i + 1) < _len) && (_src[i + 1] == _src[i])) {
+				i++;
+			}
+		}
+	}
+
+	template<typename T>
+	void value(const T &_val, conv _c)
+	{
+		using U = std::remove_cvref_t<T>;
+
+		if constexpr (std::is_same_v<U, bool>) {
+			put(_val ? "true" : "false", _val ? 4 : 5);
+		}
+		else if constexpr (std::is_same_v<U, char>) {
+			if (_c == conv::dflt) {
+				put(&_val, 1);
+			}
+			else {
+				hex(static_cast<unsigned char>(_val), _c == conv::HEX);
+			}
+		}
+		else if constexpr (std::is_enum_v<U>) {
+			value(static_cast<std::underlying_type_t<U>>(_val), _c);
+		}
+		else if constexpr (std::is_integral_v<U>) {
+			if (_c != conv::dflt) {
+				hex(static_cast<std::make_unsigned_t<U>>(_val), _c == conv::HEX);
+			}
+			else if constexpr (std::is_signed_v<U>) {
+				dec(static_cast<unsigned long long>((_val < 0) ? (0ULL - static_cast<unsigned long long>(_val)) : static_cast<unsigned long long>(_val)), _val < 0);
+			}
+			else {
+				dec(_val, false);
+			}
+		}
+		else if constexpr (std::is_floating_point_v<U>) {
+			flt(static_cast<double>(_val));
+		}
+		else if constexpr (std::is_null_pointer_v<U>) {
+			ptr(0);
+		}
+		else if constexpr (std::is_convertible_v<const U&, const char*>) {
+			const char *str = _val;
+			if (str == nullptr) {
+				put("(null)", 6);
+			}
+			else {
+				put(str, std::strlen(str));
+			}
+		}
+		else if constexpr (std::is_convertible_v<const U&, std::string_view>) {
+			std::string_view str = _val;
+			put(str.data(), str.size());
+		}
+		else {
+			static_assert(std::is_pointer_v<U>, "argument is not formattable");
+			ptr(reinterpret_cast<std::uintptr_t>(static_cast<const void*>(_val)));
+		}
+	}
+
+private:
+	void dec(unsigned long long _val, bool _neg)
+	{
+		char digits[24];
+		char *p = &digits[sizeof(digits)];
+
+		while (_val >= 100) {
+			p -= 2;
+			std::memcpy(p, &dec2[(_val % 100) * 2], 2);
+			_val /= 100;
+		}
+		if (_val >= 10) {
+			p -= 2;
+			std::memcpy(p, &dec2[_val * 2], 2);
+		}
+		else {
+			*--p = static_cast<char>('0' + _val);
+		}
+		if (_neg) {
+			*--p = '-';
+		}
+		put(p, static_cast<std::size_t>(&digits[sizeof(digits)] - p));
+	}
+
+	void hex(unsigned long long _val, bool _upper)
+	{
+		const char *nibble = _upper ? "0123456789ABCDEF" : "0123456789abcdef";
+		char digits[16];
+		char *p = &digits[sizeof(digits)];
+
+		do {
+			*--p = nibble[_val & 0xf];
+			_val >>= 4;
+		} while (_val != 0);
+		put(p, static_cast<std::size_t>(&digits[sizeof(digits)] - p));
+	}
+
+	void ptr(std::uintptr_t _val)
+	{
+		if (_val == 0) {
+			put("(nil)", 5);
+			return;
+		}
+		put("0x", 2);
+		hex(_val, false);
+	}
+
+	void flt(double _val)
+	{
+		char tmp[32];
+		int len;
+
+		len = std::snprintf(&tmp[0], sizeof(tmp), "%g", _val);
+		if (len > 0) {
+			put(&tmp[0], (static_cast<std::size_t>(len) < sizeof(tmp)) ? static_cast<std::size_t>(len) : (sizeof(tmp) - 1));
+		}
+	}
+
+	char *m_buf;
+	std::size_t m_size;
+	std::size_t m_pos;
+};
+
+/* ************************************************************************//**
+ * \brief	Format string of the argument types Args, parsed at compile time
+ * ****************************************************************************/
+template<typename... Args>
+class basic_format
+{
+public:
+	template<std::size_t N>
+	consteval basic_format(const char (&_fmt)[N]) : m_str(_fmt), m_field{}
+	{
+		constexpr bool integral[] = { (std::is_integral_v<Args> || std::is_enum_v<Args>)..., false };
+		std::size_t pos = 0, begin = 0, count = 0;
+		bool escaped = false;
+
+		while ((pos < (N - 1)) && (_fmt[pos] != '\0')) {
+			if (_fmt[pos] == '}') {
+				if (_fmt[pos + 1] != '}') {
+					format_error("unmatched '}' in format string");
+				}
+				escaped = true;
+				pos += 2;
+				continue;
+			}
+			if (_fmt[pos] != '{') {
+				pos++;
+				continue;
+			}
+			if (_fmt[pos + 1] == '{') {
+				escaped = true;
+				pos += 2;
+				continue;
+			}
+
+			if (count >= sizeof...(Args)) {
+				format_error("more placeholders than arguments");
+			}
+			m_field[count] = field{ begin, pos - begin, escaped, conv::dflt };
+			pos++;
+
+			if (_fmt[pos] == ':') {
+				pos++;
+				if (_fmt[pos] == 'x') {
+					m_field[count].c = conv::hex;
+				}
+				else if (_fmt[pos] == 'X') {
+					m_field[count].c = conv::HEX;
+				}
+				else {
+					format_error("unsupported conversion, only {:x} and {:X}");
+				}
+				if (!integral[count]) {
+					format_error("hexadecimal conversion of a non integral argument");
+				}
+				pos++;
+			}
+
+			if (_fmt[pos] != '}') {
+				format_error("missing '}' in format string");
+			}
+			pos++;
+			begin = pos;
+			escaped = false;
+			count++;
+		}
+
+		if (count != sizeof...(Args)) {
+			format_error("fewer placeholders than arguments");
+		}
+		m_field[count] = field{ begin, pos - begin, escaped, conv::dflt };
+	}
+
+	template<typename... T>
+	void write(writer &_out, const T&... _args) const
+	{
+		write_fields(_out, std::index_sequence_for<T...>{}, _args...);
+		_out.literal(m_str + m_field[sizeof...(Args)].begin, m_field[sizeof...(Args)].len, m_field[sizeof...(Args)].escaped);
+	}
+
+private:
+	template<std::size_t... I, typename... T>
+	void write_fields(writer &_out, std::index_sequence<I...>, const T&... _args) const
+	{
+		((_out.literal(m_str + m_field[I].begin, m_field[I].len, m_field[I].escaped), _out.value(_args, m_field[I].c)), ...);
+	}
+
+	const char *m_str;
+	field m_field[sizeof...(Args) + 1];
+};
+
+} /* namespace detail */
+
+/* the argument types are deduced from the arguments only */
+template<typename... Args>
+using format_string = detail::basic_format<std::type_identity_t<std::remove_cvref_t<Args>>...>;
+
+/* ************************************************************************//**
+ * \brief	Printout a message on the tty port multiplexer
+ *
+ * \tparam	S		Categorization of the in and output device
+ * \param   _fmt	format string with "{}" placeholders, checked at compile time
+ * \param   _args	arguments of the placeholders
+ *
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+template<enum ttyStreamType S, detail::formattable... Args>
+inline int print(format_string<Args...> _fmt, Args&&... _args)
+{
+	static_assert(S < TTYSTREAM_CNT, "invalid stream");
+
+	if constexpr ((S != TTYSTREAM_control) && (static_cast<int>(S) > M_TTYPORTMUX_COMPILED_LEVEL)) {
+		return 0;
+	}
+	else {
+		char buf[buffer_size];
+		detail::writer out(&buf[0], sizeof(buf));
+
+		if (!lib_ttyportmux__stream_enabled(S)) {
+			return 0;
+		}
+		_fmt.write(out, _args...);
+		return lib_ttyportmux__print_buf(S, &buf[0], out.length());
+	}
+}
+
+} /* namespace ttyportmux */
+
+#endif /* _LIB_TTYPORTMUX_HPP_ */
@@ -0,0 +1,75 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal 
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _LIB_TTYPORTMUX_MEMORY_H_
+#define _LIB_TTYPORTMUX_MEMORY_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* *******************************************************************
+ * includes
+ * ******************************************************************/
+
+/* c runtime */
+#include <stddef.h>
+
+/* *******************************************************************
+ * function declarations
+ * ******************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Copy of the output captured by the memory ttydevice
+ *
+ * The capture buffer keeps the most recent bytes, older output is
+ * overwritten if it is full. The copy is NUL terminated.
+ *
+ * \param   _buf [out]	: destination of the captured output
+ * \param   _size		: size of _buf
+ * \return	number of bytes copied without the NUL, or negative errno value on error
+ * ****************************************************************************/
+int lib_ttyportmux_memory__get(char *_buf, size_t _size);
+
+/* ************************************************************************//**
+ * \brief	Number of bytes written to the memory ttydevice since the last
+ * 			reset, including overwritten bytes
+ *
+ * \return	number of bytes
+ * ****************************************************************************/
+size_t lib_ttyportmux_memory__written(void);
+
+/* ************************************************************************//**
+ * \brief	Discard of the captured output
+ *
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+int lib_ttyportmux_memory__reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _LIB_TTYPORTMUX_MEMORY_H_ */
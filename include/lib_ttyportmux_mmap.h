@@ -0,0 +1,89 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal 
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _LIB_TTYPORTMUX_MMAP_H_
+#define _LIB_TTYPORTMUX_MMAP_H_
+
+/* *******************************************************************
+ * includes
+ * ******************************************************************/
+
+/* c runtime */
+#include <stdint.h>
+
+/* *******************************************************************
+ * defines
+ * ******************************************************************/
+#define M_TTYMMAP_MAGIC				"TTYMMAP1"
+#define M_TTYMMAP_VERSION			1
+#define M_TTYMMAP_HEADER_SIZE		256		/*!< offset of the ring in the file */
+#define M_TTYMMAP_ALIGN				8		/*!< alignment of the records in the ring */
+#define M_TTYMMAP_FLAG_PAD			0x0001	/*!< filler up to the end of the ring */
+
+#define M_TTYMMAP_RECORD_SIZE(__len) \
+	((sizeof(struct ttyMmapRecord) + (__len) + M_TTYMMAP_ALIGN - 1) & ~((uint64_t)M_TTYMMAP_ALIGN - 1))
+
+/* *******************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ******************************************************************/
+
+/* ************************************************************************//**
+ * \brief	File header of the flight recorder of the mmap ttydevice
+ *
+ * write and commit are absolute byte positions, the ring offset of a
+ * position is position % ringSize. commit is the end of the last record
+ * completed by any writer, concurrent writers complete their records out
+ * of order. A record before commit may still be incomplete and records
+ * between commit and write were not completed when the process ended, only
+ * the pos of a record tells whether it is complete.
+ * ****************************************************************************/
+struct ttyMmapHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t headerSize;
+	uint64_t ringSize;			/*!< power of two */
+	uint64_t reserved[5];
+	uint64_t write;				/*!< end of the last reserved record, own cache line */
+	uint64_t reserved1[7];
+	uint64_t commit;			/*!< end of the last committed record, own cache line */
+	uint64_t reserved2[7];
+};
+
+/* ************************************************************************//**
+ * \brief	Header of a record, the payload of len bytes follows
+ *
+ * pos is stored last and equals the absolute position of the record, a
+ * record is valid only if pos matches the position it is found at.
+ * Records never wrap, the space up to the end of the ring is filled by a
+ * M_TTYMMAP_FLAG_PAD record or is shorter than a record header.
+ * ****************************************************************************/
+struct ttyMmapRecord {
+	uint64_t pos;
+	uint32_t len;
+	uint16_t streamType;
+	uint16_t flags;
+};
+
+#endif /* _LIB_TTYPORTMUX_MMAP_H_ */
@@ -29,6 +29,7 @@
 /* *******************************************************************
  * includes
  * ******************************************************************/
+#include <stdint.h>
 
 /* *******************************************************************
  * defines
@@ -36,7 +37,49 @@
 #define M_STREAM_MAPPING_ENTRY(__port_type) \
 {													  \
 	.deviceType = __port_type,						  \
-	.ttydevice = NULL								  \
+	.ttydevice = NULL,								  \
+	.deviceMask = 0,								  \
+	.deviceIndex = 0								  \
+}
+
+/* stream is written to instance __index of __port_type */
+#define M_STREAM_MAPPING_INSTANCE(__port_type, __index) \
+{													  \
+	.deviceType = __port_type,						  \
+	.ttydevice = NULL,								  \
+	.deviceMask = 0,								  \
+	.deviceIndex = __index							  \
+}
+
+/* stream is written to __port_type and to each device type of __mask */
+#define M_STREAM_MAPPING_FANOUT(__port_type, __mask)  \
+{													  \
+	.deviceType = __port_type,						  \
+	.ttydevice = NULL,								  \
+	.deviceMask = __mask,							  \
+	.deviceIndex = 0								  \
+}
+
+#define M_TTYDEVICE_BIT(__port_type)	(1U << (__port_type))
+#define M_TTYSTREAM_BIT(__stream_type)	(1U << (__stream_type))
+#define M_TTYSTREAM_ENABLE_ALL			(M_TTYSTREAM_BIT(TTYSTREAM_CNT) - 1)
+#define M_TTYSTREAM_FANOUT_MAX			4
+
+/* fields of the message prefix, see lib_ttyportmux__set_prefix */
+#define M_TTYPREFIX_TIME				0x0001	/*!< local date and time with milliseconds */
+#define M_TTYPREFIX_STREAM				0x0002	/*!< name of the stream */
+#define M_TTYPREFIX_TID					0x0004	/*!< thread id of the caller */
+#define M_TTYPREFIX_ALL					(M_TTYPREFIX_TIME | M_TTYPREFIX_STREAM | M_TTYPREFIX_TID)
+
+#define M_TTYMUX_CONFIG_DEFAULT						  \
+{													  \
+	.mode = TTYMUX_MODE_sync,						  \
+	.overflow = TTYMUX_OVERFLOW_drop,				  \
+	.format = TTYMUX_FORMAT_immediate,				  \
+	.ringSlots = 1024,								  \
+	.slotSize = 256,								  \
+	.scratchArenas = 8,								  \
+	.scratchSize = 1024								  \
 }
 
 /* *******************************************************************
@@ -57,7 +100,27 @@ enum ttyDeviceType {
 	TTYDEVICE_console,
 	TTYDEVICE_trace_CORTEXM,
 	TTYDEVICE_unix,
-	TTYDEVICE_syslog
+	TTYDEVICE_syslog,
+	TTYDEVICE_null,
+	TTYDEVICE_memory,
+	TTYDEVICE_file,
+	TTYDEVICE_mmap,
+	TTYDEVICE_CNT
+};
+
+enum ttyMuxMode {
+	TTYMUX_MODE_sync,		/*!< driver is called on the thread of the caller */
+	TTYMUX_MODE_async		/*!< message is queued and written by the drain thread */
+};
+
+enum ttyMuxOverflow {
+	TTYMUX_OVERFLOW_drop,	/*!< message is discarded if the ring is full */
+	TTYMUX_OVERFLOW_block	/*!< caller waits until the drain thread frees a slot */
+};
+
+enum ttyMuxFormat {
+	TTYMUX_FORMAT_immediate,	/*!< message is formatted on the thread of the caller */
+	TTYMUX_FORMAT_deferred		/*!< arguments are captured, the drain thread formats */
 };
 
 
@@ -83,6 +146,39 @@ struct ttyStreamMap
 	enum ttyDeviceType deviceType;
  	enum ttyStreamType streamType;
 	ttydevice_t *ttydevice;
+	unsigned int deviceMask;		/*!< additional devices, M_TTYDEVICE_BIT() of each type */
+	unsigned int deviceIndex;		/*!< instance of deviceType, the devices of deviceMask use instance 0 */
+};
+
+struct ttyMuxConfig
+{
+	enum ttyMuxMode mode;
+	enum ttyMuxOverflow overflow;	/*!< async mode: behaviour at a full ring */
+	enum ttyMuxFormat format;		/*!< async mode: deferred requires format strings of static storage */
+	unsigned int ringSlots;			/*!< async mode: number of slots, rounded up to a power of two */
+	unsigned int slotSize;			/*!< async mode: bytes per slot, longer messages are truncated */
+	unsigned int scratchArenas;		/*!< formatting arenas preallocated for the printing threads, 0 allocates one per thread */
+	unsigned int scratchSize;		/*!< bytes of each formatting buffer, 0 selects 1024, longer prefixed messages are truncated */
+};
+
+struct ttyStats
+{
+	uint64_t messages;		/*!< messages written successfully */
+	uint64_t bytes;			/*!< bytes of the messages, if reported by the driver */
+	uint64_t errors;		/*!< writes which returned an error */
+	uint64_t drops;			/*!< messages discarded at a full ring */
+	uint64_t suppressed;	/*!< messages discarded by the rate limit of the stream */
+	uint64_t truncated;		/*!< messages written cut to the formatting buffer */
+	uint32_t maxPayload;	/*!< longest message in bytes */
+};
+
+struct ttyLatency
+{
+	uint64_t count;			/*!< measured driver calls */
+	uint64_t p50;			/*!< percentiles of the driver call duration in ns */
+	uint64_t p99;
+	uint64_t p999;
+	uint64_t max;
 };
 
 #endif /* _LIB_TTYPORTMUX_TYPES_H_ */
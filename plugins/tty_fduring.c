@@ -0,0 +1,328 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal 
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* *******************************************************************
+ * includes
+ * ******************************************************************/
+
+/* c -runtime */
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+/* frame */
+#include <lib_convention__errno.h>
+
+/* project */
+#include "tty_fduring.h"
+
+/* *******************************************************************
+ * defines
+ * ******************************************************************/
+#define M_TTY_FDURING_ENTRIES		4
+
+/* *******************************************************************
+ * static function declarations
+ * ******************************************************************/
+static int tty_fduring__setup(unsigned int _entries, struct io_uring_params *_params);
+static int tty_fduring__enter(int _ringFd, unsigned int _submit, unsigned int _minComplete, unsigned int _flags);
+static int tty_fduring__push(struct tty_fduring *_uring);
+static int tty_fduring__reap(struct tty_fduring *_uring);
+static void tty_fduring__unmap(struct tty_fduring *_uring);
+
+/* *******************************************************************
+ * function definition
+ * ******************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Setup of the ring and registration of the buffers of the writer
+ *
+ * \param	_uring	: ring to setup
+ * \param	_bufs	: buffers submitted later on, registered if possible
+ * \param	_nbufs	: number of buffers
+ * \return	EOK if successful, or negative errno value if io_uring is not
+ * 			available and the writer falls back to writev()
+ * ****************************************************************************/
+int tty_fduring__init(struct tty_fduring *_uring, const struct iovec *_bufs, unsigned int _nbufs)
+{
+	struct io_uring_params params;
+	char *sq, *cq;
+	int ringFd, ret_val;
+
+	if ((_uring == NULL) || (_bufs == NULL)) {
+		return -EPAR_NULL;
+	}
+
+	memset(_uring, 0, sizeof(*_uring));
+	memset(&params, 0, sizeof(params));
+
+	ringFd = tty_fduring__setup(M_TTY_FDURING_ENTRIES, &params);
+	if (ringFd < 0) {
+		return convert_std_errno(errno);
+	}
+	_uring->ringFd = ringFd;
+
+	/* records are appended at the current position of the fd, like write() */
+	if ((params.features & IORING_FEAT_RW_CUR_POS) == 0) {
+		ret_val = -ESTD_NOSYS;
+		goto ERR_RING;
+	}
+
+	_uring->sqMapSize = params.sq_off.array + (params.sq_entries * sizeof(unsigned int));
+	_uring->cqMapSize = params.cq_off.cqes + (params.cq_entries * sizeof(struct io_uring_cqe));
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		if (_uring->cqMapSize > _uring->sqMapSize) {
+			_uring->sqMapSize = _uring->cqMapSize;
+		}
+		_uring->cqMapSize = _uring->sqMapSize;
+	}
+
+	_uring->sqMap = mmap(NULL, _uring->sqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+	if (_uring->sqMap == MAP_FAILED) {
+		_uring->sqMap = NULL;
+		ret_val = convert_std_errno(errno);
+		goto ERR_RING;
+	}
+
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		_uring->cqMap = _uring->sqMap;
+	}
+	else {
+		_uring->cqMap = mmap(NULL, _uring->cqMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+		if (_uring->cqMap == MAP_FAILED) {
+			_uring->cqMap = NULL;
+			ret_val = convert_std_errno(errno);
+			goto ERR_MAP;
+		}
+	}
+
+	_uring->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+	_uring->sqes = mmap(NULL, _uring->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+	if (_uring->sqes == MAP_FAILED) {
+		_uring->sqes = NULL;
+		ret_val = convert_std_errno(errno);
+		goto ERR_MAP;
+	}
+
+	sq = (char*)_uring->sqMap;
+	_uring->sqHead = (unsigned int*)(sq + params.sq_off.head);
+	_uring->sqTail = (unsigned int*)(sq + params.sq_off.tail);
+	_uring->sqMask = (unsigned int*)(sq + params.sq_off.ring_mask);
+	_uring->sqArray = (unsigned int*)(sq + params.sq_off.array);
+
+	cq = (char*)_uring->cqMap;
+	_uring->cqHead = (unsigned int*)(cq + params.cq_off.head);
+	_uring->cqTail = (unsigned int*)(cq + params.cq_off.tail);
+	_uring->cqMask = (unsigned int*)(cq + params.cq_off.ring_mask);
+	_uring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+
+	/* registration fails beyond RLIMIT_MEMLOCK, plain writes are used then */
+	_uring->fixed = (syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_BUFFERS, _bufs, _nbufs) == 0);
+	return EOK;
+
+	ERR_MAP:
+	tty_fduring__unmap(_uring);
+	ERR_RING:
+	close(ringFd);
+	_uring->ringFd = -1;
+	return ret_val;
+}
+
+/* ************************************************************************//**
+ * \brief	Wait for the write in flight and release of the ring
+ * ****************************************************************************/
+void tty_fduring__cleanup(struct tty_fduring *_uring)
+{
+	if ((_uring == NULL) || (_uring->ringFd < 0)) {
+		return;
+	}
+
+	tty_fduring__wait(_uring);
+	tty_fduring__unmap(_uring);
+	close(_uring->ringFd);
+	_uring->ringFd = -1;
+}
+
+/* ************************************************************************//**
+ * \brief	Submit of a write at the current position of _fd
+ *
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+int tty_fduring__submit(struct tty_fduring *_uring, int _fd, unsigned int _bufIndex, const char *_buf, size_t _len)
+{
+	if (_uring->inflight) {
+		return -ESTD_BUSY;
+	}
+
+	_uring->fd = _fd;
+	_uring->bufIndex = _bufIndex;
+	_uring->buf = _buf;
+	_uring->len = _len;
+	_uring->done = 0;
+	_uring->error = EOK;
+	_uring->inflight = 1;
+
+	return tty_fduring__push(_uring);
+}
+
+/* ************************************************************************//**
+ * \brief	Wait until the write in flight completed, a short write is
+ * 			continued
+ *
+ * \return	EOK, or negative errno value of the completed write
+ * ****************************************************************************/
+int tty_fduring__wait(struct tty_fduring *_uring)
+{
+	int ret;
+
+	while (_uring->inflight) {
+		ret = tty_fduring__reap(_uring);
+		if (ret == -ESTD_AGAIN) {
+			ret = tty_fduring__enter(_uring->ringFd, 0, 1, IORING_ENTER_GETEVENTS);
+			if ((ret < EOK) && (ret != -ESTD_INTR)) {
+				/* the ring is unusable, the write is lost */
+				_uring->inflight = 0;
+				return ret;
+			}
+		}
+	}
+
+	ret = _uring->error;
+	_uring->error = EOK;
+	return ret;
+}
+
+/* *******************************************************************
+ * static function definition
+ * ******************************************************************/
+static int tty_fduring__setup(unsigned int _entries, struct io_uring_params *_params)
+{
+	return (int)syscall(__NR_io_uring_setup, _entries, _params);
+}
+
+static int tty_fduring__enter(int _ringFd, unsigned int _submit, unsigned int _minComplete, unsigned int _flags)
+{
+	if (syscall(__NR_io_uring_enter, _ringFd, _submit, _minComplete, _flags, NULL, 0) < 0) {
+		return convert_std_errno(errno);
+	}
+	return EOK;
+}
+
+/* ************************************************************************//**
+ * \brief	Queue of the outstanding part of the write in flight
+ * ****************************************************************************/
+static int tty_fduring__push(struct tty_fduring *_uring)
+{
+	struct io_uring_sqe *sqe;
+	unsigned int tail, index;
+	int ret;
+
+	tail = *_uring->sqTail;
+	index = tail & *_uring->sqMask;
+	sqe = &_uring->sqes[index];
+
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = _uring->fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+	sqe->fd = _uring->fd;
+	sqe->addr = (uint64_t)(uintptr_t)(_uring->buf + _uring->done);
+	sqe->len = (uint32_t)(_uring->len - _uring->done);
+	sqe->off = (uint64_t)-1;
+	sqe->buf_index = (uint16_t)_uring->bufIndex;
+
+	_uring->sqArray[index] = index;
+	__atomic_store_n(_uring->sqTail, tail + 1, __ATOMIC_RELEASE);
+
+	do {
+		ret = tty_fduring__enter(_uring->ringFd, 1, 0, 0);
+	} while (ret == -ESTD_INTR);
+
+	if (ret < EOK) {
+		__atomic_store_n(_uring->sqTail, tail, __ATOMIC_RELEASE);
+		_uring->error = ret;
+		_uring->inflight = 0;
+	}
+	return ret;
+}
+
+/* ************************************************************************//**
+ * \brief	Consumption of a completion without blocking
+ *
+ * \return	EOK if a completion was consumed, -ESTD_AGAIN if none is pending
+ * ****************************************************************************/
+static int tty_fduring__reap(struct tty_fduring *_uring)
+{
+	unsigned int head;
+	int res;
+
+	head = *_uring->cqHead;
+	if (head == __atomic_load_n(_uring->cqTail, __ATOMIC_ACQUIRE)) {
+		return -ESTD_AGAIN;
+	}
+
+	res = _uring->cqes[head & *_uring->cqMask].res;
+	__atomic_store_n(_uring->cqHead, head + 1, __ATOMIC_RELEASE);
+
+	if ((res == -EAGAIN) || (res == -EINTR)) {
+		tty_fduring__push(_uring);
+	}
+	else if (res < 0) {
+		_uring->error = convert_std_errno(-res);
+		_uring->inflight = 0;
+	}
+	else if (res == 0) {
+		_uring->error = -ESTD_IO;
+		_uring->inflight = 0;
+	}
+	else {
+		_uring->done += (size_t)res;
+		if (_uring->done < _uring->len) {
+			tty_fduring__push(_uring);
+		}
+		else {
+			_uring->inflight = 0;
+		}
+	}
+	return EOK;
+}
+
+static void tty_fduring__unmap(struct tty_fduring *_uring)
+{
+	if (_uring->sqes != NULL) {
+		munmap(_uring->sqes, _uring->sqesSize);
+		_uring->sqes = NULL;
+	}
+	if ((_uring->cqMap != NULL) && (_uring->cqMap != _uring->sqMap)) {
+		munmap(_uring->cqMap, _uring->cqMapSize);
+	}
+	if (_uring->sqMap != NULL) {
+		munmap(_uring->sqMap, _uring->sqMapSize);
+	}
+	_uring->cqMap = NULL;
+	_uring->sqMap = NULL;
+}
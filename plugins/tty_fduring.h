@@ -0,0 +1,122 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal 
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _TTY_FDURING_H_
+#define _TTY_FDURING_H_
+
+/* *******************************************************************
+ * includes
+ * ******************************************************************/
+
+/* c runtime */
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/uio.h>
+
+/* *******************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ******************************************************************/
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+/* ************************************************************************//**
+ * \brief	io_uring of a buffered fd writer with a single write in flight
+ *
+ * Writes of one file descriptor must complete in order, a further write is
+ * submitted only after the previous one completed. The caller fills the next
+ * buffer meanwhile.
+ * ****************************************************************************/
+struct tty_fduring {
+	int ringFd;
+	int fixed;					/*!< buffers are registered, IORING_OP_WRITE_FIXED is used */
+
+	unsigned int *sqHead;
+	unsigned int *sqTail;
+	unsigned int *sqMask;
+	unsigned int *sqArray;
+	struct io_uring_sqe *sqes;
+
+	unsigned int *cqHead;
+	unsigned int *cqTail;
+	unsigned int *cqMask;
+	struct io_uring_cqe *cqes;
+
+	void *sqMap;
+	void *cqMap;
+	size_t sqMapSize;
+	size_t cqMapSize;
+	size_t sqesSize;
+
+	/* write in flight */
+	int inflight;
+	int fd;
+	unsigned int bufIndex;
+	const char *buf;
+	size_t len;
+	size_t done;
+	int error;
+};
+
+/* *******************************************************************
+ * function declarations
+ * ******************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Setup of the ring and registration of the buffers of the writer
+ *
+ * \param	_uring	: ring to setup
+ * \param	_bufs	: buffers submitted later on, registered if possible
+ * \param	_nbufs	: number of buffers
+ * \return	EOK if successful, or negative errno value if io_uring is not
+ * 			available and the writer falls back to writev()
+ * ****************************************************************************/
+int tty_fduring__init(struct tty_fduring *_uring, const struct iovec *_bufs, unsigned int _nbufs);
+
+/* ************************************************************************//**
+ * \brief	Wait for the write in flight and release of the ring
+ * ****************************************************************************/
+void tty_fduring__cleanup(struct tty_fduring *_uring);
+
+/* ************************************************************************//**
+ * \brief	Submit of a write at the current position of _fd
+ *
+ * \param	_uring		: ring without a write in flight
+ * \param	_fd			: file descriptor to write to
+ * \param	_bufIndex	: index of _buf at the registration
+ * \param	_buf		: bytes to write, untouched until the write completed
+ * \param	_len		: number of bytes
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+int tty_fduring__submit(struct tty_fduring *_uring, int _fd, unsigned int _bufIndex, const char *_buf, size_t _len);
+
+/* ************************************************************************//**
+ * \brief	Wait until the write in flight completed, a short write is
+ * 			continued
+ *
+ * \return	EOK, or negative errno value of the completed write
+ * ****************************************************************************/
+int tty_fduring__wait(struct tty_fduring *_uring);
+
+#endif /* _TTY_FDURING_H_ */
@@ -0,0 +1,606 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal 
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* *******************************************************************
+ * includes
+ * ******************************************************************/
+
+/* c -runtime */
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+/* frame */
+#include <lib_convention__errno.h>
+
+/* project */
+#include "tty_fdwriter.h"
+#include "tty_portmux_fmt.h"
+#if defined(M_TTY_FDWRITER_URING)
+	#include "tty_fduring.h"
+#endif
+
+/* *******************************************************************
+ * defines
+ * ******************************************************************/
+#if defined(CLOCK_MONOTONIC_COARSE)
+	#define M_TTY_FDWRITER_CLOCK		CLOCK_MONOTONIC_COARSE
+#else
+	#define M_TTY_FDWRITER_CLOCK		CLOCK_MONOTONIC
+#endif
+
+/* *******************************************************************
+ * static function declarations
+ * ******************************************************************/
+static int tty_fdwriter__writev(int _fd, struct iovec *_iov, int _iovcnt);
+static int tty_fdwriter__flush_locked(struct tty_fdwriter *_writer);
+static int tty_fdwriter__drain_locked(struct tty_fdwriter *_writer);
+static int tty_fdwriter__write_through(struct tty_fdwriter *_writer, const char *_rec, size_t _len);
+static int tty_fdwriter__write_windows(struct tty_fdwriter *_writer, size_t _len, const char *_format, va_list _ap);
+static int tty_fdwriter__appended(struct tty_fdwriter *_writer, size_t _recOffset, int _urgent);
+static uint64_t tty_fdwriter__now(void);
+static int tty_fdwriter__flusher_start(struct tty_fdwriter *_writer);
+static void tty_fdwriter__flusher_stop(struct tty_fdwriter *_writer);
+static void* tty_fdwriter__flusher(void *_arg);
+#if defined(M_TTY_FDWRITER_URING)
+static void tty_fdwriter__uring_init(struct tty_fdwriter *_writer);
+static int tty_fdwriter__uring_flush(struct tty_fdwriter *_writer);
+#endif
+
+/* *******************************************************************
+ * function definition
+ * ******************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Setup of a writer on an opened file descriptor
+ *
+ * \param	_writer	: writer to setup
+ * \param	_fd		: file descriptor to write to
+ * \param	_buf	: buffer of the writer, owned by the caller
+ * \param	_size	: size of the buffer
+ * \param	_policy	: flush policy
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+int tty_fdwriter__init(struct tty_fdwriter *_writer, int _fd, char *_buf, size_t _size, const struct tty_fdwriter_policy *_policy)
+{
+	int ret;
+
+	if ((_writer == NULL) || (_buf == NULL) || (_policy == NULL)) {
+		return -EPAR_NULL;
+	}
+
+	if ((_fd < 0) || (_size == 0)) {
+		return -ESTD_INVAL;
+	}
+
+	ret = pthread_mutex_init(&_writer->lock, NULL);
+	if (ret != 0) {
+		return convert_std_errno(ret);
+	}
+
+	_writer->fd = _fd;
+	_writer->buf = _buf;
+	_writer->size = _size;
+	_writer->len = 0;
+	_writer->pendingSince = 0;
+	_writer->policy = *_policy;
+	_writer->flusherIdle = 0;
+	_writer->flusherStop = 0;
+
+	/* the flusher starts on the completed writer */
+	pthread_mutex_lock(&_writer->lock);
+	if (_policy->usec > 0) {
+		ret = tty_fdwriter__flusher_start(_writer);
+		if (ret < EOK) {
+			pthread_mutex_unlock(&_writer->lock);
+			pthread_mutex_destroy(&_writer->lock);
+			return ret;
+		}
+	}
+#if defined(M_TTY_FDWRITER_URING)
+	tty_fdwriter__uring_init(_writer);
+#endif
+	pthread_mutex_unlock(&_writer->lock);
+	return EOK;
+}
+
+/* ************************************************************************//**
+ * \brief	Flush of the pending bytes and release of the writer
+ * 			The file descriptor is not closed.
+ * ****************************************************************************/
+void tty_fdwriter__cleanup(struct tty_fdwriter *_writer)
+{
+	if (_writer == NULL) {
+		return;
+	}
+
+	if (_writer->policy.usec > 0) {
+		tty_fdwriter__flusher_stop(_writer);
+	}
+	tty_fdwriter__flush(_writer);
+#if defined(M_TTY_FDWRITER_URING)
+	if (_writer->uring != NULL) {
+		tty_fduring__cleanup(_writer->uring);
+		free(_writer->uring);
+		_writer->uring = NULL;
+	}
+#endif
+	pthread_mutex_destroy(&_writer->lock);
+}
+
+/* ************************************************************************//**
+ * \brief	Append of a record
+ *
+ * \param	_writer	: writer
+ * \param	_buf	: record
+ * \param	_len	: length of the record
+ * \param	_urgent	: record is flushed immediately with M_TTY_FDWRITER_FLUSH_URGENT
+ * \return	number of bytes of the record, or negative errno value on error
+ * ****************************************************************************/
+int tty_fdwriter__write(struct tty_fdwriter *_writer, const char *_buf, size_t _len, int _urgent)
+{
+	size_t offset;
+	int ret;
+
+	pthread_mutex_lock(&_writer->lock);
+
+	if (_len <= (_writer->size - _writer->len)) {
+		offset = _writer->len;
+		memcpy(&_writer->buf[offset], _buf, _len);
+		_writer->len += _len;
+		ret = tty_fdwriter__appended(_writer, offset, _urgent);
+	}
+	else {
+		ret = tty_fdwriter__write_through(_writer, _buf, _len);
+	}
+
+	pthread_mutex_unlock(&_writer->lock);
+	return (ret < EOK) ? ret : (int)_len;
+}
+
+/* ************************************************************************//**
+ * \brief	Formatting of a record directly into the buffer of the writer
+ *
+ * \return	number of bytes of the record, or negative errno value on error
+ * ****************************************************************************/
+int tty_fdwriter__vprintf(struct tty_fdwriter *_writer, int _urgent, const char *_format, va_list _ap)
+{
+	size_t offset, avail;
+	va_list ap;
+	int len, ret;
+
+	pthread_mutex_lock(&_writer->lock);
+
+	offset = _writer->len;
+	avail = _writer->size - offset;
+
+	va_copy(ap, _ap);
+	len = tty_portmux_fmt__vformat(&_writer->buf[offset], avail, _format, ap);
+	va_end(ap);
+
+	if (len < 0) {
+		ret = -ESTD_INVAL;
+	}
+	else if ((size_t)len < avail) {
+		_writer->len += (size_t)len;
+		ret = tty_fdwriter__appended(_writer, offset, _urgent);
+	}
+	else if ((size_t)len < _writer->size) {
+		/* record fits into an empty buffer */
+		ret = tty_fdwriter__flush_locked(_writer);
+		if (ret == EOK) {
+			tty_portmux_fmt__vformat(&_writer->buf[0], _writer->size, _format, _ap);
+			_writer->len = (size_t)len;
+			ret = tty_fdwriter__appended(_writer, 0, _urgent);
+		}
+	}
+	else {
+		/* record exceeds the buffer of the writer */
+		ret = tty_fdwriter__write_windows(_writer, (size_t)len, _format, _ap);
+	}
+
+	pthread_mutex_unlock(&_writer->lock);
+	return (ret < EOK) ? ret : len;
+}
+
+/* ************************************************************************//**
+ * \brief	Write of all pending bytes to the file descriptor, returns after
+ * 			the bytes were written
+ *
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+int tty_fdwriter__flush(struct tty_fdwriter *_writer)
+{
+	int ret;
+
+	pthread_mutex_lock(&_writer->lock);
+	ret = tty_fdwriter__drain_locked(_writer);
+	pthread_mutex_unlock(&_writer->lock);
+	return ret;
+}
+
+/* ************************************************************************//**
+ * \brief	Write of the pending bytes to the current file descriptor and
+ * 			switch to a new one
+ *
+ * \return	previous file descriptor, owned by the caller again
+ * ****************************************************************************/
+int tty_fdwriter__set_fd(struct tty_fdwriter *_writer, int _fd)
+{
+	int fd;
+
+	pthread_mutex_lock(&_writer->lock);
+	tty_fdwriter__drain_locked(_writer);
+	fd = _writer->fd;
+	_writer->fd = _fd;
+	pthread_mutex_unlock(&_writer->lock);
+	return fd;
+}
+
+/* *******************************************************************
+ * static function definitions
+ * ******************************************************************/
+
+static int tty_fdwriter__writev(int _fd, struct iovec *_iov, int _iovcnt)
+{
+	ssize_t written;
+
+	while (_iovcnt > 0) {
+		written = writev(_fd, _iov, _iovcnt);
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return convert_std_errno(errno);
+		}
+
+		while ((_iovcnt > 0) && ((size_t)written >= _iov->iov_len)) {
+			written -= (ssize_t)_iov->iov_len;
+			_iov++;
+			_iovcnt--;
+		}
+
+		if (_iovcnt > 0) {
+			_iov->iov_base = (char*)_iov->iov_base + written;
+			_iov->iov_len -= (size_t)written;
+		}
+	}
+	return EOK;
+}
+
+static int tty_fdwriter__flush_locked(struct tty_fdwriter *_writer)
+{
+	struct iovec iov;
+	int ret;
+
+	if (_writer->len == 0) {
+		return EOK;
+	}
+
+#if defined(M_TTY_FDWRITER_URING)
+	if (_writer->uring != NULL) {
+		return tty_fdwriter__uring_flush(_writer);
+	}
+#endif
+
+	iov.iov_base = _writer->buf;
+	iov.iov_len = _writer->len;
+	ret = tty_fdwriter__writev(_writer->fd, &iov, 1);
+
+	/* pending bytes are dropped on error, the buffer must not block further records */
+	_writer->len = 0;
+	return ret;
+}
+
+/* ************************************************************************//**
+ * \brief	Flush, which returns after the bytes were written
+ * ****************************************************************************/
+static int tty_fdwriter__drain_locked(struct tty_fdwriter *_writer)
+{
+	int ret;
+
+	ret = tty_fdwriter__flush_locked(_writer);
+#if defined(M_TTY_FDWRITER_URING)
+	if (_writer->uring != NULL) {
+		int ret_wait = tty_fduring__wait(_writer->uring);
+		if (ret == EOK) {
+			ret = ret_wait;
+		}
+	}
+#endif
+	return ret;
+}
+
+/* ************************************************************************//**
+ * \brief	Write of the pending bytes and a record which does not fit into
+ * 			the buffer with a single writev()
+ * ****************************************************************************/
+static int tty_fdwriter__write_through(struct tty_fdwriter *_writer, const char *_rec, size_t _len)
+{
+	struct iovec iov[2];
+	int iovcnt = 0, ret;
+
+#if defined(M_TTY_FDWRITER_URING)
+	/* the half in flight precedes the pending bytes */
+	if (_writer->uring != NULL) {
+		tty_fduring__wait(_writer->uring);
+	}
+#endif
+
+	if (_writer->len > 0) {
+		iov[iovcnt].iov_base = _writer->buf;
+		iov[iovcnt].iov_len = _writer->len;
+		iovcnt++;
+	}
+
+	iov[iovcnt].iov_base = (void*)_rec;
+	iov[iovcnt].iov_len = _len;
+	iovcnt++;
+
+	ret = tty_fdwriter__writev(_writer->fd, iov, iovcnt);
+	_writer->len = 0;
+	return ret;
+}
+
+/* ************************************************************************//**
+ * \brief	Write of a record exceeding the buffer, it is formatted into the
+ * 			drained buffer and written through window by window
+ *
+ * A format the windows cannot be formatted of is written cut to the
+ * buffer, the newline at the end of the format is kept.
+ *
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+static int tty_fdwriter__write_windows(struct tty_fdwriter *_writer, size_t _len, const char *_format, va_list _ap)
+{
+	size_t offset, window, formatLen;
+	va_list ap;
+	int ret;
+
+	ret = tty_fdwriter__drain_locked(_writer);
+	if (ret < EOK) {
+		return ret;
+	}
+
+	for (offset = 0; offset < _len; offset += window) {
+		window = ((_len - offset) < _writer->size) ? (_len - offset) : _writer->size;
+		va_copy(ap, _ap);
+		ret = tty_portmux_fmt__vformat_at(&_writer->buf[0], window, offset, _format, ap);
+		va_end(ap);
+		if (ret < EOK) {
+			break;
+		}
+		ret = tty_fdwriter__write_through(_writer, &_writer->buf[0], window);
+		if (ret < EOK) {
+			return ret;
+		}
+	}
+
+	if (offset >= _len) {
+		return EOK;
+	}
+
+	if ((offset > 0) || (_writer->size < 2)) {
+		return -ESTD_INVAL;
+	}
+
+	va_copy(ap, _ap);
+	tty_portmux_fmt__vformat(&_writer->buf[0], _writer->size, _format, ap);
+	va_end(ap);
+	formatLen = strlen(_format);
+	if (_format[formatLen - 1] == '\n') {
+		_writer->buf[_writer->size - 2] = '\n';
+	}
+	return tty_fdwriter__write_through(_writer, &_writer->buf[0], _writer->size - 1);
+}
+
+/* ************************************************************************//**
+ * \brief	Flush decision after a record was appended at _recOffset
+ * ****************************************************************************/
+static int tty_fdwriter__appended(struct tty_fdwriter *_writer, size_t _recOffset, int _urgent)
+{
+	const struct tty_fdwriter_policy *policy = &_writer->policy;
+	uint64_t now;
+
+	if (_urgent && (policy->flags & M_TTY_FDWRITER_FLUSH_URGENT)) {
+		return tty_fdwriter__flush_locked(_writer);
+	}
+
+	if ((policy->flags & M_TTY_FDWRITER_FLUSH_LINE) &&
+		(memchr(&_writer->buf[_recOffset], '\n', _writer->len - _recOffset) != NULL)) {
+		return tty_fdwriter__flush_locked(_writer);
+	}
+
+	if ((policy->bytes > 0) && (_writer->len >= policy->bytes)) {
+		return tty_fdwriter__flush_locked(_writer);
+	}
+
+	if (policy->usec > 0) {
+		now = tty_fdwriter__now();
+		if (_recOffset == 0) {
+			_writer->pendingSince = now;
+			if (_writer->flusherIdle) {
+				pthread_cond_signal(&_writer->wakeup);
+			}
+		}
+		else if ((now - _writer->pendingSince) >= ((uint64_t)policy->usec * 1000)) {
+			return tty_fdwriter__flush_locked(_writer);
+		}
+	}
+	return EOK;
+}
+
+static uint64_t tty_fdwriter__now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(M_TTY_FDWRITER_CLOCK, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+static int tty_fdwriter__flusher_start(struct tty_fdwriter *_writer)
+{
+	pthread_condattr_t attr;
+	int ret;
+
+	ret = pthread_condattr_init(&attr);
+	if (ret == 0) {
+		/* deadlines are taken from the clock of pendingSince */
+		ret = pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+		if (ret == 0) {
+			ret = pthread_cond_init(&_writer->wakeup, &attr);
+		}
+		pthread_condattr_destroy(&attr);
+	}
+	if (ret != 0) {
+		return convert_std_errno(ret);
+	}
+
+	ret = pthread_create(&_writer->flusher, NULL, &tty_fdwriter__flusher, _writer);
+	if (ret != 0) {
+		pthread_cond_destroy(&_writer->wakeup);
+		return convert_std_errno(ret);
+	}
+	return EOK;
+}
+
+static void tty_fdwriter__flusher_stop(struct tty_fdwriter *_writer)
+{
+	pthread_mutex_lock(&_writer->lock);
+	_writer->flusherStop = 1;
+	pthread_cond_signal(&_writer->wakeup);
+	pthread_mutex_unlock(&_writer->lock);
+
+	pthread_join(_writer->flusher, NULL);
+	pthread_cond_destroy(&_writer->wakeup);
+}
+
+/* ************************************************************************//**
+ * \brief	Flusher thread, writes the pending bytes once the oldest is older
+ * 			than policy.usec
+ *
+ * It sleeps without a deadline while the buffer is empty. The deadline is
+ * checked against the precise clock, pendingSince of the coarse clock is
+ * never later.
+ * ****************************************************************************/
+static void* tty_fdwriter__flusher(void *_arg)
+{
+	struct tty_fdwriter *writer = (struct tty_fdwriter*)_arg;
+	struct timespec ts;
+	uint64_t due;
+
+	pthread_mutex_lock(&writer->lock);
+	while (!writer->flusherStop) {
+		if (writer->len == 0) {
+			writer->flusherIdle = 1;
+			pthread_cond_wait(&writer->wakeup, &writer->lock);
+			writer->flusherIdle = 0;
+			continue;
+		}
+
+		due = writer->pendingSince + ((uint64_t)writer->policy.usec * 1000);
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		if ((((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec) >= due) {
+			tty_fdwriter__flush_locked(writer);
+			continue;
+		}
+
+		ts.tv_sec = (time_t)(due / 1000000000ULL);
+		ts.tv_nsec = (long)(due % 1000000000ULL);
+		pthread_cond_timedwait(&writer->wakeup, &writer->lock, &ts);
+	}
+	pthread_mutex_unlock(&writer->lock);
+	return NULL;
+}
+
+#if defined(M_TTY_FDWRITER_URING)
+/* ************************************************************************//**
+ * \brief	Setup of io_uring, the writer keeps on writev() if it fails
+ * ****************************************************************************/
+static void tty_fdwriter__uring_init(struct tty_fdwriter *_writer)
+{
+	struct tty_fduring *uring;
+	struct iovec bufs[2];
+	size_t half;
+
+	_writer->uring = NULL;
+	_writer->base = _writer->buf;
+	_writer->half = 0;
+
+	half = _writer->size / 2;
+	if (half == 0) {
+		return;
+	}
+
+	uring = (struct tty_fduring*)malloc(sizeof(struct tty_fduring));
+	if (uring == NULL) {
+		return;
+	}
+
+	bufs[0].iov_base = _writer->base;
+	bufs[0].iov_len = half;
+	bufs[1].iov_base = _writer->base + half;
+	bufs[1].iov_len = half;
+
+	if (tty_fduring__init(uring, &bufs[0], 2) < EOK) {
+		free(uring);
+		return;
+	}
+
+	_writer->uring = uring;
+	_writer->size = half;
+}
+
+/* ************************************************************************//**
+ * \brief	Submit of the current half and switch to the other one
+ *
+ * The error of the previous write is reported by the next flush.
+ * ****************************************************************************/
+static int tty_fdwriter__uring_flush(struct tty_fdwriter *_writer)
+{
+	struct iovec iov;
+	int ret, ret_submit;
+
+	/* the other half is reused, its write has to be completed */
+	ret = tty_fduring__wait(_writer->uring);
+
+	ret_submit = tty_fduring__submit(_writer->uring, _writer->fd, _writer->half, _writer->buf, _writer->len);
+	if (ret_submit < EOK) {
+		iov.iov_base = _writer->buf;
+		iov.iov_len = _writer->len;
+		ret_submit = tty_fdwriter__writev(_writer->fd, &iov, 1);
+	}
+
+	_writer->half ^= 1;
+	_writer->buf = _writer->base + (_writer->half * _writer->size);
+	_writer->len = 0;
+	return (ret < EOK) ? ret : ret_submit;
+}
+#endif
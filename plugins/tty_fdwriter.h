@@ -0,0 +1,152 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal 
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _TTY_FDWRITER_H_
+#define _TTY_FDWRITER_H_
+
+/* *******************************************************************
+ * includes
+ * ******************************************************************/
+
+/* c runtime */
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+/* *******************************************************************
+ * defines
+ * ******************************************************************/
+#define M_TTY_FDWRITER_FLUSH_LINE		0x0001	/*!< flush if a record contains a newline */
+#define M_TTY_FDWRITER_FLUSH_URGENT		0x0002	/*!< flush records marked as urgent immediately */
+
+/* *******************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ******************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Flush policy of a buffered fd writer
+ * ****************************************************************************/
+struct tty_fdwriter_policy {
+	unsigned int flags;		/*!< M_TTY_FDWRITER_FLUSH_* */
+	size_t bytes;			/*!< flush if N bytes are pending, 0 flushes only at a full buffer */
+	unsigned int usec;		/*!< flush if the oldest pending byte is older, by a flusher thread of the writer, 0 disables */
+};
+
+struct tty_fduring;
+
+/* ************************************************************************//**
+ * \brief	Buffered writer to a file descriptor
+ *
+ * Records are appended to a user space buffer. A record which does not fit
+ * is written together with the pending bytes by a single writev().
+ *
+ * With a policy.usec the writer starts a flusher thread, which writes the
+ * pending bytes once the oldest is older, also if no further record is
+ * appended.
+ *
+ * With M_TTY_FDWRITER_URING the buffer is split into two halves. A flush
+ * submits the current half to io_uring and continues on the other one, the
+ * caller does not wait for the write. writev() is used if io_uring is not
+ * available.
+ * ****************************************************************************/
+struct tty_fdwriter {
+	int fd;
+	pthread_mutex_t lock;
+	char *buf;
+	size_t size;
+	size_t len;
+	uint64_t pendingSince;		/*!< CLOCK_MONOTONIC of the first pending byte in ns */
+	struct tty_fdwriter_policy policy;
+	pthread_t flusher;			/*!< timed flush of policy.usec, only started if usec > 0 */
+	pthread_cond_t wakeup;		/*!< wakes the flusher, signalled at the first pending byte */
+	int flusherIdle;			/*!< flusher waits for a first pending byte */
+	int flusherStop;
+#if defined(M_TTY_FDWRITER_URING)
+	struct tty_fduring *uring;	/*!< NULL at the writev() fallback */
+	char *base;					/*!< buffer of the caller, buf points to one half */
+	unsigned int half;			/*!< index of the half buf points to */
+#endif
+};
+
+/* *******************************************************************
+ * function declarations
+ * ******************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Setup of a writer on an opened file descriptor
+ *
+ * \param	_writer	: writer to setup
+ * \param	_fd		: file descriptor to write to
+ * \param	_buf	: buffer of the writer, owned by the caller
+ * \param	_size	: size of the buffer
+ * \param	_policy	: flush policy
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+int tty_fdwriter__init(struct tty_fdwriter *_writer, int _fd, char *_buf, size_t _size, const struct tty_fdwriter_policy *_policy);
+
+/* ************************************************************************//**
+ * \brief	Flush of the pending bytes and release of the writer
+ * 			The file descriptor is not closed.
+ * ****************************************************************************/
+void tty_fdwriter__cleanup(struct tty_fdwriter *_writer);
+
+/* ************************************************************************//**
+ * \brief	Append of a record
+ *
+ * \param	_writer	: writer
+ * \param	_buf	: record
+ * \param	_len	: length of the record
+ * \param	_urgent	: record is flushed immediately with M_TTY_FDWRITER_FLUSH_URGENT
+ * \return	number of bytes of the record, or negative errno value on error
+ * ****************************************************************************/
+int tty_fdwriter__write(struct tty_fdwriter *_writer, const char *_buf, size_t _len, int _urgent);
+
+/* ************************************************************************//**
+ * \brief	Formatting of a record directly into the buffer of the writer
+ *
+ * \return	number of bytes of the record, or negative errno value on error
+ * ****************************************************************************/
+int tty_fdwriter__vprintf(struct tty_fdwriter *_writer, int _urgent, const char *_format, va_list _ap);
+
+/* ************************************************************************//**
+ * \brief	Write of all pending bytes to the file descriptor, returns after
+ * 			the bytes were written
+ *
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+int tty_fdwriter__flush(struct tty_fdwriter *_writer);
+
+/* ************************************************************************//**
+ * \brief	Write of the pending bytes to the current file descriptor and
+ * 			switch to a new one
+ *
+ * \param	_writer	: writer
+ * \param	_fd		: file descriptor for all further records
+ * \return	previous file descriptor, owned by the caller again
+ * ****************************************************************************/
+int tty_fdwriter__set_fd(struct tty_fdwriter *_writer, int _fd);
+
+#endif /* _TTY_FDWRITER_H_ */
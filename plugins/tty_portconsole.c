@@ -54,6 +54,8 @@
 static int tty_port_console__open(ttydevice_t *_ttydevice);
 static int tty_port_console__close(ttydevice_t *_ttydevice);
 static int tty_port_console__write(ttydevice_t *_ttydevice, enum ttyStreamType _streamType, const char * const _format, va_list _ap);
+static int tty_port_console__write_buf(ttydevice_t *_ttydevice, enum ttyStreamType _streamType, const char *_buf, size_t _len);
+static int tty_port_console__print(console_hdl_t _hdl, const char * const _format, ...);
 static int tty_port_console__put_char(ttydevice_t *_ttydevice, enum ttyStreamType _streamType, char _c);
 static int tty_port_console__read (ttydevice_t *_ttydevice, enum ttyStreamType _streamType, char *_lineptr, size_t *_n, char _delimiter);
 
@@ -67,6 +69,7 @@ static ttydriver_t s_ttydriver_console = {
 	.open = &tty_port_console__open,
 	.close = &tty_port_console__close,
 	.write = &tty_port_console__write,
+	.write_buf = &tty_port_console__write_buf,
 	.put_char =&tty_port_console__put_char,
 	.read = &tty_port_console__read,
 	.ttydevice = NULL
@@ -131,6 +134,26 @@ static int tty_port_console__write(ttydevice_t *_ttydevice, enum ttyStreamType _
 	return ret_val;
 }
 
+static int tty_port_console__write_buf(ttydevice_t *_ttydevice, enum ttyStreamType _streamType, const char *_buf, size_t _len)
+{
+	if (_ttydevice == NULL) {
+		return -ESTD_INVAL;
+	}
+
+	return tty_port_console__print((console_hdl_t)_ttydevice->port_hdl, "%.*s", (int)_len, _buf);
+}
+
+static int tty_port_console__print(console_hdl_t _hdl, const char * const _format, ...)
+{
+	int ret_val;
+	va_list ap;
+
+	va_start(ap, _format);
+	ret_val = lib_console__vprint_debug_message(_hdl, _format, ap);
+	va_end(ap);
+	return ret_val;
+}
+
 static int tty_port_console__put_char(ttydevice_t *_ttydevice, enum ttyStreamType _streamType, char _c)
 {
 	int ret_val;
@@ -0,0 +1,521 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal 
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* *******************************************************************
+ * includes
+ * ******************************************************************/
+
+/* c -runtime */
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+/* frame */
+#include <lib_convention__errno.h>
+#include <lib_convention__mem.h>
+
+/* project */
+#include <lib_ttyportmux_types.h>
+#include "tty_portfile.h"
+#include "tty_fdwriter.h"
+
+/* *******************************************************************
+ * defines
+ * ******************************************************************/
+#ifndef M_TTY_PORT_FILE_PATH
+	#define M_TTY_PORT_FILE_PATH			"ttyportmux_%u.log"		/*!< %u is replaced by the instance */
+#endif
+
+#ifndef M_TTY_PORT_FILE_INSTANCES
+	#define M_TTY_PORT_FILE_INSTANCES		1
+#endif
+
+#ifndef M_TTY_PORT_FILE_BUFSIZE
+	#define M_TTY_PORT_FILE_BUFSIZE			65536
+#endif
+
+#ifndef M_TTY_PORT_FILE_PREALLOC
+	#define M_TTY_PORT_FILE_PREALLOC		(1024 * 1024)
+#endif
+
+#ifndef M_TTY_PORT_FILE_ROTATE_BYTES
+	#define M_TTY_PORT_FILE_ROTATE_BYTES	(16 * 1024 * 1024)
+#endif
+
+#ifndef M_TTY_PORT_FILE_ROTATE_SEC
+	#define M_TTY_PORT_FILE_ROTATE_SEC		0
+#endif
+
+#ifndef M_TTY_PORT_FILE_KEEP
+	#define M_TTY_PORT_FILE_KEEP			3
+#endif
+
+#define M_TTY_PORT_FILE_PATH_MAX			256
+#define M_TTY_PORT_FILE_TICK_SEC			1
+#define M_TTY_PORT_FILE_URGENT(__stream)	(((__stream) == TTYSTREAM_critical) || ((__stream) == TTYSTREAM_error))
+
+/* *******************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ******************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Instance of the file port
+ *
+ * Producers only append to the writer and account the bytes. Extending
+ * the preallocation and the rotation are done by the maintenance thread,
+ * which is woken if a producer crosses kickAt.
+ * ****************************************************************************/
+struct tty_port_file {
+	struct tty_fdwriter writer;
+	char path[M_TTY_PORT_FILE_PATH_MAX];
+	char *buffer;
+	atomic_llong size;			/*!< bytes appended to the current file */
+	atomic_llong kickAt;		/*!< size at which the maintenance thread is woken */
+	atomic_int kicked;
+	long long allocated;		/*!< maintenance thread: preallocated end of the file */
+	uint64_t openedAt;			/*!< maintenance thread: CLOCK_MONOTONIC of the open in s */
+	int opened;
+};
+
+struct tty_port_file_maintenance {
+	pthread_mutex_t lock;
+	pthread_cond_t wakeup;
+	pthread_t thread;
+	unsigned int users;
+	int running;
+};
+
+/* *******************************************************************
+ * static function declarations
+ * ******************************************************************/
+static int tty_port_file__open(ttydevice_t *_ttydevice);
+static int tty_port_file__close(ttydevice_t *_ttydevice);
+static int tty_port_file__write(ttydevice_t *_ttydevice, enum ttyStreamType _streamType, const char * const _format, va_list _ap);
+static int tty_port_file__write_buf(ttydevice_t *_ttydevice, enum ttyStreamType _streamType, const char *_buf, size_t _len);
+static int tty_port_file__put_char(ttydevice_t *_ttydevice, enum ttyStreamType _streamType, char _c);
+static int tty_port_file__flush(ttydevice_t *_ttydevice);
+static int tty_port_file__appended(struct tty_port_file *_file, int _ret);
+static int tty_port_file__open_fd(struct tty_port_file *_file);
+static long long tty_port_file__close_fd(int _fd);
+static void tty_port_file__preallocate(struct tty_port_file *_file, int _fd);
+static void tty_port_file__rotate(struct tty_port_file *_file);
+static void tty_port_file__service(struct tty_port_file *_file);
+static void* tty_port_file__maintenance(void *_arg);
+static uint64_t tty_port_file__now(void);
+
+/* *******************************************************************
+ * (static) variables declarations
+ * ******************************************************************/
+static struct tty_port_file s_files[M_TTY_PORT_FILE_INSTANCES];
+static struct tty_port_file_maintenance s_maintenance = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.wakeup = PTHREAD_COND_INITIALIZER
+};
+
+static const struct tty_fdwriter_policy s_filePolicy = {
+	.flags = M_TTY_FDWRITER_FLUSH_URGENT,
+	.bytes = 0,
+	.usec = 0
+};
+
+static ttydriver_t s_ttydriver_file= {
+	.info.deviceName = "TTYDEVICE_file",
+	.info.deviceType = TTYDEVICE_file,
+	.info.deviceNumber = M_TTY_PORT_FILE_INSTANCES,
+	.open = &tty_port_file__open,
+	.close = &tty_port_file__close,
+	.write = &tty_port_file__write,
+	.write_buf = &tty_port_file__write_buf,
+	.put_char = &tty_port_file__put_char,
+	.read = NULL,
+	.flush = &tty_port_file__flush,
+	.ttydevice = NULL
+	};
+
+/* *******************************************************************
+ * \brief	sharing the interfaces
+ * ---------
+ * \remark  The execution of a thread stops only at cancellation points
+ * ---------
+ * \param	_share	[in/out] :	pointer for sharing the interfaces
+ * ---------
+ * \return	'0', if successful, < '0' if not successful
+ * ******************************************************************/
+int tty_portfile__share_if(void)
+{
+	tty_driver_register(&s_ttydriver_file);
+	return EOK;
+}
+
+
+/* *******************************************************************
+ * static function definition
+ * ******************************************************************/
+
+static int tty_port_file__open(ttydevice_t *_ttydevice)
+{
+	struct tty_port_file *file;
+	int fd, ret_val;
+
+	if ((_ttydevice == NULL) || (_ttydevice->deviceIndex >= M_TTY_PORT_FILE_INSTANCES)) {
+		return -ESTD_INVAL;
+	}
+
+	file = &s_files[_ttydevice->deviceIndex];
+	if (file->opened) {
+		return -ESTD_BUSY;
+	}
+
+	snprintf(&file->path[0], sizeof(file->path), M_TTY_PORT_FILE_PATH, _ttydevice->deviceIndex);
+
+	file->buffer = (char*)alloc_memory(1, M_TTY_PORT_FILE_BUFSIZE);
+	if (file->buffer == NULL) {
+		return -ESTD_NOMEM;
+	}
+
+	fd = tty_port_file__open_fd(file);
+	if (fd < EOK) {
+		ret_val = fd;
+		goto ERR_OPEN;
+	}
+
+	ret_val = tty_fdwriter__init(&file->writer, fd, file->buffer, M_TTY_PORT_FILE_BUFSIZE, &s_filePolicy);
+	if (ret_val < EOK) {
+		goto ERR_WRITER;
+	}
+
+	pthread_mutex_lock(&s_maintenance.lock);
+	if (s_maintenance.users++ == 0) {
+		s_maintenance.running = 1;
+		ret_val = pthread_create(&s_maintenance.thread, NULL, &tty_port_file__maintenance, NULL);
+		if (ret_val != 0) {
+			s_maintenance.users = 0;
+			s_maintenance.running = 0;
+			pthread_mutex_unlock(&s_maintenance.lock);
+			ret_val = convert_std_errno(ret_val);
+			goto ERR_THREAD;
+		}
+	}
+	file->opened = 1;
+	pthread_mutex_unlock(&s_maintenance.lock);
+
+	_ttydevice->port_hdl = file;
+	return EOK;
+
+	ERR_THREAD:
+	tty_fdwriter__cleanup(&file->writer);
+	ERR_WRITER:
+	close(fd);
+	ERR_OPEN:
+	free_memory(file->buffer);
+	file->buffer = NULL;
+	return ret_val;
+}
+
+static int tty_port_file__close(ttydevice_t *_ttydevice)
+{
+	struct tty_port_file *file;
+	pthread_t thread;
+	int stop;
+
+	if ((_ttydevice == NULL) || (_ttydevice->port_hdl == NULL)) {
+		return -ESTD_INVAL;
+	}
+
+	file = (struct tty_port_file*)_ttydevice->port_hdl;
+
+	/* the maintenance thread serves the instances under the lock */
+	pthread_mutex_lock(&s_maintenance.lock);
+	file->opened = 0;
+	stop = (--s_maintenance.users == 0);
+	if (stop) {
+		s_maintenance.running = 0;
+		pthread_cond_signal(&s_maintenance.wakeup);
+	}
+	thread = s_maintenance.thread;
+	pthread_mutex_unlock(&s_maintenance.lock);
+
+	if (stop) {
+		pthread_join(thread, NULL);
+	}
+
+	tty_fdwriter__cleanup(&file->writer);
+	tty_port_file__close_fd(file->writer.fd);
+	free_memory(file->buffer);
+	file->buffer = NULL;
+	_ttydevice->port_hdl = NULL;
+	return EOK;
+}
+
+static int tty_port_file__write(ttydevice_t *_ttydevice, enum ttyStreamType _streamType, const char * const _format, va_list _ap)
+{
+	struct tty_port_file *file;
+
+	if ((_ttydevice == NULL) || (_ttydevice->port_hdl == NULL)) {
+		return -ESTD_INVAL;
+	}
+
+	file = (struct tty_port_file*)_ttydevice->port_hdl;
+	return tty_port_file__appended(file, tty_fdwriter__vprintf(&file->writer, M_TTY_PORT_FILE_URGENT(_streamType), _format, _ap));
+}
+
+static int tty_port_file__write_buf(ttydevice_t *_ttydevice, enum ttyStreamType _streamType, const char *_buf, size_t _len)
+{
+	struct tty_port_file *file;
+
+	if ((_ttydevice == NULL) || (_ttydevice->port_hdl == NULL)) {
+		return -ESTD_INVAL;
+	}
+
+	file = (struct tty_port_file*)_ttydevice->port_hdl;
+	return tty_port_file__appended(file, tty_fdwriter__write(&file->writer, _buf, _len, M_TTY_PORT_FILE_URGENT(_streamType)));
+}
+
+static int tty_port_file__put_char(ttydevice_t *_ttydevice, enum ttyStreamType _streamType, char _c)
+{
+	return tty_port_file__write_buf(_ttydevice, _streamType, &_c, 1);
+}
+
+static int tty_port_file__flush(ttydevice_t *_ttydevice)
+{
+	if ((_ttydevice == NULL) || (_ttydevice->port_hdl == NULL)) {
+		return -ESTD_INVAL;
+	}
+
+	return tty_fdwriter__flush(&((struct tty_port_file*)_ttydevice->port_hdl)->writer);
+}
+
+/* ************************************************************************//**
+ * \brief	Account of an appended record, wakes the maintenance thread once
+ * 			the file reaches the next preallocation or rotation mark
+ * ****************************************************************************/
+static int tty_port_file__appended(struct tty_port_file *_file, int _ret)
+{
+	long long size;
+
+	if (_ret <= 0) {
+		return _ret;
+	}
+
+	size = atomic_fetch_add_explicit(&_file->size, _ret, memory_order_relaxed) + _ret;
+	if ((size >= atomic_load_explicit(&_file->kickAt, memory_order_relaxed)) &&
+		!atomic_exchange_explicit(&_file->kicked, 1, memory_order_relaxed)) {
+		/* a busy maintenance thread picks the kick up at the next tick */
+		if (pthread_mutex_trylock(&s_maintenance.lock) == 0) {
+			pthread_cond_signal(&s_maintenance.wakeup);
+			pthread_mutex_unlock(&s_maintenance.lock);
+		}
+	}
+	return _ret;
+}
+
+/* ************************************************************************//**
+ * \brief	Open of the file at the path of the instance
+ *
+ * An existing file is continued.
+ *
+ * \param	_file	: instance
+ * \return	file descriptor if successful, or negative errno value on error
+ * ****************************************************************************/
+static int tty_port_file__open_fd(struct tty_port_file *_file)
+{
+	struct stat st;
+	int fd;
+
+	fd = open(&_file->path[0], O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		return convert_std_errno(errno);
+	}
+
+	if (fstat(fd, &st) < 0) {
+		st.st_size = 0;
+	}
+
+	atomic_store(&_file->size, (long long)st.st_size);
+	_file->allocated = (long long)st.st_size;
+	_file->openedAt = tty_port_file__now();
+	tty_port_file__preallocate(_file, fd);
+	return fd;
+}
+
+/* ************************************************************************//**
+ * \brief	Release of the preallocated blocks behind the data and close
+ *
+ * \return	size of the file, or negative errno value on error
+ * ****************************************************************************/
+static long long tty_port_file__close_fd(int _fd)
+{
+	struct stat st;
+	long long ret;
+
+	if (fstat(_fd, &st) == 0) {
+		ret = (long long)st.st_size;
+		if (ftruncate(_fd, st.st_size) < 0) {
+			/* the file keeps the preallocated blocks */
+		}
+	}
+	else {
+		ret = convert_std_errno(errno);
+	}
+
+	close(_fd);
+	return ret;
+}
+
+/* ************************************************************************//**
+ * \brief	Extension of the preallocated blocks by M_TTY_PORT_FILE_PREALLOC,
+ * 			the file size is not changed
+ * ****************************************************************************/
+static void tty_port_file__preallocate(struct tty_port_file *_file, int _fd)
+{
+	long long kickAt;
+
+	if (M_TTY_PORT_FILE_PREALLOC > 0) {
+#if defined(FALLOC_FL_KEEP_SIZE)
+		/* not supported by each file system, the file grows on demand then */
+		fallocate(_fd, FALLOC_FL_KEEP_SIZE, (off_t)_file->allocated, M_TTY_PORT_FILE_PREALLOC);
+#endif
+		_file->allocated += M_TTY_PORT_FILE_PREALLOC;
+		kickAt = _file->allocated - (M_TTY_PORT_FILE_PREALLOC / 2);
+	}
+	else {
+		kickAt = INT64_MAX;
+	}
+
+	if ((M_TTY_PORT_FILE_ROTATE_BYTES > 0) && (kickAt > M_TTY_PORT_FILE_ROTATE_BYTES)) {
+		kickAt = M_TTY_PORT_FILE_ROTATE_BYTES;
+	}
+	atomic_store_explicit(&_file->kickAt, kickAt, memory_order_relaxed);
+}
+
+/* ************************************************************************//**
+ * \brief	Rename of the current file to <path>.1 and switch of the writer to
+ * 			a new file
+ *
+ * The producers keep writing to the renamed file until the switch, they are
+ * only held for the flush of the pending bytes to the old descriptor.
+ * ****************************************************************************/
+static void tty_port_file__rotate(struct tty_port_file *_file)
+{
+	char from[M_TTY_PORT_FILE_PATH_MAX + 8], to[M_TTY_PORT_FILE_PATH_MAX + 8];
+	long long oldSize;
+	int i, fd, oldFd;
+
+	for (i = M_TTY_PORT_FILE_KEEP - 1; i > 0; i--) {
+		snprintf(&from[0], sizeof(from), "%s.%d", &_file->path[0], i);
+		snprintf(&to[0], sizeof(to), "%s.%d", &_file->path[0], i + 1);
+		rename(&from[0], &to[0]);
+	}
+
+	if (M_TTY_PORT_FILE_KEEP > 0) {
+		snprintf(&to[0], sizeof(to), "%s.1", &_file->path[0]);
+		rename(&_file->path[0], &to[0]);
+	}
+
+	fd = open(&_file->path[0], O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		/* retried at the next tick, the records go to the renamed file meanwhile */
+		return;
+	}
+	_file->allocated = 0;
+	tty_port_file__preallocate(_file, fd);
+
+	oldFd = tty_fdwriter__set_fd(&_file->writer, fd);
+	_file->openedAt = tty_port_file__now();
+
+	/* bytes appended after the switch stay accounted to the new file */
+	oldSize = tty_port_file__close_fd(oldFd);
+	if (oldSize >= 0) {
+		atomic_fetch_sub(&_file->size, oldSize);
+	}
+	else {
+		atomic_store(&_file->size, 0);
+	}
+}
+
+static void tty_port_file__service(struct tty_port_file *_file)
+{
+	long long size;
+	int rotate;
+
+	atomic_store_explicit(&_file->kicked, 0, memory_order_relaxed);
+	size = atomic_load_explicit(&_file->size, memory_order_relaxed);
+
+	rotate = (M_TTY_PORT_FILE_ROTATE_BYTES > 0) && (size >= M_TTY_PORT_FILE_ROTATE_BYTES);
+#if (M_TTY_PORT_FILE_ROTATE_SEC > 0)
+	rotate |= (size > 0) && ((tty_port_file__now() - _file->openedAt) >= M_TTY_PORT_FILE_ROTATE_SEC);
+#endif
+
+	if (rotate) {
+		tty_port_file__rotate(_file);
+	}
+	else if ((M_TTY_PORT_FILE_PREALLOC > 0) && (size >= (_file->allocated - (M_TTY_PORT_FILE_PREALLOC / 2)))) {
+		tty_port_file__preallocate(_file, _file->writer.fd);
+	}
+
+	/* records do not stay in the buffer longer than a tick */
+	tty_fdwriter__flush(&_file->writer);
+}
+
+/* ************************************************************************//**
+ * \brief	Maintenance thread, serves all instances at a kick or every tick
+ * ****************************************************************************/
+static void* tty_port_file__maintenance(void *_arg)
+{
+	struct timespec deadline;
+	unsigned int i;
+
+	(void)_arg;
+
+	pthread_mutex_lock(&s_maintenance.lock);
+	while (s_maintenance.running) {
+		clock_gettime(CLOCK_REALTIME, &deadline);
+		deadline.tv_sec += M_TTY_PORT_FILE_TICK_SEC;
+		pthread_cond_timedwait(&s_maintenance.wakeup, &s_maintenance.lock, &deadline);
+
+		for (i = 0; i < M_TTY_PORT_FILE_INSTANCES; i++) {
+			if (s_files[i].opened) {
+				tty_port_file__service(&s_files[i]);
+			}
+		}
+	}
+	pthread_mutex_unlock(&s_maintenance.lock);
+	return NULL;
+}
+
+static uint64_t tty_port_file__now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec;
+}
@@ -0,0 +1,363 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal 
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* *******************************************************************
+ * includes
+ * ******************************************************************/
+
+/* c -runtime */
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+
+/* frame */
+#include <lib_convention__errno.h>
+#include <lib_convention__mem.h>
+
+/* project */
+#include <lib_ttyportmux_types.h>
+#include <lib_ttyportmux_memory.h>
+#include "tty_portmemory.h"
+#include "tty_portmux_arena.h"
+#include "tty_portmux_fmt.h"
+#include "tty_portmux_stats.h"
+
+/* *******************************************************************
+ * defines
+ * ******************************************************************/
+#ifndef M_TTY_PORT_MEMORY_SIZE
+	#define M_TTY_PORT_MEMORY_SIZE		65536
+#endif
+
+#define M_TTY_PORT_MEMORY_SCRATCH		512
+
+/* *******************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ******************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Capture buffer, written as ring of the most recent bytes
+ * ****************************************************************************/
+struct tty_port_memory {
+	atomic_flag lock;
+	size_t written;			/*!< total bytes, the ring position is written % size */
+	unsigned int pending;	/*!< long records reserved but not yet copied */
+	char buffer[M_TTY_PORT_MEMORY_SIZE];
+};
+
+/* *******************************************************************
+ * static function declarations
+ * ******************************************************************/
+static int tty_port_memory__open(ttydevice_t *_ttydevice);
+static int tty_port_memory__close(ttydevice_t *_ttydevice);
+static int tty_port_memory__write(ttydevice_t *_ttydevice, enum ttyStreamType _streamType, const char * const _format, va_list _ap);
+static int tty_port_memory__write_buf(ttydevice_t *_ttydevice, enum ttyStreamType _streamType, const char *_buf, size_t _len);
+static int tty_port_memory__put_char(ttydevice_t *_ttydevice, enum ttyStreamType _streamType, char _c);
+static void tty_port_memory__append(struct tty_port_memory *_memory, const char *_buf, size_t _len);
+static void tty_port_memory__copy(struct tty_port_memory *_memory, size_t _pos, const char *_buf, size_t _len);
+static int tty_port_memory__append_format(struct tty_port_memory *_memory, char *_chunk, size_t _size, size_t _len, const char *_format, va_list _ap);
+
+/* *******************************************************************
+ * (static) variables declarations
+ * ******************************************************************/
+static struct tty_port_memory s_memory = { .lock = ATOMIC_FLAG_INIT };
+
+static ttydriver_t s_ttydriver_memory= {
+	.info.deviceName = "TTYDEVICE_memory",
+	.info.deviceType = TTYDEVICE_memory,
+	.info.deviceNumber = 1,
+	.open = &tty_port_memory__open,
+	.close = &tty_port_memory__close,
+	.write = &tty_port_memory__write,
+	.write_buf = &tty_port_memory__write_buf,
+	.put_char = &tty_port_memory__put_char,
+	.read = NULL,
+	.flush = NULL,
+	.ttydevice = NULL
+	};
+
+/* *******************************************************************
+ * \brief	sharing the interfaces
+ * ---------
+ * \remark  The execution of a thread stops only at cancellation points
+ * ---------
+ * \param	_share	[in/out] :	pointer for sharing the interfaces
+ * ---------
+ * \return	'0', if successful, < '0' if not successful
+ * ******************************************************************/
+int tty_portmemory__share_if(void)
+{
+	tty_driver_register(&s_ttydriver_memory);
+	return EOK;
+}
+
+/* ************************************************************************//**
+ * \brief	Copy of the output captured by the memory ttydevice
+ *
+ * \param   _buf [out]	: destination of the captured output
+ * \param   _size		: size of _buf
+ * \return	number of bytes copied without the NUL, or negative errno value on error
+ * ****************************************************************************/
+int lib_ttyportmux_memory__get(char *_buf, size_t _size)
+{
+	size_t len, start, first;
+
+	if (_buf == NULL) {
+		return -EPAR_NULL;
+	}
+
+	if (_size == 0) {
+		return -ESTD_INVAL;
+	}
+
+	/* long records being formatted are waited for */
+	for (;;) {
+		while (atomic_flag_test_and_set_explicit(&s_memory.lock, memory_order_acquire));
+		if (s_memory.pending == 0) {
+			break;
+		}
+		atomic_flag_clear_explicit(&s_memory.lock, memory_order_release);
+	}
+
+	len = (s_memory.written < M_TTY_PORT_MEMORY_SIZE) ? s_memory.written : M_TTY_PORT_MEMORY_SIZE;
+	start = (s_memory.written - len) % M_TTY_PORT_MEMORY_SIZE;
+
+	/* the most recent bytes are kept if _buf is smaller than the capture */
+	if (len > (_size - 1)) {
+		start = (start + (len - (_size - 1))) % M_TTY_PORT_MEMORY_SIZE;
+		len = _size - 1;
+	}
+
+	first = M_TTY_PORT_MEMORY_SIZE - start;
+	if (first > len) {
+		first = len;
+	}
+	memcpy(_buf, &s_memory.buffer[start], first);
+	memcpy(_buf + first, &s_memory.buffer[0], len - first);
+
+	atomic_flag_clear_explicit(&s_memory.lock, memory_order_release);
+
+	_buf[len] = 0;
+	return (int)len;
+}
+
+/* ************************************************************************//**
+ * \brief	Number of bytes written to the memory ttydevice since the last
+ * 			reset, including overwritten bytes
+ * ****************************************************************************/
+size_t lib_ttyportmux_memory__written(void)
+{
+	size_t written;
+
+	while (atomic_flag_test_and_set_explicit(&s_memory.lock, memory_order_acquire));
+	written = s_memory.written;
+	atomic_flag_clear_explicit(&s_memory.lock, memory_order_release);
+	return written;
+}
+
+/* ************************************************************************//**
+ * \brief	Discard of the captured output
+ * ****************************************************************************/
+int lib_ttyportmux_memory__reset(void)
+{
+	while (atomic_flag_test_and_set_explicit(&s_memory.lock, memory_order_acquire));
+	s_memory.written = 0;
+	atomic_flag_clear_explicit(&s_memory.lock, memory_order_release);
+	return EOK;
+}
+
+/* *******************************************************************
+ * static function definition
+ * ******************************************************************/
+
+static int tty_port_memory__open(ttydevice_t *_ttydevice)
+{
+	if (_ttydevice == NULL) {
+		return -ESTD_INVAL;
+	}
+
+	_ttydevice->port_hdl = &s_memory;
+	return EOK;
+}
+
+static int tty_port_memory__close(ttydevice_t *_ttydevice)
+{
+	if (_ttydevice == NULL) {
+		return -ESTD_INVAL;
+	}
+
+	_ttydevice->port_hdl = NULL;
+	return EOK;
+}
+
+static int tty_port_memory__write(ttydevice_t *_ttydevice, enum ttyStreamType _streamType, const char * const _format, va_list _ap)
+{
+	char scratch[M_TTY_PORT_MEMORY_SCRATCH];
+	size_t size;
+	va_list ap;
+	char *buf;
+	int len;
+
+	if ((_ttydevice == NULL) || (_ttydevice->port_hdl == NULL)) {
+		return -ESTD_INVAL;
+	}
+
+	buf = tty_portmux_arena__get(TTY_ARENA_driver, &size);
+	if (buf == NULL) {
+		buf = &scratch[0];
+		size = sizeof(scratch);
+	}
+
+	va_copy(ap,_ap);
+	len = tty_portmux_fmt__vformat(buf, size, _format, ap);
+	va_end(ap);
+	if (len < 0) {
+		return -ESTD_INVAL;
+	}
+
+	/* longer messages are formatted in windows of buf into the ring */
+	if ((size_t)len >= size) {
+		if (tty_port_memory__append_format((struct tty_port_memory*)_ttydevice->port_hdl, buf, size, (size_t)len, _format, _ap) != EOK) {
+			tty_portmux_stats__truncate(_streamType);
+		}
+		return len;
+	}
+
+	tty_port_memory__append((struct tty_port_memory*)_ttydevice->port_hdl, buf, (size_t)len);
+	return len;
+}
+
+static int tty_port_memory__write_buf(ttydevice_t *_ttydevice, enum ttyStreamType _streamType, const char *_buf, size_t _len)
+{
+	(void)_streamType;
+
+	if ((_ttydevice == NULL) || (_ttydevice->port_hdl == NULL)) {
+		return -ESTD_INVAL;
+	}
+
+	tty_port_memory__append((struct tty_port_memory*)_ttydevice->port_hdl, _buf, _len);
+	return (int)_len;
+}
+
+static int tty_port_memory__put_char(ttydevice_t *_ttydevice, enum ttyStreamType _streamType, char _c)
+{
+	return tty_port_memory__write_buf(_ttydevice, _streamType, &_c, 1);
+}
+
+static void tty_port_memory__append(struct tty_port_memory *_memory, const char *_buf, size_t _len)
+{
+	while (atomic_flag_test_and_set_explicit(&_memory->lock, memory_order_acquire));
+
+	/* only the tail of a record longer than the buffer is kept */
+	_memory->written += _len;
+	tty_port_memory__copy(_memory, _memory->written - _len, _buf, _len);
+
+	atomic_flag_clear_explicit(&_memory->lock, memory_order_release);
+}
+
+/* copy of _len bytes to the absolute position _pos, only the part still
+ * inside the ring window is written, called with the lock held */
+static void tty_port_memory__copy(struct tty_port_memory *_memory, size_t _pos, const char *_buf, size_t _len)
+{
+	size_t pos, first, live;
+
+	/* a reset or newer records may have moved the window past the range */
+	live = (_memory->written > M_TTY_PORT_MEMORY_SIZE) ? (_memory->written - M_TTY_PORT_MEMORY_SIZE) : 0;
+	if (_pos < live) {
+		if ((_pos + _len) <= live) {
+			return;
+		}
+		_buf += live - _pos;
+		_len -= live - _pos;
+		_pos = live;
+	}
+	if ((_pos + _len) > _memory->written) {
+		if (_pos >= _memory->written) {
+			return;
+		}
+		_len = _memory->written - _pos;
+	}
+
+	pos = _pos % M_TTY_PORT_MEMORY_SIZE;
+	first = M_TTY_PORT_MEMORY_SIZE - pos;
+	if (first > _len) {
+		first = _len;
+	}
+	memcpy(&_memory->buffer[pos], _buf, first);
+	memcpy(&_memory->buffer[0], _buf + first, _len - first);
+}
+
+/* the record is reserved first and formatted window by window into _chunk
+ * without the lock, the lock is only held to copy each window */
+static int tty_port_memory__append_format(struct tty_port_memory *_memory, char *_chunk, size_t _size, size_t _len, const char *_format, va_list _ap)
+{
+	size_t start, done, n, skip;
+	va_list ap;
+	int ret = EOK;
+
+	/* only the tail of a record longer than the buffer is kept */
+	skip = 0;
+	if (_len > M_TTY_PORT_MEMORY_SIZE) {
+		skip = _len - M_TTY_PORT_MEMORY_SIZE;
+		_len = M_TTY_PORT_MEMORY_SIZE;
+	}
+
+	while (atomic_flag_test_and_set_explicit(&_memory->lock, memory_order_acquire));
+	start = _memory->written + skip;
+	_memory->written += skip + _len;
+	_memory->pending++;
+	atomic_flag_clear_explicit(&_memory->lock, memory_order_release);
+
+	for (done = 0; done < _len; done += n) {
+		n = ((_len - done) < _size) ? (_len - done) : _size;
+
+		if (ret == EOK) {
+			va_copy(ap,_ap);
+			if (tty_portmux_fmt__vformat_at(_chunk, n, skip + done, _format, ap) < EOK) {
+				ret = -ESTD_INVAL;
+			}
+			va_end(ap);
+		}
+
+		/* the reserved space behind a failed window is blanked, the
+		 * newline at the end is kept */
+		if (ret != EOK) {
+			memset(_chunk, ' ', n);
+			if (((done + n) == _len) && (_format[strlen(_format) - 1] == '\n')) {
+				_chunk[n - 1] = '\n';
+			}
+		}
+
+		while (atomic_flag_test_and_set_explicit(&_memory->lock, memory_order_acquire));
+		tty_port_memory__copy(_memory, start + done, _chunk, n);
+		atomic_flag_clear_explicit(&_memory->lock, memory_order_release);
+	}
+
+	while (atomic_flag_test_and_set_explicit(&_memory->lock, memory_order_acquire));
+	_memory->pending--;
+	atomic_flag_clear_explicit(&_memory->lock, memory_order_release);
+	return ret;
+}
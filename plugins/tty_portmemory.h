@@ -0,0 +1,47 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal 
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _TTY_PORT_MEMORY_H_
+#define _TTY_PORT_MEMORY_H_
+
+/* *******************************************************************
+ * includes
+ * ******************************************************************/
+
+/* project */
+#include <tty_portplugin_if.h>
+
+/* *******************************************************************
+ * \brief	sharing the interfaces
+ * ---------
+ * \remark  The execution of a thread stops only at cancellation points
+ * ---------
+ * \param	_share	[in/out] :	pointer for sharing the interfaces
+ * ---------
+ * \return	'0', if successful, < '0' if not successful
+ * ******************************************************************/
+int tty_portmemory__share_if(void);
+
+#endif /* _TTY_PORT_MEMORY_H_ */
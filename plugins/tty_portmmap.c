@@ -0,0 +1,327 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal 
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* *******************************************************************
+ * includes
+ * ******************************************************************/
+
+/* c -runtime */
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* frame */
+#include <lib_convention__errno.h>
+
+/* project */
+#include <lib_ttyportmux_types.h>
+#include <lib_ttyportmux_mmap.h>
+#include "tty_portmmap.h"
+#include "tty_portmux_fmt.h"
+#include "tty_portmux_stats.h"
+
+/* *******************************************************************
+ * defines
+ * ******************************************************************/
+#ifndef M_TTY_PORT_MMAP_PATH
+	#define M_TTY_PORT_MMAP_PATH		"ttyportmux.ring"
+#endif
+
+#ifndef M_TTY_PORT_MMAP_SIZE
+	#define M_TTY_PORT_MMAP_SIZE		(1024 * 1024)
+#endif
+
+#ifndef M_TTY_PORT_MMAP_RECORD_MAX
+	#define M_TTY_PORT_MMAP_RECORD_MAX	512		/*!< longer messages are truncated */
+#endif
+
+#define M_TTY_PORT_MMAP_PATH_MAX		256
+
+_Static_assert((M_TTY_PORT_MMAP_SIZE & (M_TTY_PORT_MMAP_SIZE - 1)) == 0, "M_TTY_PORT_MMAP_SIZE is no power of two");
+_Static_assert(M_TTY_PORT_MMAP_RECORD_MAX < (M_TTY_PORT_MMAP_SIZE / 4), "M_TTY_PORT_MMAP_RECORD_MAX exceeds the ring");
+_Static_assert(sizeof(struct ttyMmapHeader) <= M_TTYMMAP_HEADER_SIZE, "mmap header exceeds M_TTYMMAP_HEADER_SIZE");
+
+/* *******************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ******************************************************************/
+struct tty_port_mmap {
+	int fd;
+	size_t mapSize;
+	struct ttyMmapHeader *header;
+	char *ring;
+	uint64_t mask;
+};
+
+/* *******************************************************************
+ * static function declarations
+ * ******************************************************************/
+static int tty_port_mmap__open(ttydevice_t *_ttydevice);
+static int tty_port_mmap__close(ttydevice_t *_ttydevice);
+static int tty_port_mmap__write(ttydevice_t *_ttydevice, enum ttyStreamType _streamType, const char * const _format, va_list _ap);
+static int tty_port_mmap__write_buf(ttydevice_t *_ttydevice, enum ttyStreamType _streamType, const char *_buf, size_t _len);
+static int tty_port_mmap__put_char(ttydevice_t *_ttydevice, enum ttyStreamType _streamType, char _c);
+static void tty_port_mmap__append(struct tty_port_mmap *_mmap, enum ttyStreamType _streamType, const char *_buf, size_t _len);
+static void tty_port_mmap__keep_previous(const char *_path);
+
+/* *******************************************************************
+ * (static) variables declarations
+ * ******************************************************************/
+static struct tty_port_mmap s_mmap = { .fd = -1 };
+
+static ttydriver_t s_ttydriver_mmap= {
+	.info.deviceName = "TTYDEVICE_mmap",
+	.info.deviceType = TTYDEVICE_mmap,
+	.info.deviceNumber = 1,
+	.open = &tty_port_mmap__open,
+	.close = &tty_port_mmap__close,
+	.write = &tty_port_mmap__write,
+	.write_buf = &tty_port_mmap__write_buf,
+	.put_char = &tty_port_mmap__put_char,
+	.read = NULL,
+	.flush = NULL,
+	.ttydevice = NULL
+	};
+
+/* *******************************************************************
+ * \brief	sharing the interfaces
+ * ---------
+ * \remark  The execution of a thread stops only at cancellation points
+ * ---------
+ * \param	_share	[in/out] :	pointer for sharing the interfaces
+ * ---------
+ * \return	'0', if successful, < '0' if not successful
+ * ******************************************************************/
+int tty_portmmap__share_if(void)
+{
+	tty_driver_register(&s_ttydriver_mmap);
+	return EOK;
+}
+
+
+/* *******************************************************************
+ * static function definition
+ * ******************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Creation of a new ring file, the ring of a previous run is kept
+ * 			as <path>.1
+ * ****************************************************************************/
+static int tty_port_mmap__open(ttydevice_t *_ttydevice)
+{
+	struct ttyMmapHeader *header;
+	void *map;
+	int fd, ret_val;
+
+	if (_ttydevice == NULL) {
+		return -ESTD_INVAL;
+	}
+
+	if (s_mmap.header != NULL) {
+		return -ESTD_BUSY;
+	}
+
+	tty_port_mmap__keep_previous(M_TTY_PORT_MMAP_PATH);
+
+	fd = open(M_TTY_PORT_MMAP_PATH, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		return convert_std_errno(errno);
+	}
+
+	s_mmap.mapSize = M_TTYMMAP_HEADER_SIZE + M_TTY_PORT_MMAP_SIZE;
+	if (ftruncate(fd, (off_t)s_mmap.mapSize) < 0) {
+		ret_val = convert_std_errno(errno);
+		goto ERR_FILE;
+	}
+
+	map = mmap(NULL, s_mmap.mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (map == MAP_FAILED) {
+		ret_val = convert_std_errno(errno);
+		goto ERR_FILE;
+	}
+
+	header = (struct ttyMmapHeader*)map;
+	header->version = M_TTYMMAP_VERSION;
+	header->headerSize = M_TTYMMAP_HEADER_SIZE;
+	header->ringSize = M_TTY_PORT_MMAP_SIZE;
+	header->write = 0;
+	header->commit = 0;
+	/* the magic marks a complete header */
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	memcpy(&header->magic[0], M_TTYMMAP_MAGIC, sizeof(header->magic));
+
+	s_mmap.fd = fd;
+	s_mmap.header = header;
+	s_mmap.ring = (char*)map + M_TTYMMAP_HEADER_SIZE;
+	s_mmap.mask = M_TTY_PORT_MMAP_SIZE - 1;
+
+	_ttydevice->port_hdl = &s_mmap;
+	return EOK;
+
+	ERR_FILE:
+	close(fd);
+	return ret_val;
+}
+
+static int tty_port_mmap__close(ttydevice_t *_ttydevice)
+{
+	struct tty_port_mmap *mmap_hdl;
+
+	if ((_ttydevice == NULL) || (_ttydevice->port_hdl == NULL)) {
+		return -ESTD_INVAL;
+	}
+
+	mmap_hdl = (struct tty_port_mmap*)_ttydevice->port_hdl;
+	msync(mmap_hdl->header, mmap_hdl->mapSize, MS_ASYNC);
+	munmap(mmap_hdl->header, mmap_hdl->mapSize);
+	close(mmap_hdl->fd);
+
+	mmap_hdl->header = NULL;
+	mmap_hdl->ring = NULL;
+	mmap_hdl->fd = -1;
+	_ttydevice->port_hdl = NULL;
+	return EOK;
+}
+
+static int tty_port_mmap__write(ttydevice_t *_ttydevice, enum ttyStreamType _streamType, const char * const _format, va_list _ap)
+{
+	char scratch[M_TTY_PORT_MMAP_RECORD_MAX];
+	int len;
+
+	if ((_ttydevice == NULL) || (_ttydevice->port_hdl == NULL)) {
+		return -ESTD_INVAL;
+	}
+
+	len = tty_portmux_fmt__vformat(&scratch[0], sizeof(scratch), _format, _ap);
+	if (len < 0) {
+		return -ESTD_INVAL;
+	}
+
+	/* cut to the record, the newline at the end is kept */
+	if ((size_t)len >= sizeof(scratch)) {
+		len = sizeof(scratch) - 1;
+		if (_format[strlen(_format) - 1] == '\n') {
+			scratch[len - 1] = '\n';
+		}
+		tty_portmux_stats__truncate(_streamType);
+	}
+
+	tty_port_mmap__append((struct tty_port_mmap*)_ttydevice->port_hdl, _streamType, &scratch[0], (size_t)len);
+	return len;
+}
+
+static int tty_port_mmap__write_buf(ttydevice_t *_ttydevice, enum ttyStreamType _streamType, const char *_buf, size_t _len)
+{
+	if ((_ttydevice == NULL) || (_ttydevice->port_hdl == NULL)) {
+		return -ESTD_INVAL;
+	}
+
+	if (_len > M_TTY_PORT_MMAP_RECORD_MAX) {
+		_len = M_TTY_PORT_MMAP_RECORD_MAX;
+		tty_portmux_stats__truncate(_streamType);
+	}
+
+	tty_port_mmap__append((struct tty_port_mmap*)_ttydevice->port_hdl, _streamType, _buf, _len);
+	return (int)_len;
+}
+
+static int tty_port_mmap__put_char(ttydevice_t *_ttydevice, enum ttyStreamType _streamType, char _c)
+{
+	return tty_port_mmap__write_buf(_ttydevice, _streamType, &_c, 1);
+}
+
+/* ************************************************************************//**
+ * \brief	Store of a record into the ring, no system call is involved
+ *
+ * The space is reserved by a CAS on header->write. A record which does not
+ * fit up to the end of the ring starts at the beginning, the gap is filled
+ * by a pad record. pos of a record is stored last and validates it.
+ * header->commit is raised to the end of the record by a max-CAS without
+ * waiting for the writers of earlier records, a reader validates each
+ * record by its pos.
+ * ****************************************************************************/
+static void tty_port_mmap__append(struct tty_port_mmap *_mmap, enum ttyStreamType _streamType, const char *_buf, size_t _len)
+{
+	struct ttyMmapHeader *header = _mmap->header;
+	struct ttyMmapRecord *record;
+	uint64_t pos, next, offset, gap, need, commit;
+
+	need = M_TTYMMAP_RECORD_SIZE(_len);
+
+	pos = __atomic_load_n(&header->write, __ATOMIC_RELAXED);
+	do {
+		offset = pos & _mmap->mask;
+		gap = ((offset + need) > header->ringSize) ? (header->ringSize - offset) : 0;
+		next = pos + gap + need;
+	} while (!__atomic_compare_exchange_n(&header->write, &pos, next, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+	if (gap >= sizeof(struct ttyMmapRecord)) {
+		record = (struct ttyMmapRecord*)(_mmap->ring + (pos & _mmap->mask));
+		record->len = (uint32_t)(gap - sizeof(struct ttyMmapRecord));
+		record->streamType = 0;
+		record->flags = M_TTYMMAP_FLAG_PAD;
+		__atomic_store_n(&record->pos, pos, __ATOMIC_RELEASE);
+	}
+
+	pos += gap;
+	record = (struct ttyMmapRecord*)(_mmap->ring + (pos & _mmap->mask));
+	__atomic_store_n(&record->pos, ~(uint64_t)0, __ATOMIC_RELAXED);
+	record->len = (uint32_t)_len;
+	record->streamType = (uint16_t)_streamType;
+	record->flags = 0;
+	memcpy(record + 1, _buf, _len);
+	__atomic_store_n(&record->pos, pos, __ATOMIC_RELEASE);
+
+	commit = __atomic_load_n(&header->commit, __ATOMIC_RELAXED);
+	while ((commit < next) && !__atomic_compare_exchange_n(&header->commit, &commit, next, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+/* ************************************************************************//**
+ * \brief	Rename of a ring file of a previous run to <path>.1
+ * ****************************************************************************/
+static void tty_port_mmap__keep_previous(const char *_path)
+{
+	char previous[M_TTY_PORT_MMAP_PATH_MAX + 4];
+	char magic[sizeof(((struct ttyMmapHeader*)0)->magic)];
+	int fd;
+	ssize_t len;
+
+	fd = open(_path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return;
+	}
+	len = read(fd, &magic[0], sizeof(magic));
+	close(fd);
+
+	if ((len == (ssize_t)sizeof(magic)) && (memcmp(&magic[0], M_TTYMMAP_MAGIC, sizeof(magic)) == 0)) {
+		snprintf(&previous[0], sizeof(previous), "%s.1", _path);
+		rename(_path, &previous[0]);
+	}
+}
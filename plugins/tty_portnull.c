@@ -0,0 +1,140 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal 
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* *******************************************************************
+ * includes
+ * ******************************************************************/
+
+/* c -runtime */
+#include <stdarg.h>
+
+/* frame */
+#include <lib_convention__errno.h>
+
+/* project */
+#include <lib_ttyportmux_types.h>
+#include "tty_portnull.h"
+
+/* *******************************************************************
+ * static function declarations
+ * ******************************************************************/
+static int tty_port_null__open(ttydevice_t *_ttydevice);
+static int tty_port_null__close(ttydevice_t *_ttydevice);
+static int tty_port_null__write(ttydevice_t *_ttydevice, enum ttyStreamType _streamType, const char * const _format, va_list _ap);
+static int tty_port_null__write_buf(ttydevice_t *_ttydevice, enum ttyStreamType _streamType, const char *_buf, size_t _len);
+static int tty_port_null__put_char(ttydevice_t *_ttydevice, enum ttyStreamType _streamType, char _c);
+static int tty_port_null__read (ttydevice_t *_ttydevice, enum ttyStreamType _streamType, char *_lineptr, size_t *_n, char _delimiter);
+
+/* *******************************************************************
+ * (static) variables declarations
+ * ******************************************************************/
+static ttydriver_t s_ttydriver_null= {
+	.info.deviceName = "TTYDEVICE_null",
+	.info.deviceType = TTYDEVICE_null,
+	.info.deviceNumber = 1,
+	.open = &tty_port_null__open,
+	.close = &tty_port_null__close,
+	.write = &tty_port_null__write,
+	.write_buf = &tty_port_null__write_buf,
+	.put_char = &tty_port_null__put_char,
+	.read = &tty_port_null__read,
+	.flush = NULL,
+	.ttydevice = NULL
+	};
+
+/* *******************************************************************
+ * \brief	sharing the interfaces
+ * ---------
+ * \remark  The execution of a thread stops only at cancellation points
+ * ---------
+ * \param	_share	[in/out] :	pointer for sharing the interfaces
+ * ---------
+ * \return	'0', if successful, < '0' if not successful
+ * ******************************************************************/
+int tty_portnull__share_if(void)
+{
+	tty_driver_register(&s_ttydriver_null);
+	return EOK;
+}
+
+
+/* *******************************************************************
+ * static function definition
+ * ******************************************************************/
+
+static int tty_port_null__open(ttydevice_t *_ttydevice)
+{
+	(void)_ttydevice;
+	return EOK;
+}
+
+static int tty_port_null__close(ttydevice_t *_ttydevice)
+{
+	(void)_ttydevice;
+	return EOK;
+}
+
+/* the message is discarded unformatted */
+static int tty_port_null__write(ttydevice_t *_ttydevice, enum ttyStreamType _streamType, const char * const _format, va_list _ap)
+{
+	(void)_ttydevice;
+	(void)_streamType;
+	(void)_format;
+	(void)_ap;
+	return EOK;
+}
+
+static int tty_port_null__write_buf(ttydevice_t *_ttydevice, enum ttyStreamType _streamType, const char *_buf, size_t _len)
+{
+	(void)_ttydevice;
+	(void)_streamType;
+	(void)_buf;
+	return (int)_len;
+}
+
+static int tty_port_null__put_char(ttydevice_t *_ttydevice, enum ttyStreamType _streamType, char _c)
+{
+	(void)_ttydevice;
+	(void)_streamType;
+	(void)_c;
+	return 1;
+}
+
+/* reads an empty line */
+static int tty_port_null__read (ttydevice_t *_ttydevice, enum ttyStreamType _streamType, char *_lineptr, size_t *_n, char _delimiter)
+{
+	(void)_ttydevice;
+	(void)_streamType;
+	(void)_delimiter;
+
+	if ((_lineptr == NULL) || (_n == NULL)) {
+		return -EPAR_NULL;
+	}
+
+	if (*_n > 0) {
+		_lineptr[0] = 0;
+	}
+	return EOK;
+}
@@ -32,6 +32,16 @@
 #include <stdio.h>
 #include <syslog.h>
 #include <errno.h>
+#if defined(M_TTY_PORT_SYSLOG_NATIVE)
+	#include <stdlib.h>
+	#include <string.h>
+	#include <time.h>
+	#include <unistd.h>
+	#include <fcntl.h>
+	#include <pthread.h>
+	#include <sys/socket.h>
+	#include <sys/un.h>
+#endif
 
 /* frame */
 #include <lib_convention__errno.h>
@@ -39,15 +49,74 @@
 /* project */
 #include <lib_ttyportmux_types.h>
 #include "tty_portunix.h"
+#include "tty_portmux_fmt.h"
 
 /* *******************************************************************
  * defines
  * ******************************************************************/
+#if defined(M_TTY_PORT_SYSLOG_NATIVE)
 
+#ifndef M_TTY_PORT_SYSLOG_PATH
+	#define M_TTY_PORT_SYSLOG_PATH		"/dev/log"
+#endif
+
+#ifndef M_TTY_PORT_SYSLOG_BATCH
+	#define M_TTY_PORT_SYSLOG_BATCH		1		/*!< records per sendmmsg(), 1 sends each record at once */
+#endif
+
+#ifndef M_TTY_PORT_SYSLOG_RFC5424
+	#define M_TTY_PORT_SYSLOG_RFC5424	0		/*!< 0: RFC 3164 header like syslog(3) */
+#endif
+
+#ifndef M_TTY_PORT_SYSLOG_MSG_MAX
+	#define M_TTY_PORT_SYSLOG_MSG_MAX	1024	/*!< longer records are truncated */
+#endif
+
+#define M_TTY_PORT_SYSLOG_ENV			"TTYPORTMUX_SYSLOG_SOCKET"	/*!< overrides M_TTY_PORT_SYSLOG_PATH */
+#define M_TTY_PORT_SYSLOG_FACILITY		LOG_USER
+#define M_TTY_PORT_SYSLOG_TAG_MAX		160
+
+#define M_TTY_PORT_SYSLOG_URGENT(__stream) \
+	(((__stream) == TTYSTREAM_critical) || ((__stream) == TTYSTREAM_error))
+
+#endif
 
 /* *******************************************************************
  * custom data types (e.g. enumerations, structures, unions)
  * ******************************************************************/
+#if defined(M_TTY_PORT_SYSLOG_NATIVE)
+
+/* ************************************************************************//**
+ * \brief	Datagram connection to the syslog daemon
+ *
+ * The part of the header after the timestamp is built once at open. With
+ * M_TTY_PORT_SYSLOG_BATCH > 1 records are queued and sent by a single
+ * sendmmsg() if the queue is full, at a flush of the ttydevice or at a
+ * critical or error record.
+ * ****************************************************************************/
+struct tty_port_syslog {
+	int fd;
+	pthread_mutex_t lock;
+	struct sockaddr_un addr;
+	char tag[M_TTY_PORT_SYSLOG_TAG_MAX];	/*!< RFC 3164: "app[pid]: ", RFC 5424: "host app pid - - " */
+	size_t tagLen;
+	unsigned int pending;
+	struct mmsghdr msgs[M_TTY_PORT_SYSLOG_BATCH];
+	struct iovec iov[M_TTY_PORT_SYSLOG_BATCH];
+	char records[M_TTY_PORT_SYSLOG_BATCH][M_TTY_PORT_SYSLOG_MSG_MAX];
+};
+
+/* ************************************************************************//**
+ * \brief	Timestamp of the current second, cached per thread
+ * ****************************************************************************/
+struct tty_port_syslog_stamp {
+	time_t sec;
+	size_t len;
+	char text[32];
+	char zone[16];			/*!< RFC 5424 UTC offset */
+};
+
+#endif
 
 /* *******************************************************************
  * static function declarations
@@ -55,10 +124,27 @@
 static int tty_port_syslog__open(ttydevice_t *_ttydevice);
 static int tty_port_syslog__close(ttydevice_t *_ttydevice);
 static int tty_port_syslog__write(ttydevice_t *_ttydevice, enum ttyStreamType _streamType, const char * const _format, va_list _ap);
+static int tty_port_syslog__write_buf(ttydevice_t *_ttydevice, enum ttyStreamType _streamType, const char *_buf, size_t _len);
+static int tty_port_syslog__priority(enum ttyStreamType _streamType);
+static const char *tty_port_syslog__appname(void);
+#if defined(M_TTY_PORT_SYSLOG_NATIVE)
+static int tty_port_syslog__flush(ttydevice_t *_ttydevice);
+static int tty_port_syslog__connect(struct tty_port_syslog *_syslog);
+static char *tty_port_syslog__begin(struct tty_port_syslog *_syslog, char *_local);
+static int tty_port_syslog__end(struct tty_port_syslog *_syslog, char *_rec, size_t _len, int _urgent);
+static size_t tty_port_syslog__header(struct tty_port_syslog *_syslog, char *_rec, int _priority);
+static int tty_port_syslog__send(struct tty_port_syslog *_syslog, const char *_rec, size_t _len);
+static int tty_port_syslog__send_pending(struct tty_port_syslog *_syslog);
+#endif
 
 /* *******************************************************************
  * (static) variables declarations
  * ******************************************************************/
+#if defined(M_TTY_PORT_SYSLOG_NATIVE)
+static struct tty_port_syslog s_syslog = { .fd = -1, .lock = PTHREAD_MUTEX_INITIALIZER };
+static _Thread_local struct tty_port_syslog_stamp s_stamp = { .sec = -1 };
+#endif
+
 static ttydriver_t s_ttydriver_syslog= {
 	.info.deviceName = "TTYDEVICE_syslog",
 	.info.deviceType = TTYDEVICE_syslog,
@@ -66,8 +152,12 @@ static ttydriver_t s_ttydriver_syslog= {
 	.open = &tty_port_syslog__open,
 	.close = &tty_port_syslog__close,
 	.write = &tty_port_syslog__write,
+	.write_buf = &tty_port_syslog__write_buf,
 	.put_char =NULL,
 	.read = NULL,
+#if defined(M_TTY_PORT_SYSLOG_NATIVE)
+	.flush = &tty_port_syslog__flush,
+#endif
 	.ttydevice = NULL
 	};
 
@@ -91,28 +181,45 @@ int tty_portsyslog__share_if(void)
  * static function definition
  * ******************************************************************/
 
-static int tty_port_syslog__open(ttydevice_t *_ttydevice)
+static const char *tty_port_syslog__appname(void)
 {
-	if (_ttydevice == NULL) {
-		return -ESTD_INVAL;
-	}
-
 	#if defined(__APPLE__) || defined(__FreeBSD__)
-		const char * appname = getprogname();
+		return getprogname();
 	#elif defined(_GNU_SOURCE)
-		const char * appname = program_invocation_short_name;
+		return program_invocation_short_name;
 	#else
-		const char * appname = "?";
+		return "?";
 	#endif
+}
 
-	openlog(appname, LOG_PID | LOG_CONS | LOG_NOWAIT, LOG_USER);
+static int tty_port_syslog__priority(enum ttyStreamType _streamType)
+{
+	switch (_streamType) 
+	{
+		case TTYSTREAM_control:		return LOG_NOTICE;
+		case TTYSTREAM_debug:		return LOG_DEBUG;
+		case TTYSTREAM_info:		return LOG_INFO;
+		case TTYSTREAM_warning:		return LOG_WARNING;
+		case TTYSTREAM_error:		return LOG_ERR;
+		case TTYSTREAM_critical:	return LOG_CRIT;
+		default:					return -1;
+	}
+}
+
+#if !defined(M_TTY_PORT_SYSLOG_NATIVE)
+
+static int tty_port_syslog__open(ttydevice_t *_ttydevice)
+{
+	if (_ttydevice == NULL) {
+		return -ESTD_INVAL;
+	}
+
+	openlog(tty_port_syslog__appname(), LOG_PID | LOG_CONS | LOG_NOWAIT, LOG_USER);
 	return EOK;
 }
 
 static int tty_port_syslog__close(ttydevice_t *_ttydevice)
 {
-	int ret_val;
-
 	if (_ttydevice == NULL) {
 		return -ESTD_INVAL;
 	}
@@ -122,35 +229,391 @@ static int tty_port_syslog__close(ttydevice_t *_ttydevice)
 
 static int tty_port_syslog__write(ttydevice_t *_ttydevice, enum ttyStreamType _streamType, const char * const _format, va_list _ap)
 {
-	int ret_val;
+	int priority;
 
 	if (_ttydevice == NULL) {
 		return -ESTD_INVAL;
 	}
 
-	switch (_streamType) 
-	{
-		case TTYSTREAM_control:
-			vsyslog(LOG_NOTICE, _format, _ap);
-			break;
-		case TTYSTREAM_debug:
-			vsyslog(LOG_DEBUG, _format, _ap);
-			break;
-		case TTYSTREAM_info:
-			vsyslog(LOG_INFO, _format, _ap);
-			break;
-		case TTYSTREAM_warning:
-			vsyslog(LOG_WARNING, _format, _ap);
-			break;
-		case TTYSTREAM_error:
-			vsyslog(LOG_ERR, _format, _ap);
-			break;
-		case TTYSTREAM_critical: 
-			vsyslog(LOG_CRIT, _format, _ap);
-			break;
-		default:
-			break;
-	}	
+	priority = tty_port_syslog__priority(_streamType);
+	if (priority < 0) {
+		return EOK;
+	}
+
+	vsyslog(priority, _format, _ap);
 	return EOK;
 }
 
+static int tty_port_syslog__write_buf(ttydevice_t *_ttydevice, enum ttyStreamType _streamType, const char *_buf, size_t _len)
+{
+	int priority;
+
+	if (_ttydevice == NULL) {
+		return -ESTD_INVAL;
+	}
+
+	priority = tty_port_syslog__priority(_streamType);
+	if (priority < 0) {
+		return EOK;
+	}
+
+	syslog(priority, "%.*s", (int)_len, _buf);
+	return EOK;
+}
+
+#else /* M_TTY_PORT_SYSLOG_NATIVE */
+
+/* ************************************************************************//**
+ * \brief	Connection to the syslog socket and setup of the cached header
+ * ****************************************************************************/
+static int tty_port_syslog__open(ttydevice_t *_ttydevice)
+{
+	const char *path;
+	char host[64];
+	int len, ret_val;
+
+	if (_ttydevice == NULL) {
+		return -ESTD_INVAL;
+	}
+
+	/* the socket of a setuid process is not taken from its caller */
+#if defined(_GNU_SOURCE)
+	path = secure_getenv(M_TTY_PORT_SYSLOG_ENV);
+#else
+	path = ((getuid() == geteuid()) && (getgid() == getegid())) ? getenv(M_TTY_PORT_SYSLOG_ENV) : NULL;
+#endif
+	if ((path == NULL) || (path[0] == '\0')) {
+		path = M_TTY_PORT_SYSLOG_PATH;
+	}
+
+	memset(&s_syslog.addr, 0, sizeof(s_syslog.addr));
+	s_syslog.addr.sun_family = AF_UNIX;
+	if (strlen(path) >= sizeof(s_syslog.addr.sun_path)) {
+		return -ESTD_INVAL;
+	}
+	strcpy(&s_syslog.addr.sun_path[0], path);
+
+	if (M_TTY_PORT_SYSLOG_RFC5424) {
+		if (gethostname(&host[0], sizeof(host)) != 0) {
+			strcpy(&host[0], "-");
+		}
+		host[sizeof(host) - 1] = '\0';
+		len = snprintf(&s_syslog.tag[0], sizeof(s_syslog.tag), "%s %s %d - - ", &host[0], tty_port_syslog__appname(), (int)getpid());
+	}
+	else {
+		len = snprintf(&s_syslog.tag[0], sizeof(s_syslog.tag), "%s[%d]: ", tty_port_syslog__appname(), (int)getpid());
+	}
+	s_syslog.tagLen = ((size_t)len < sizeof(s_syslog.tag)) ? (size_t)len : (sizeof(s_syslog.tag) - 1);
+	s_syslog.pending = 0;
+
+	/* a syslog daemon started later on is connected at the first write */
+	ret_val = tty_port_syslog__connect(&s_syslog);
+	if ((ret_val < EOK) && (ret_val != convert_std_errno(ENOENT)) && (ret_val != convert_std_errno(ECONNREFUSED))) {
+		return ret_val;
+	}
+
+	_ttydevice->port_hdl = &s_syslog;
+	return EOK;
+}
+
+static int tty_port_syslog__close(ttydevice_t *_ttydevice)
+{
+	if ((_ttydevice == NULL) || (_ttydevice->port_hdl == NULL)) {
+		return -ESTD_INVAL;
+	}
+
+	tty_port_syslog__flush(_ttydevice);
+
+	pthread_mutex_lock(&s_syslog.lock);
+	if (s_syslog.fd >= 0) {
+		close(s_syslog.fd);
+		s_syslog.fd = -1;
+	}
+	pthread_mutex_unlock(&s_syslog.lock);
+
+	_ttydevice->port_hdl = NULL;
+	return EOK;
+}
+
+static int tty_port_syslog__write(ttydevice_t *_ttydevice, enum ttyStreamType _streamType, const char * const _format, va_list _ap)
+{
+	struct tty_port_syslog *syslog_hdl;
+	char local[(M_TTY_PORT_SYSLOG_BATCH > 1) ? 1 : M_TTY_PORT_SYSLOG_MSG_MAX];
+	size_t len, avail;
+	char *rec;
+	int priority, body, ret;
+
+	if ((_ttydevice == NULL) || (_ttydevice->port_hdl == NULL)) {
+		return -ESTD_INVAL;
+	}
+
+	priority = tty_port_syslog__priority(_streamType);
+	if (priority < 0) {
+		return EOK;
+	}
+
+	syslog_hdl = (struct tty_port_syslog*)_ttydevice->port_hdl;
+	rec = tty_port_syslog__begin(syslog_hdl, &local[0]);
+	len = tty_port_syslog__header(syslog_hdl, rec, priority);
+	avail = M_TTY_PORT_SYSLOG_MSG_MAX - len;
+
+	body = tty_portmux_fmt__vformat(rec + len, avail, _format, _ap);
+	if (body < 0) {
+		body = 0;
+	}
+	len += ((size_t)body < avail) ? (size_t)body : (avail - 1);
+
+	ret = tty_port_syslog__end(syslog_hdl, rec, len, M_TTY_PORT_SYSLOG_URGENT(_streamType));
+	return (ret < EOK) ? ret : body;
+}
+
+static int tty_port_syslog__write_buf(ttydevice_t *_ttydevice, enum ttyStreamType _streamType, const char *_buf, size_t _len)
+{
+	struct tty_port_syslog *syslog_hdl;
+	char local[(M_TTY_PORT_SYSLOG_BATCH > 1) ? 1 : M_TTY_PORT_SYSLOG_MSG_MAX];
+	size_t len, body;
+	char *rec;
+	int priority, ret;
+
+	if ((_ttydevice == NULL) || (_ttydevice->port_hdl == NULL)) {
+		return -ESTD_INVAL;
+	}
+
+	priority = tty_port_syslog__priority(_streamType);
+	if (priority < 0) {
+		return EOK;
+	}
+
+	syslog_hdl = (struct tty_port_syslog*)_ttydevice->port_hdl;
+	rec = tty_port_syslog__begin(syslog_hdl, &local[0]);
+	len = tty_port_syslog__header(syslog_hdl, rec, priority);
+
+	body = M_TTY_PORT_SYSLOG_MSG_MAX - len;
+	if (_len < body) {
+		body = _len;
+	}
+	memcpy(rec + len, _buf, body);
+	len += body;
+
+	ret = tty_port_syslog__end(syslog_hdl, rec, len, M_TTY_PORT_SYSLOG_URGENT(_streamType));
+	return (ret < EOK) ? ret : (int)_len;
+}
+
+static int tty_port_syslog__flush(ttydevice_t *_ttydevice)
+{
+	struct tty_port_syslog *syslog_hdl;
+	int ret;
+
+	if ((_ttydevice == NULL) || (_ttydevice->port_hdl == NULL)) {
+		return -ESTD_INVAL;
+	}
+
+	if (M_TTY_PORT_SYSLOG_BATCH <= 1) {
+		return EOK;
+	}
+
+	syslog_hdl = (struct tty_port_syslog*)_ttydevice->port_hdl;
+	pthread_mutex_lock(&syslog_hdl->lock);
+	ret = tty_port_syslog__send_pending(syslog_hdl);
+	pthread_mutex_unlock(&syslog_hdl->lock);
+	return ret;
+}
+
+/* ************************************************************************//**
+ * \brief	(Re)connection to the syslog socket
+ *
+ * A new connection replaces the previous one by dup2(), the fd number stays
+ * valid for writers which send concurrently.
+ * ****************************************************************************/
+static int tty_port_syslog__connect(struct tty_port_syslog *_syslog)
+{
+	int fd, err;
+
+	fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		return convert_std_errno(errno);
+	}
+
+	if (connect(fd, (struct sockaddr*)&_syslog->addr, sizeof(_syslog->addr)) < 0) {
+		err = errno;
+		close(fd);
+		return convert_std_errno(err);
+	}
+
+	if (_syslog->fd < 0) {
+		_syslog->fd = fd;
+	}
+	else {
+		dup3(fd, _syslog->fd, O_CLOEXEC);
+		close(fd);
+	}
+	return EOK;
+}
+
+/* ************************************************************************//**
+ * \brief	Buffer of the next record, a slot of the queue with the lock
+ * 			held or _local
+ * ****************************************************************************/
+static char *tty_port_syslog__begin(struct tty_port_syslog *_syslog, char *_local)
+{
+	if (M_TTY_PORT_SYSLOG_BATCH <= 1) {
+		return _local;
+	}
+
+	pthread_mutex_lock(&_syslog->lock);
+	if (_syslog->pending == M_TTY_PORT_SYSLOG_BATCH) {
+		tty_port_syslog__send_pending(_syslog);
+	}
+	return &_syslog->records[_syslog->pending][0];
+}
+
+/* ************************************************************************//**
+ * \brief	Send or queue of a record composed at tty_port_syslog__begin()
+ * ****************************************************************************/
+static int tty_port_syslog__end(struct tty_port_syslog *_syslog, char *_rec, size_t _len, int _urgent)
+{
+	int ret = EOK;
+
+	if (M_TTY_PORT_SYSLOG_BATCH <= 1) {
+		return tty_port_syslog__send(_syslog, _rec, _len);
+	}
+
+	_syslog->iov[_syslog->pending].iov_base = _rec;
+	_syslog->iov[_syslog->pending].iov_len = _len;
+	_syslog->pending++;
+
+	if (_urgent || (_syslog->pending == M_TTY_PORT_SYSLOG_BATCH)) {
+		ret = tty_port_syslog__send_pending(_syslog);
+	}
+	pthread_mutex_unlock(&_syslog->lock);
+	return ret;
+}
+
+/* ************************************************************************//**
+ * \brief	Header of a record, "<PRI>" followed by the timestamp and the
+ * 			cached tag
+ * ****************************************************************************/
+static size_t tty_port_syslog__header(struct tty_port_syslog *_syslog, char *_rec, int _priority)
+{
+	static const char months[12][4] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+	struct timespec now;
+	struct tm tm;
+	unsigned int pri, usec;
+	size_t len = 0;
+	long off;
+
+	clock_gettime(CLOCK_REALTIME, &now);
+	if (now.tv_sec != s_stamp.sec) {
+		localtime_r(&now.tv_sec, &tm);
+		s_stamp.sec = now.tv_sec;
+		if (M_TTY_PORT_SYSLOG_RFC5424) {
+			s_stamp.len = strftime(&s_stamp.text[0], sizeof(s_stamp.text), "%Y-%m-%dT%H:%M:%S", &tm);
+			off = tm.tm_gmtoff / 60;
+			snprintf(&s_stamp.zone[0], sizeof(s_stamp.zone), "%c%02ld:%02ld", (off < 0) ? '-' : '+', labs(off) / 60, labs(off) % 60);
+		}
+		else {
+			s_stamp.len = (size_t)snprintf(&s_stamp.text[0], sizeof(s_stamp.text), "%s %2d %02d:%02d:%02d",
+					months[tm.tm_mon], tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec);
+		}
+	}
+
+	/* <PRI>, at most 3 digits */
+	pri = (unsigned int)(M_TTY_PORT_SYSLOG_FACILITY | _priority);
+	_rec[len++] = '<';
+	if (pri >= 100) {
+		_rec[len++] = (char)('0' + (pri / 100));
+	}
+	if (pri >= 10) {
+		_rec[len++] = (char)('0' + ((pri / 10) % 10));
+	}
+	_rec[len++] = (char)('0' + (pri % 10));
+	_rec[len++] = '>';
+
+	if (M_TTY_PORT_SYSLOG_RFC5424) {
+		_rec[len++] = '1';
+		_rec[len++] = ' ';
+	}
+
+	memcpy(&_rec[len], &s_stamp.text[0], s_stamp.len);
+	len += s_stamp.len;
+
+	if (M_TTY_PORT_SYSLOG_RFC5424) {
+		usec = (unsigned int)(now.tv_nsec / 1000);
+		len += (size_t)snprintf(&_rec[len], 8, ".%06u", usec);
+		len += (size_t)snprintf(&_rec[len], sizeof(s_stamp.zone), "%s", &s_stamp.zone[0]);
+	}
+	_rec[len++] = ' ';
+
+	memcpy(&_rec[len], &_syslog->tag[0], _syslog->tagLen);
+	len += _syslog->tagLen;
+	return len;
+}
+
+/* ************************************************************************//**
+ * \brief	Send of a single record, a restarted syslog daemon is reconnected
+ * ****************************************************************************/
+static int tty_port_syslog__send(struct tty_port_syslog *_syslog, const char *_rec, size_t _len)
+{
+	int retry;
+
+	for (retry = 0; retry < 2; retry++) {
+		if (_syslog->fd >= 0) {
+			if (send(_syslog->fd, _rec, _len, MSG_NOSIGNAL) >= 0) {
+				return EOK;
+			}
+			if (errno == EINTR) {
+				continue;
+			}
+			if ((errno != ECONNREFUSED) && (errno != ENOTCONN)) {
+				return convert_std_errno(errno);
+			}
+		}
+
+		pthread_mutex_lock(&_syslog->lock);
+		tty_port_syslog__connect(_syslog);
+		pthread_mutex_unlock(&_syslog->lock);
+	}
+	return -ESTD_IO;
+}
+
+/* ************************************************************************//**
+ * \brief	Send of the queued records by sendmmsg(), called with the lock held
+ * ****************************************************************************/
+static int tty_port_syslog__send_pending(struct tty_port_syslog *_syslog)
+{
+	unsigned int i, sent = 0;
+	int ret = EOK, retry = 0, n;
+
+	for (i = 0; i < _syslog->pending; i++) {
+		memset(&_syslog->msgs[i].msg_hdr, 0, sizeof(_syslog->msgs[i].msg_hdr));
+		_syslog->msgs[i].msg_hdr.msg_iov = &_syslog->iov[i];
+		_syslog->msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	while (sent < _syslog->pending) {
+		n = (_syslog->fd >= 0) ? sendmmsg(_syslog->fd, &_syslog->msgs[sent], _syslog->pending - sent, MSG_NOSIGNAL) : -1;
+		if (n > 0) {
+			sent += (unsigned int)n;
+			continue;
+		}
+
+		if ((_syslog->fd >= 0) && (errno == EINTR)) {
+			continue;
+		}
+
+		if ((retry == 0) && ((_syslog->fd < 0) || (errno == ECONNREFUSED) || (errno == ENOTCONN))) {
+			retry = 1;
+			tty_port_syslog__connect(_syslog);
+			continue;
+		}
+
+		/* the remaining records are dropped, the queue must not block further records */
+		ret = (_syslog->fd >= 0) ? convert_std_errno(errno) : -ESTD_IO;
+		break;
+	}
+
+	_syslog->pending = 0;
+	return ret;
+}
+
+#endif /* M_TTY_PORT_SYSLOG_NATIVE */
@@ -65,6 +65,7 @@ static ttydriver_t s_ttydriver_trace_CORTEXM = {
 	.open = &tty_port_trace_CORTEXM__open,
 	.close = &tty_port_trace_CORTEXM__close,
 	.write = &tty_port_trace_CORTEXM__write,
+	.write_buf = NULL,
 	.put_char =&tty_port_trace_CORTEXM__put_char,
 	.read = NULL,
 	.ttydevice = NULL
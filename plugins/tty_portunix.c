@@ -30,6 +30,8 @@
 /* c -runtime */
 #include <stdarg.h>
 #include <stdio.h>
+#include <errno.h>
+#include <unistd.h>
 
 /* frame */
 #include <lib_convention__errno.h>
@@ -37,10 +39,32 @@
 /* project */
 #include <lib_ttyportmux_types.h>
 #include "tty_portunix.h"
+#include "tty_fdwriter.h"
 
 /* *******************************************************************
  * defines
  * ******************************************************************/
+#ifndef M_TTY_PORT_UNIX_BUFSIZE
+	#define M_TTY_PORT_UNIX_BUFSIZE			4096
+#endif
+
+#ifndef M_TTY_PORT_UNIX_FLUSH_LINE
+	#define M_TTY_PORT_UNIX_FLUSH_LINE		1
+#endif
+
+#ifndef M_TTY_PORT_UNIX_FLUSH_URGENT
+	#define M_TTY_PORT_UNIX_FLUSH_URGENT	1
+#endif
+
+#ifndef M_TTY_PORT_UNIX_FLUSH_BYTES
+	#define M_TTY_PORT_UNIX_FLUSH_BYTES		0
+#endif
+
+#ifndef M_TTY_PORT_UNIX_FLUSH_USEC
+	#define M_TTY_PORT_UNIX_FLUSH_USEC		0
+#endif
+
+#define M_TTY_PORT_UNIX_URGENT(__stream)	(((__stream) == TTYSTREAM_critical) || ((__stream) == TTYSTREAM_error))
 
 /* *******************************************************************
  * custom data types (e.g. enumerations, structures, unions)
@@ -52,8 +76,10 @@
 static int tty_port_unix__open(ttydevice_t *_ttydevice);
 static int tty_port_unix__close(ttydevice_t *_ttydevice);
 static int tty_port_unix__write(ttydevice_t *_ttydevice, enum ttyStreamType _streamType, const char * const _format, va_list _ap);
+static int tty_port_unix__write_buf(ttydevice_t *_ttydevice, enum ttyStreamType _streamType, const char *_buf, size_t _len);
 static int tty_port_unix__put_char(ttydevice_t *_ttydevice, enum ttyStreamType _streamType, char _c);
 static int tty_port_unix__read (ttydevice_t *_ttydevice, enum ttyStreamType _streamType, char *_lineptr, size_t *_n, char _delimiter);
+static int tty_port_unix__flush(ttydevice_t *_ttydevice);
 
 /* *******************************************************************
  * (static) variables declarations
@@ -65,11 +91,23 @@ static ttydriver_t s_ttydriver_unix= {
 	.open = &tty_port_unix__open,
 	.close = &tty_port_unix__close,
 	.write = &tty_port_unix__write,
+	.write_buf = &tty_port_unix__write_buf,
 	.put_char =&tty_port_unix__put_char,
 	.read = &tty_port_unix__read,
+	.flush = &tty_port_unix__flush,
 	.ttydevice = NULL
 };
 
+static const struct tty_fdwriter_policy s_unixPolicy = {
+	.flags = (M_TTY_PORT_UNIX_FLUSH_LINE ? M_TTY_FDWRITER_FLUSH_LINE : 0) |
+			 (M_TTY_PORT_UNIX_FLUSH_URGENT ? M_TTY_FDWRITER_FLUSH_URGENT : 0),
+	.bytes = M_TTY_PORT_UNIX_FLUSH_BYTES,
+	.usec = M_TTY_PORT_UNIX_FLUSH_USEC
+};
+
+static struct tty_fdwriter s_unixWriter;
+static char s_unixBuffer[M_TTY_PORT_UNIX_BUFSIZE];
+
 /* *******************************************************************
  * \brief	sharing the interfaces
  * ---------
@@ -92,20 +130,31 @@ int tty_portunix__share_if(void)
 
 static int tty_port_unix__open(ttydevice_t *_ttydevice)
 {
+	int ret_val;
+
 	if (_ttydevice == NULL) {
 		return -ESTD_INVAL;
 	}
+
+	/* output of stdio issued before the writer takes over */
+	fflush(stdout);
+
+	ret_val = tty_fdwriter__init(&s_unixWriter, STDOUT_FILENO, &s_unixBuffer[0], sizeof(s_unixBuffer), &s_unixPolicy);
+	if (ret_val < EOK) {
+		return ret_val;
+	}
+
+	_ttydevice->port_hdl = &s_unixWriter;
 	return EOK;
 }
 
 static int tty_port_unix__close(ttydevice_t *_ttydevice)
 {
-	int ret_val;
-
 	if (_ttydevice == NULL) {
 		return -ESTD_INVAL;
 	}
 
+	tty_fdwriter__cleanup((struct tty_fdwriter*)_ttydevice->port_hdl);
 	return EOK;
 }
 
@@ -117,21 +166,41 @@ static int tty_port_unix__write(ttydevice_t *_ttydevice, enum ttyStreamType _str
 		return -ESTD_INVAL;
 	}
 
-	vprintf(_format, _ap);
-	fflush(stdout);
-	return EOK;
+	ret_val = tty_fdwriter__vprintf((struct tty_fdwriter*)_ttydevice->port_hdl, M_TTY_PORT_UNIX_URGENT(_streamType), _format, _ap);
+	return ret_val;
+}
 
+static int tty_port_unix__write_buf(ttydevice_t *_ttydevice, enum ttyStreamType _streamType, const char *_buf, size_t _len)
+{
+	int ret_val;
+
+	if (_ttydevice == NULL) {
+		return -ESTD_INVAL;
+	}
+
+	ret_val = tty_fdwriter__write((struct tty_fdwriter*)_ttydevice->port_hdl, _buf, _len, M_TTY_PORT_UNIX_URGENT(_streamType));
+	return ret_val;
 }
 
 static int tty_port_unix__put_char(ttydevice_t *_ttydevice, enum ttyStreamType _streamType, char _c)
 {
+	int ret_val;
+
 	if (_ttydevice == NULL) {
 		return -ESTD_INVAL;
 	}
 
-	putchar(_c);
-	fflush(stdout);
-	return EOK;
+	ret_val = tty_fdwriter__write((struct tty_fdwriter*)_ttydevice->port_hdl, &_c, 1, M_TTY_PORT_UNIX_URGENT(_streamType));
+	return ret_val;
+}
+
+static int tty_port_unix__flush(ttydevice_t *_ttydevice)
+{
+	if (_ttydevice == NULL) {
+		return -ESTD_INVAL;
+	}
+
+	return tty_fdwriter__flush((struct tty_fdwriter*)_ttydevice->port_hdl);
 }
 
 static int tty_port_unix__read (ttydevice_t *_ttydevice, enum ttyStreamType _streamType, char *_lineptr, size_t *_n, char _delimiter)
@@ -149,6 +218,9 @@ static int tty_port_unix__read (ttydevice_t *_ttydevice, enum ttyStreamType _str
 		_delimiter = '\n';
 	}
 
+	/* a pending prompt has to be visible before the read blocks */
+	tty_fdwriter__flush((struct tty_fdwriter*)_ttydevice->port_hdl);
+
 	ret_val = getdelim(&_lineptr,_n,_delimiter,stdin);
 	if (ret_val == -1) {
 		ret_val = convert_std_errno(errno);
@@ -28,44 +28,232 @@
  * ******************************************************************/
 
 /*c -runtime */
+#include <errno.h>
 #include <string.h>
+#include <stddef.h>
 #include <stdarg.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdatomic.h>
+#if defined(__unix__)
+#include <sched.h>
+#endif
 
 /* frame */
 #include <lib_convention__errno.h>
 #include <lib_convention__macro.h>
 #include <lib_list.h>
 #include <lib_convention__mem.h>
-#include <mini-printf.h>
 
 /* project */
 #include <tty_portplugin_init.h>
 #include "tty_portplugin_if.h"
 #include "lib_ttyportmux.h"
+#include "tty_portmux_stats.h"
+#include "tty_portmux_latency.h"
+#include "tty_portmux_ratelimit.h"
+#include "tty_portmux_coalesce.h"
+#include "tty_portmux_prefix.h"
+#include "tty_portmux_capture.h"
+#include "tty_portmux_arena.h"
+#include "tty_portmux_fmt.h"
+#if defined(M_TTYPORTMUX_ASYNC)
+#include "tty_portmux_async.h"
+#endif
 
 /* *******************************************************************
  * defines
  * ******************************************************************/
 #define M_LIB_LIST_CONTEXT_ID			0
 #define M_LIB_LIST_BASE_ADDR			0
+#define M_TTYPORTMUX_SCRATCH_SIZE		512
+#define M_TTYPORTMUX_CACHE_LINE			64
+#define M_TTYPORTMUX_READER_SLOTS		64		/*!< reader slots of the stream snapshot, threads beyond share a slot */
+#define M_TTYPORTMUX_SPIN_MAX			128		/*!< polls of a waiting updater before it yields the cpu */
+
+/* back-off of a waiting updater */
+#if defined(__unix__)
+	#define M_TTYPORTMUX_YIELD()				sched_yield()
+#else
+	#define M_TTYPORTMUX_YIELD()
+#endif
+
+/* operations of a dispatch entry, a single plugin build calls the driver
+ * directly, see tty_portplugin_init.h */
+#if defined(M_TTY_PLUGIN_SINGLE)
+	#define M_TTYDRIVER_WRITE(__dsp)			M_TTY_PLUGIN_SINGLE_WRITE
+#else
+	#define M_TTYDRIVER_WRITE(__dsp)			(*(__dsp)->write)
+#endif
+
+#if defined(M_TTY_PLUGIN_SINGLE_WRITE_BUF)
+	#define M_TTYDRIVER_HAS_WRITE_BUF(__dsp)	1
+	#define M_TTYDRIVER_WRITE_BUF(__dsp)		M_TTY_PLUGIN_SINGLE_WRITE_BUF
+#elif defined(M_TTY_PLUGIN_SINGLE)
+	#define M_TTYDRIVER_HAS_WRITE_BUF(__dsp)	0
+	#define M_TTYDRIVER_WRITE_BUF(__dsp)		(*(__dsp)->write_buf)
+#else
+	#define M_TTYDRIVER_HAS_WRITE_BUF(__dsp)	((__dsp)->write_buf != NULL)
+	#define M_TTYDRIVER_WRITE_BUF(__dsp)		(*(__dsp)->write_buf)
+#endif
+
+#if defined(M_TTY_PLUGIN_SINGLE_PUT_CHAR)
+	#define M_TTYDRIVER_HAS_PUT_CHAR(__dsp)		1
+	#define M_TTYDRIVER_PUT_CHAR(__dsp)			M_TTY_PLUGIN_SINGLE_PUT_CHAR
+#elif defined(M_TTY_PLUGIN_SINGLE)
+	#define M_TTYDRIVER_HAS_PUT_CHAR(__dsp)		0
+	#define M_TTYDRIVER_PUT_CHAR(__dsp)			(*(__dsp)->put_char)
+#else
+	#define M_TTYDRIVER_HAS_PUT_CHAR(__dsp)		((__dsp)->put_char != NULL)
+	#define M_TTYDRIVER_PUT_CHAR(__dsp)			(*(__dsp)->put_char)
+#endif
+
+_Static_assert((M_TTYSTREAM_LEVEL_critical == TTYSTREAM_critical) && (M_TTYSTREAM_LEVEL_error == TTYSTREAM_error) &&
+			   (M_TTYSTREAM_LEVEL_warning == TTYSTREAM_warning) && (M_TTYSTREAM_LEVEL_info == TTYSTREAM_info) &&
+			   (M_TTYSTREAM_LEVEL_debug == TTYSTREAM_debug), "stream levels differ from enum ttyStreamType");
 
 /* *******************************************************************
  * custom data types (e.g. enumerations, structures, unions)
  * ******************************************************************/
 
+/* ************************************************************************//**
+ * \brief	Operations of a ttydevice, copied out of its driver when the
+ * 			streams are resolved
+ * ****************************************************************************/
+struct ttyDispatch {
+	tty_write_t *write;
+	tty_write_buf_t *write_buf;
+	tty_put_char_t *put_char;
+	ttydevice_t *ttydevice;
+	unsigned int deviceId;
+};
+
+/* ************************************************************************//**
+ * \brief	Resolved ttydevices of a stream, dispatch[0] is the primary device
+ *
+ * The count and the primary device share the first cache line, a print to
+ * a stream of a single device reads only this line of the snapshot.
+ * ****************************************************************************/
+struct ttyStreamFanout {
+	_Alignas(M_TTYPORTMUX_CACHE_LINE) unsigned int count;
+	struct ttyDispatch dispatch[M_TTYSTREAM_FANOUT_MAX];
+};
+
+_Static_assert(offsetof(struct ttyStreamFanout, dispatch) + sizeof(struct ttyDispatch) <= M_TTYPORTMUX_CACHE_LINE,
+			   "primary device exceeds the first cache line of the fanout");
+
+/* ************************************************************************//**
+ * \brief	Instances of a device type, ttydevice of instance i is
+ * 			s_deviceTable[first + i]
+ * ****************************************************************************/
+struct ttyDeviceIndex {
+	unsigned int first;		/*!< deviceId of instance 0 */
+	unsigned int count;		/*!< number of instances */
+};
+
+/* ************************************************************************//**
+ * \brief	Immutable snapshot of the stream mapping
+ *
+ * A new mapping is published by a single atomic pointer store. The old
+ * snapshot is released after all readers which may still hold it left
+ * their read section (two phase epoch counters per reader slot).
+ * ****************************************************************************/
+struct ttyStreamTable {
+	void *mem;				/*!< allocation of the table, the table is aligned to a cache line */
+	unsigned int version;
+	unsigned int count;
+	struct ttyStreamMap map[TTYSTREAM_CNT];
+	struct ttyStreamFanout fanout[TTYSTREAM_CNT];
+};
+
+/* ************************************************************************//**
+ * \brief	Published stream snapshot and the epoch of its readers
+ *
+ * Both are only written by an update and have a cache line of their own.
+ * A print reads this line, writes the line of its reader slot and reads the
+ * first line of the fanout of its stream.
+ * ****************************************************************************/
+struct ttyStreamSnapshot {
+	_Alignas(M_TTYPORTMUX_CACHE_LINE) _Atomic(struct ttyStreamTable*) table;
+	atomic_uint epoch;
+};
+
+/* ************************************************************************//**
+ * \brief	Read sections of the threads of a slot by epoch
+ *
+ * Each slot starts at its own cache line, a reader only writes to the line
+ * of its slot.
+ * ****************************************************************************/
+struct ttyStreamReaders {
+	_Alignas(M_TTYPORTMUX_CACHE_LINE) atomic_uint count[2];
+};
+
+/* *******************************************************************
+ * data
+ * ******************************************************************/
+unsigned int g_ttyportmux_streamEnable = M_TTYSTREAM_ENABLE_ALL;
+
 /* *******************************************************************
  * static data
  * ******************************************************************/
-static unsigned int s_initCount = 0;
+static atomic_uint s_initCount = 0;
 static struct queue_attr s_ttydriverList;
-static struct ttyStreamMap *s_streamMap = NULL;
 static unsigned int s_streamMapCount = 0; 
+static enum ttyMuxMode s_mode = TTYMUX_MODE_sync;
+static struct ttyStreamSnapshot s_stream = { .table = NULL, .epoch = 0 };
+static struct ttyStreamReaders s_streamReaders[M_TTYPORTMUX_READER_SLOTS];
+static atomic_uint s_streamReaderNext = 0;
+static _Thread_local struct ttyStreamReaders *s_streamReaderSlot = NULL;
+static atomic_flag s_streamUpdateLock = ATOMIC_FLAG_INIT;
+static unsigned int s_deviceCount = 0;
+static struct ttyDeviceIndex s_deviceIndex[TTYDEVICE_CNT];
+static ttydevice_t **s_deviceTable = NULL;
+static unsigned int s_deviceTableSize = 0;
 
 /* *******************************************************************
  * static function declarations
  * ******************************************************************/
 static ttydevice_t* lib_ttyportmux__stream_to_device(enum ttyStreamType _streamType);
+static int lib_ttyportmux__stream_to_fanout(enum ttyStreamType _streamType, struct ttyStreamFanout *_fanout);
+static int lib_ttyportmux__resolve_streams(const struct ttyStreamMap *_map, unsigned int _count);
+static ttydevice_t* lib_ttyportmux__find_device(enum ttyDeviceType _deviceType, unsigned int _deviceIndex);
+static int lib_ttyportmux__index_devices(void);
+static int lib_ttyportmux__device_mapped(const struct ttyStreamMap *_map, unsigned int _count, const ttydevice_t *_ttydevice);
+static void lib_ttyportmux__close_devices(void);
+static void lib_ttyportmux__set_dispatch(struct ttyDispatch *_dispatch, ttydevice_t *_ttydevice);
+static unsigned int lib_ttyportmux__read_lock(void);
+static void lib_ttyportmux__read_unlock(unsigned int _epoch);
+static void lib_ttyportmux__update_lock(void);
+static void lib_ttyportmux__synchronize(void);
+static int lib_ttyportmux__produce(enum ttyStreamType _streamType, const char * const _format, va_list _ap);
+static int lib_ttyportmux__produce_char(enum ttyStreamType _streamType, char _c);
+static int lib_ttyportmux__produce_buf(enum ttyStreamType _streamType, const char *_buf, size_t _len);
+static int lib_ttyportmux__vdispatch(const struct ttyStreamFanout *_fanout, enum ttyStreamType _streamType, const char * const _format, va_list _ap);
+static int lib_ttyportmux__bdispatch(const struct ttyStreamFanout *_fanout, enum ttyStreamType _streamType, const char *_buf, size_t _len);
 static char* lib_ttyportmux__stream_name(enum ttyStreamType _streamType);
+static int lib_ttyportmux__write(const struct ttyDispatch *_dispatch, enum ttyStreamType _streamType, const char * const _format, va_list _ap);
+static int lib_ttyportmux__write_buf(const struct ttyDispatch *_dispatch, enum ttyStreamType _streamType, const char *_buf, size_t _len);
+static int lib_ttyportmux__put_char(const struct ttyDispatch *_dispatch, enum ttyStreamType _streamType, char _c);
+static int lib_ttyportmux__write_fmt(const struct ttyDispatch *_dispatch, enum ttyStreamType _streamType, const char * const _format, ...);
+static void lib_ttyportmux__flush_devices(void);
+static int lib_ttyportmux__emit(const struct ttyStreamFanout *_fanout, enum ttyStreamType _streamType, const char * const _format, ...);
+static void lib_ttyportmux__suppressed(const struct ttyStreamFanout *_fanout, enum ttyStreamType _streamType, uint64_t _suppressed);
+static int lib_ttyportmux__dispatch_buf(const struct ttyStreamFanout *_fanout, enum ttyStreamType _streamType, const char *_buf, size_t _len);
+static int lib_ttyportmux__coalesce(const struct ttyStreamFanout *_fanout, enum ttyStreamType _streamType, const void *_format, const char *_buf, size_t _len, size_t _prefixLen);
+static void lib_ttyportmux__coalesce_expire(int _all);
+static void lib_ttyportmux__coalesce_due(void);
+#if defined(M_TTYPORTMUX_COALESCE)
+static void lib_ttyportmux__coalesce_reset(unsigned int _mask);
+#endif
+static void lib_ttyportmux__repeated(const struct ttyStreamFanout *_fanout, enum ttyStreamType _streamType, uint64_t _repeats);
+static int lib_ttyportmux__capture(enum ttyStreamType _streamType, const char * const _format, va_list _ap);
+static int lib_ttyportmux__capture_fmt(enum ttyStreamType _streamType, int _prefix, const char * const _format, ...);
+static void lib_ttyportmux__capture_flush(void);
+#if defined(M_TTYPORTMUX_ASYNC)
+static int lib_ttyportmux__async_sink(enum ttyStreamType _streamType, const char *_buf, size_t _len, size_t _prefixLen);
+static int lib_ttyportmux__enqueue(enum ttyStreamType _streamType, const char * const _format, va_list _ap);
+static void lib_ttyportmux__async_idle(void);
+#endif
 
 /* *******************************************************************
  * function definition
@@ -81,11 +269,26 @@ static char* lib_ttyportmux__stream_name(enum ttyStreamType _streamType);
  * ****************************************************************************/
 int lib_ttyportmux__init(struct ttyStreamMap *_map, size_t _mapSize)
 {
+	return lib_ttyportmux__init_ext(_map, _mapSize, NULL);
+}
+
+/* ************************************************************************//**
+ * \brief	Initialization of the tty port multiplexer with an operation mode
+ *
+ * \param	_map	 : ttystream to ttydevice mapping table
+ * \param 	_mapSize : size of the mapping table
+ * \param 	_config	 : operation mode, NULL selects M_TTYMUX_CONFIG_DEFAULT
+ *
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+int lib_ttyportmux__init_ext(struct ttyStreamMap *_map, size_t _mapSize, const struct ttyMuxConfig *_config)
+{
+	static const struct ttyMuxConfig defaultConfig = M_TTYMUX_CONFIG_DEFAULT;
 	unsigned int map_count;
 	struct list_node *ttydevice_node;
 	ttydevice_t *ttydevice;
 	tty_open_t *driver_open;
-	int i, ret;
+	int ret, open_ret;
 
 	map_count = _mapSize / sizeof(struct ttyStreamMap);
 
@@ -93,15 +296,36 @@ int lib_ttyportmux__init(struct ttyStreamMap *_map, size_t _mapSize)
 		return -EPAR_NULL;
 	}
 
-	if ((map_count < 0) || (map_count > TTYSTREAM_CNT)) {
+	if (map_count > TTYSTREAM_CNT) {
+		return -ESTD_INVAL;
+	}
+
+	if (_config == NULL) {
+		_config = &defaultConfig;
+	}
+
+#if !defined(M_TTYPORTMUX_ASYNC)
+	if (_config->mode != TTYMUX_MODE_sync) {
 		return -ESTD_INVAL;
 	}
+#endif
 
+	if ((_config->mode == TTYMUX_MODE_sync) && (_config->format != TTYMUX_FORMAT_immediate)) {
+		return -ESTD_INVAL;
+	}
+
+	/* a second initialization replaces the first one */
 	if (s_initCount > 0) {
-		s_initCount++;
+		lib_ttyportmux__cleanup();
+	}
+
+#if defined(M_TTYPORTMUX_ARENA)
+	ret = tty_portmux_arena__init(_config->scratchArenas, _config->scratchSize);
+	if (ret < EOK) {
+		return ret;
 	}
+#endif
 
-	s_streamMap = _map;
 	s_streamMapCount = map_count;
 
 	ret = lib_list__init(&s_ttydriverList, M_LIB_LIST_CONTEXT_ID);
@@ -109,7 +333,9 @@ int lib_ttyportmux__init(struct ttyStreamMap *_map, size_t _mapSize)
 		goto ERR_PLUGIN_LIST;
 	}
 
-	/*register of available plugins */
+	/*register of available plugins, the deviceIds start at 0 again */
+	s_deviceCount = 0;
+	memset(&s_deviceIndex[0], 0, sizeof(s_deviceIndex));
 	tty_port_plugin();
 
 	ret = lib_list__emty(&s_ttydriverList,M_LIB_LIST_CONTEXT_ID,M_LIB_LIST_BASE_ADDR);
@@ -123,6 +349,8 @@ int lib_ttyportmux__init(struct ttyStreamMap *_map, size_t _mapSize)
 		goto ERR_BUS_LIST;
 	}
 
+	/* an unmapped device which fails to open is left out, a mapped one fails the initialization */
+	open_ret = EOK;
 	do {
 		ttydevice = (ttydevice_t*)GET_CONTAINER_OF(ttydevice_node, struct ttydevice, node);
 
@@ -134,22 +362,45 @@ int lib_ttyportmux__init(struct ttyStreamMap *_map, size_t _mapSize)
 
 			if (ret != EOK) {
 				lib_list__delete(&s_ttydriverList,&ttydevice->node,M_LIB_LIST_CONTEXT_ID, M_LIB_LIST_BASE_ADDR);
-			}
-			else {
-
-				for(i=0; i < s_streamMapCount; i++) {
-					if(s_streamMap[i].deviceType == ttydevice->ttydriver->info.deviceType) {
-						s_streamMap[i].ttydevice = ttydevice;
-						s_streamMap[i].streamType = i;
-					}
-				}	
+				if ((open_ret == EOK) && lib_ttyportmux__device_mapped(_map, map_count, ttydevice)) {
+					open_ret = (ret < EOK) ? ret : -ESTD_NODEV;
+				}
 			}
 		}
 	}while(ret = lib_list__get_next(&s_ttydriverList,&ttydevice_node, M_LIB_LIST_CONTEXT_ID, M_LIB_LIST_BASE_ADDR), (ret == LIB_LIST__EOK));
 
+	if (open_ret < EOK) {
+		ret = open_ret;
+		goto ERR_DEVICES;
+	}
+
+	ret = lib_ttyportmux__index_devices();
+	if (ret < EOK) {
+		goto ERR_DEVICES;
+	}
+
+	ret = lib_ttyportmux__resolve_streams(_map, map_count);
+	if (ret < EOK) {
+		goto ERR_DEVICES;
+	}
+
+	/* the resolved devices are reported back in the map of the caller */
+	lib_ttyportmux__get_stream_mapping(_map, _mapSize);
+
+#if defined(M_TTYPORTMUX_ASYNC)
+	if (_config->mode == TTYMUX_MODE_async) {
+		ret = tty_portmux_async__start(_config, &lib_ttyportmux__async_sink, &lib_ttyportmux__async_idle);
+		if (ret < EOK) {
+			goto ERR_DEVICES;
+		}
+	}
+#endif
+	s_mode = _config->mode;
 	s_initCount = 1;
 
 	return EOK;
+	ERR_DEVICES:
+	lib_ttyportmux__close_devices();
 	ERR_BUS_LIST:
 
 	ERR_PLUGIN_LIST:
@@ -158,15 +409,34 @@ int lib_ttyportmux__init(struct ttyStreamMap *_map, size_t _mapSize)
  }
 
 /* ************************************************************************//**
- * \brief	Cleanup of the tty port multiplexer
- *
- * \param	_deviceID_out : deviceID for out channel
- * \param 	_deviceID_in_out : deviceID for in out channel
+ * \brief	Cleanup of the tty port multiplexer, the opened ttydevices are
+ * 			closed and a following lib_ttyportmux__init opens them again
  *
  * \return	EOK if successful, or negative errno value on error
  * ****************************************************************************/
  int lib_ttyportmux__cleanup(void)
  {
+	if (s_initCount > 0) {
+		/* new producers are refused, the ones in their read section are waited for */
+		s_initCount = 0;
+		lib_ttyportmux__update_lock();
+		lib_ttyportmux__synchronize();
+		atomic_flag_clear_explicit(&s_streamUpdateLock, memory_order_release);
+
+#if defined(M_TTYPORTMUX_ASYNC)
+		/* the drain thread writes the queued records before the ring is freed */
+		if (s_mode == TTYMUX_MODE_async) {
+			tty_portmux_async__stop();
+			s_mode = TTYMUX_MODE_sync;
+		}
+#endif
+		lib_ttyportmux__coalesce_expire(1);
+		lib_ttyportmux__flush_devices();
+		lib_ttyportmux__close_devices();
+	}
+#if defined(M_TTYPORTMUX_ARENA)
+	tty_portmux_arena__cleanup();
+#endif
  	 return EOK;
  }
 
@@ -182,23 +452,9 @@ int lib_ttyportmux__print(enum ttyStreamType _streamType, const char * const _fo
 {
 	int ret;
 	va_list ap;
-	ttydevice_t *ttydevice;
-
-	if ((_streamType >= TTYSTREAM_CNT) || (_format == NULL)) {
-		return -ESTD_INVAL;
-	}
-
-	if (s_initCount == 0) {
-		return -EEXEC_NOINIT;
-	}
-
-	ttydevice = lib_ttyportmux__stream_to_device(_streamType);
-	if (ttydevice == NULL) {
-		return -ESTD_NODEV;
-	}
 
 	va_start(ap,_format);
-	ret = (*ttydevice->ttydriver->write)(ttydevice, _streamType, _format,ap);
+	ret = lib_ttyportmux__vprint(_streamType, _format, ap);
 	va_end(ap);
 	return ret;
 }
@@ -214,23 +470,20 @@ int lib_ttyportmux__print(enum ttyStreamType _streamType, const char * const _fo
  * ****************************************************************************/
 int lib_ttyportmux__vprint(enum ttyStreamType _streamType, const char * const _format, va_list _ap)
 {
+	unsigned int epoch;
 	int ret;
-	ttydevice_t *ttydevice;
 
 	if ((_streamType >= TTYSTREAM_CNT) || (_format == NULL)) {
 		return -ESTD_INVAL;
 	}
 
-	if (s_initCount == 0) {
-		return -EEXEC_NOINIT;
-	}
-
-	ttydevice = lib_ttyportmux__stream_to_device(_streamType);
-	if (ttydevice == NULL) {
-		return -ESTD_NODEV;
+	if (!lib_ttyportmux__stream_enabled(_streamType)) {
+		return EOK;
 	}
 
-	ret = (*ttydevice->ttydriver->write)(ttydevice,_streamType,_format,_ap);
+	epoch = lib_ttyportmux__read_lock();
+	ret = (s_initCount > 0) ? lib_ttyportmux__produce(_streamType, _format, _ap) : -EEXEC_NOINIT;
+	lib_ttyportmux__read_unlock(epoch);
 	return ret;
 }
 
@@ -244,23 +497,48 @@ int lib_ttyportmux__vprint(enum ttyStreamType _streamType, const char * const _f
  * ****************************************************************************/
 int lib_ttyportmux__putchar(enum ttyStreamType _streamType, char _c)
 {
+	unsigned int epoch;
 	int ret;
-	ttydevice_t *ttydevice;
 
 	if (_streamType >= TTYSTREAM_CNT) {
 		return -ESTD_INVAL;
 	}
 
-	if (s_initCount == 0) {
-		return -EEXEC_NOINIT;
+	if (!lib_ttyportmux__stream_enabled(_streamType)) {
+		return EOK;
 	}
 
-	ttydevice = lib_ttyportmux__stream_to_device(_streamType);
-	if (ttydevice == NULL) {
-		return -ESTD_NODEV;
+	epoch = lib_ttyportmux__read_lock();
+	ret = (s_initCount > 0) ? lib_ttyportmux__produce_char(_streamType, _c) : -EEXEC_NOINIT;
+	lib_ttyportmux__read_unlock(epoch);
+	return ret;
+}
+
+/* ************************************************************************//**
+ *  \brief	Printout of an already formatted message through tty port multiplexer
+ *
+ * \param   _streamType	Categorization of the requirements at the stdio device
+ * \param   _buf			formatted message, not zero terminated
+ * \param   _len			number of bytes of the message
+ * \return	EOK if successful, or negative errno value on error
+ *
+ * ****************************************************************************/
+int lib_ttyportmux__print_buf(enum ttyStreamType _streamType, const char *_buf, size_t _len)
+{
+	unsigned int epoch;
+	int ret;
+
+	if ((_streamType >= TTYSTREAM_CNT) || (_buf == NULL) || (_len > INT_MAX)) {
+		return -ESTD_INVAL;
+	}
+
+	if (!lib_ttyportmux__stream_enabled(_streamType)) {
+		return EOK;
 	}
 
-	ret = (*ttydevice->ttydriver->put_char)(ttydevice,_streamType,_c);
+	epoch = lib_ttyportmux__read_lock();
+	ret = (s_initCount > 0) ? lib_ttyportmux__produce_buf(_streamType, _buf, _len) : -EEXEC_NOINIT;
+	lib_ttyportmux__read_unlock(epoch);
 	return ret;
 }
 
@@ -410,6 +688,187 @@ int lib_ttyportmux__get_stream_count()
 	return s_streamMapCount;
 }
 
+/* ************************************************************************//**
+ *  \brief	 Set of the streams which are written at all
+ *
+ * \param   _mask : M_TTYSTREAM_BIT() of each enabled stream
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+int lib_ttyportmux__set_stream_enable(unsigned int _mask)
+{
+	if (_mask & ~M_TTYSTREAM_ENABLE_ALL) {
+		return -ESTD_INVAL;
+	}
+
+	__atomic_store_n(&g_ttyportmux_streamEnable, _mask, __ATOMIC_RELAXED);
+	return EOK;
+}
+
+/* ************************************************************************//**
+ *  \brief	 Request of the streams which are written at all
+ *
+ * \return	M_TTYSTREAM_BIT() of each enabled stream
+ * ****************************************************************************/
+unsigned int lib_ttyportmux__get_stream_enable(void)
+{
+	return __atomic_load_n(&g_ttyportmux_streamEnable, __ATOMIC_RELAXED);
+}
+
+/* ************************************************************************//**
+ *  \brief	 Setup of the rate limit of a stream
+ *
+ * \param   _streamType	: stream to limit
+ * \param   _rate		: messages per second, 0 disables the limit
+ * \param   _burst		: messages written at once after an idle period
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+int lib_ttyportmux__set_stream_ratelimit(enum ttyStreamType _streamType, unsigned int _rate, unsigned int _burst)
+{
+#if defined(M_TTYPORTMUX_RATELIMIT)
+	return tty_portmux_ratelimit__set(_streamType, _rate, _burst);
+#else
+	(void)_streamType;
+	(void)_rate;
+	(void)_burst;
+	return -ESTD_NOSYS;
+#endif
+}
+
+/* ************************************************************************//**
+ *  \brief	 Request of the rate limit of a stream
+ *
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+int lib_ttyportmux__get_stream_ratelimit(enum ttyStreamType _streamType, unsigned int *_rate, unsigned int *_burst)
+{
+	if ((_rate == NULL) || (_burst == NULL)) {
+		return -EPAR_NULL;
+	}
+
+#if defined(M_TTYPORTMUX_RATELIMIT)
+	return tty_portmux_ratelimit__get(_streamType, _rate, _burst);
+#else
+	(void)_streamType;
+	*_rate = 0;
+	*_burst = 0;
+	return EOK;
+#endif
+}
+
+/* ************************************************************************//**
+ *  \brief	 Set of the streams whose repeated messages are coalesced
+ *
+ * \param   _mask		: M_TTYSTREAM_BIT() of each coalesced stream
+ * \param   _intervalMs	: report interval during a repetition, 0 reports at a change only
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+int lib_ttyportmux__set_stream_coalesce(unsigned int _mask, unsigned int _intervalMs)
+{
+	if (_mask & ~M_TTYSTREAM_ENABLE_ALL) {
+		return -ESTD_INVAL;
+	}
+
+#if defined(M_TTYPORTMUX_COALESCE)
+	lib_ttyportmux__coalesce_reset(tty_portmux_coalesce__set(_mask, _intervalMs) ^ _mask);
+	return EOK;
+#else
+	(void)_intervalMs;
+	return (_mask == 0) ? EOK : -ESTD_NOSYS;
+#endif
+}
+
+/* ************************************************************************//**
+ *  \brief	 Request of the coalesced streams
+ *
+ * \return	M_TTYSTREAM_BIT() of each coalesced stream
+ * ****************************************************************************/
+unsigned int lib_ttyportmux__get_stream_coalesce(void)
+{
+#if defined(M_TTYPORTMUX_COALESCE)
+	return tty_portmux_coalesce__get();
+#else
+	return 0;
+#endif
+}
+
+/* ************************************************************************//**
+ *  \brief	 Set of the prefix written in front of each message
+ *
+ * \param   _flags	: M_TTYPREFIX_* of each field, 0 disables the prefix
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+int lib_ttyportmux__set_prefix(unsigned int _flags)
+{
+	if (_flags & ~M_TTYPREFIX_ALL) {
+		return -ESTD_INVAL;
+	}
+
+#if defined(M_TTYPORTMUX_PREFIX)
+	tty_portmux_prefix__set(_flags);
+	return EOK;
+#else
+	return (_flags == 0) ? EOK : -ESTD_NOSYS;
+#endif
+}
+
+/* ************************************************************************//**
+ *  \brief	 Request of the fields of the message prefix
+ *
+ * \return	M_TTYPREFIX_* of each field
+ * ****************************************************************************/
+unsigned int lib_ttyportmux__get_prefix(void)
+{
+#if defined(M_TTYPORTMUX_PREFIX)
+	return tty_portmux_prefix__get();
+#else
+	return 0;
+#endif
+}
+
+/* ************************************************************************//**
+ *  \brief	 Set of the streams which are captured per thread
+ *
+ * \param   _mask		: M_TTYSTREAM_BIT() of each captured stream
+ * \param   _depth		: records kept per thread
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+int lib_ttyportmux__set_stream_capture(unsigned int _mask, unsigned int _depth)
+{
+	if ((_mask & ~M_TTYSTREAM_ENABLE_ALL) ||
+		(_mask & (M_TTYSTREAM_BIT(TTYSTREAM_critical) | M_TTYSTREAM_BIT(TTYSTREAM_error)))) {
+		return -ESTD_INVAL;
+	}
+
+#if defined(M_TTYPORTMUX_CAPTURE)
+	if ((_mask != 0) && ((_depth == 0) || (_depth > M_TTYCAPTURE_DEPTH_MAX))) {
+		return -ESTD_INVAL;
+	}
+	tty_portmux_capture__set(_mask, _depth);
+	return EOK;
+#else
+	(void)_depth;
+	return (_mask == 0) ? EOK : -ESTD_NOSYS;
+#endif
+}
+
+/* ************************************************************************//**
+ *  \brief	 Request of the captured streams
+ *
+ * \param   _depth [out]	: records kept per thread, optional
+ * \return	M_TTYSTREAM_BIT() of each captured stream
+ * ****************************************************************************/
+unsigned int lib_ttyportmux__get_stream_capture(unsigned int *_depth)
+{
+#if defined(M_TTYPORTMUX_CAPTURE)
+	return tty_portmux_capture__get(_depth);
+#else
+	if (_depth != NULL) {
+		*_depth = 0;
+	}
+	return 0;
+#endif
+}
+
 /* ************************************************************************//**
  *  \brief	 Request of the current ttystream to ttydevice mapping table
  *
@@ -420,6 +879,8 @@ int lib_ttyportmux__get_stream_count()
 int lib_ttyportmux__get_stream_mapping(struct ttyStreamMap * const _map, size_t _mapSize)
 {
 	size_t streamMapSize = s_streamMapCount * sizeof(struct ttyStreamMap);
+	struct ttyStreamTable *table;
+	unsigned int epoch;
 
 	if (_map == NULL) {
 		return -EPAR_NULL;
@@ -430,7 +891,13 @@ int lib_ttyportmux__get_stream_mapping(struct ttyStreamMap * const _map, size_t
 	}
 
 	memset(_map,0, _mapSize);
-	memcpy(_map,s_streamMap, streamMapSize);
+
+	epoch = lib_ttyportmux__read_lock();
+	table = atomic_load_explicit(&s_stream.table, memory_order_acquire);
+	if (table != NULL) {
+		memcpy(_map, &table->map[0], table->count * sizeof(struct ttyStreamMap));
+	}
+	lib_ttyportmux__read_unlock(epoch);
 	return s_streamMapCount;
 }
 
@@ -443,42 +910,22 @@ int lib_ttyportmux__get_stream_mapping(struct ttyStreamMap * const _map, size_t
  * ****************************************************************************/
 int lib_ttyportmux__set_stream_mapping(const struct ttyStreamMap * const _map, size_t _mapSize) 
 {
-	int ret;
-	unsigned int i, entryCount;
-
-	struct list_node *ttydevice_node;
-	ttydevice_t *ttydevice;
+	unsigned int entryCount;
 	
 	if (_map == NULL) {
 		return -EPAR_NULL;
 	}
 
+	if (s_initCount == 0) {
+		return -EEXEC_NOINIT;
+	}
+
 	entryCount = _mapSize/sizeof(struct ttyStreamMap);
 	if(entryCount > s_streamMapCount) {
 		entryCount = s_streamMapCount;
 	}
 
-	ret = lib_list__get_begin(&s_ttydriverList ,&ttydevice_node, M_LIB_LIST_CONTEXT_ID, M_LIB_LIST_BASE_ADDR);
-	if (ret < EOK) {
-		return ret;
-	}
-
-	for(i=0; i < s_streamMapCount; i++) {
-		if(s_streamMap[i].deviceType != _map[i].deviceType) {
-			s_streamMap[i].deviceType = _map[i].deviceType;
-		}
-	}
-
-	do {
-		ttydevice = (ttydevice_t*)GET_CONTAINER_OF(ttydevice_node, struct ttydevice, node);
-
-		for(i=0; i < s_streamMapCount; i++) {
-			if(s_streamMap[i].deviceType == ttydevice->ttydriver->info.deviceType) {
-				s_streamMap[i].ttydevice = ttydevice;
-			}
-		}
-	}while(ret = lib_list__get_next(&s_ttydriverList,&ttydevice_node, M_LIB_LIST_CONTEXT_ID, M_LIB_LIST_BASE_ADDR), (ret == LIB_LIST__EOK));
-	return EOK;
+	return lib_ttyportmux__resolve_streams(_map, entryCount);
 }
 
 /* ************************************************************************//**
@@ -494,63 +941,764 @@ int lib_ttyportmux__get_stream_info(const struct ttyStreamMap *const _map, struc
 		return -EPAR_NULL;
 	}
 
-	_streamInfo->deviceIndex = _map->ttydevice->ttydriver->info.deviceIndex;
 	_streamInfo->streamName = lib_ttyportmux__stream_name(_map->streamType);
 	_streamInfo->streamType = _map->streamType;
+
+	/* a stream of a device which is not opened is not resolved */
+	if (_map->ttydevice == NULL) {
+		_streamInfo->deviceIndex = _map->deviceIndex;
+		_streamInfo->deviceName = NULL;
+		_streamInfo->deviceType = _map->deviceType;
+		return -ESTD_NODEV;
+	}
+
+	_streamInfo->deviceIndex = _map->ttydevice->deviceIndex;
 	_streamInfo->deviceName = _map->ttydevice->ttydriver->info.deviceName;
 	_streamInfo->deviceType = _map->ttydevice->ttydriver->info.deviceType;
+	return EOK;
 }
 
 /* ************************************************************************//**
- * \brief	No Interface function only for internal -  Register a stdio channel at the port multiplexer
+ *  \brief	 Request of the message counters of a stream
  *
- * \param   _ttydriver  share interfaces with the port multiplexer
+ * \param   _streamType		:	stream to request
+ * \param	_stats[OUT]		:	messages, bytes, errors, drops, suppressed, truncated and max payload
  * \return	EOK if successful, or negative errno value on error
  * ****************************************************************************/
-int tty_driver_register(ttydriver_t * const _ttydriver)
+int lib_ttyportmux__get_stats(enum ttyStreamType _streamType, struct ttyStats * const _stats)
 {
-	int i;
-	ttydevice_t *ttydevice;
-	unsigned int deviceNumber;
-
-	 deviceNumber = _ttydriver->info.deviceNumber;
-
-	 ttydevice = (ttydevice_t*)alloc_memory(deviceNumber, sizeof(ttydevice_t));
-	 if(ttydevice == NULL) {
-		 return -EPAR_NULL;
-	 }
+	if (_stats == NULL) {
+		return -EPAR_NULL;
+	}
 
-	 for(i = 0; i < deviceNumber; i++) {
-		ttydevice[i].ttydriver = _ttydriver;
-		ttydevice[i].ttydriver->info.deviceIndex = i;
-		ttydevice[i].ttydriver->ttydevice = &ttydevice[i];
-		lib_list__enqueue(&s_ttydriverList,&ttydevice[i].node,M_LIB_LIST_CONTEXT_ID,M_LIB_LIST_BASE_ADDR);
-	 }
-	 return EOK;
+#if defined(M_TTYPORTMUX_STATS)
+	return tty_portmux_stats__get_stream(_streamType, _stats);
+#else
+	(void)_streamType;
+	return -ESTD_NOSYS;
+#endif
 }
 
-/* *******************************************************************
- * static function definitions
- * ******************************************************************/
-
 /* ************************************************************************//**
- * \brief Request of the active stdio channel depending of the channel category
+ *  \brief	 Request of the message counters of a ttydevice
  *
- * \param   _streamType	Categorization of the requirements at the stdio device
- * \return	Pointer to stdio channel if successful, or NULL on error
+ * \param   _node [in]		:	list entry of the ttydevice
+ * \param	_stats[OUT]		:	messages, bytes, errors and max payload
+ * \return	EOK if successful, or negative errno value on error
  * ****************************************************************************/
-static ttydevice_t* lib_ttyportmux__stream_to_device(enum ttyStreamType _streamType)
+int lib_ttyportmux__get_ttydevice_stats(struct list_node *_node, struct ttyStats * const _stats)
 {
-	ttydevice_t *ttydevice;
-
-	if ((_streamType >= TTYSTREAM_CNT) || (s_streamMapCount <_streamType)) {
-		return NULL;
+	if ((_node == NULL) || (_stats == NULL)) {
+		return -EPAR_NULL;
 	}
 
-	ttydevice = s_streamMap[_streamType].ttydevice;
-	return ttydevice;
+#if defined(M_TTYPORTMUX_STATS)
+	return tty_portmux_stats__get_device(((ttydevice_t*)GET_CONTAINER_OF(_node, struct ttydevice, node))->deviceId, _stats);
+#else
+	return -ESTD_NOSYS;
+#endif
+}
+
+/* ************************************************************************//**
+ *  \brief	 Reset of the message counters of all streams and ttydevices
+ *
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+int lib_ttyportmux__reset_stats(void)
+{
+#if defined(M_TTYPORTMUX_STATS)
+	tty_portmux_stats__reset();
+	return EOK;
+#else
+	return -ESTD_NOSYS;
+#endif
+}
+
+/* ************************************************************************//**
+ *  \brief	 Request of the driver call latency of a ttydevice
+ *
+ * \param   _node [in]		:	list entry of the ttydevice
+ * \param	_latency[OUT]	:	p50, p99, p999 and max in nanoseconds
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+int lib_ttyportmux__get_ttydevice_latency(struct list_node *_node, struct ttyLatency * const _latency)
+{
+	if ((_node == NULL) || (_latency == NULL)) {
+		return -EPAR_NULL;
+	}
+
+#if defined(M_TTYPORTMUX_LATENCY)
+	return tty_portmux_latency__get(((ttydevice_t*)GET_CONTAINER_OF(_node, struct ttydevice, node))->deviceId, _latency);
+#else
+	return -ESTD_NOSYS;
+#endif
+}
+
+/* ************************************************************************//**
+ *  \brief	 Reset of the latency histograms of all ttydevices
+ *
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+int lib_ttyportmux__reset_latency(void)
+{
+#if defined(M_TTYPORTMUX_LATENCY)
+	tty_portmux_latency__reset();
+	return EOK;
+#else
+	return -ESTD_NOSYS;
+#endif
+}
+
+/* ************************************************************************//**
+ * \brief	No Interface function only for internal -  Register a stdio channel at the port multiplexer
+ *
+ * \param   _ttydriver  share interfaces with the port multiplexer
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+int tty_driver_register(ttydriver_t * const _ttydriver)
+{
+	ttydevice_t *ttydevice;
+	unsigned int i, deviceNumber, type;
+
+	 deviceNumber = _ttydriver->info.deviceNumber;
+
+	 /* the ttydevices of a previous initialization are reused */
+	 ttydevice = _ttydriver->ttydevice;
+	 if (ttydevice == NULL) {
+		 ttydevice = (ttydevice_t*)alloc_memory(deviceNumber, sizeof(ttydevice_t));
+		 if(ttydevice == NULL) {
+			 return -EPAR_NULL;
+		 }
+	 }
+
+	 /* the first driver of a device type is indexed, as found by a walk of the list */
+	 type = _ttydriver->info.deviceType;
+	 if ((type < TTYDEVICE_CNT) && (s_deviceIndex[type].count == 0)) {
+		s_deviceIndex[type].first = s_deviceCount;
+		s_deviceIndex[type].count = deviceNumber;
+	 }
+
+	 for(i = 0; i < deviceNumber; i++) {
+		ttydevice[i].ttydriver = _ttydriver;
+		ttydevice[i].deviceId = s_deviceCount++;
+		ttydevice[i].deviceIndex = i;
+		ttydevice[i].ttydriver->info.deviceIndex = i;
+		lib_list__enqueue(&s_ttydriverList,&ttydevice[i].node,M_LIB_LIST_CONTEXT_ID,M_LIB_LIST_BASE_ADDR);
+	 }
+	 _ttydriver->ttydevice = &ttydevice[0];
+	 return EOK;
+}
+
+/* *******************************************************************
+ * static function definitions
+ * ******************************************************************/
+
+/* ************************************************************************//**
+ * \brief Printout of a message in the read section of the stream snapshot,
+ * 		   a cleanup waits for it
+ *
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+static int lib_ttyportmux__produce(enum ttyStreamType _streamType, const char * const _format, va_list _ap)
+{
+	int ret, errnum = errno;
+	struct ttyStreamFanout fanout;
+	uint64_t suppressed;
+
+	/* a captured message is not written, the rate limit applies to
+	 * written messages only */
+	if (tty_portmux_capture__enabled(_streamType)) {
+		return lib_ttyportmux__capture(_streamType, _format, _ap);
+	}
+
+	if (!tty_portmux_ratelimit__admit(_streamType, &suppressed)) {
+		tty_portmux_stats__suppress(_streamType);
+		return EOK;
+	}
+
+	ret = lib_ttyportmux__stream_to_fanout(_streamType, &fanout);
+	if (ret < EOK) {
+		return ret;
+	}
+
+	if ((_streamType <= TTYSTREAM_error) && (tty_portmux_capture__pending() > 0)) {
+		lib_ttyportmux__capture_flush();
+	}
+
+	if (suppressed > 0) {
+		lib_ttyportmux__suppressed(&fanout, _streamType, suppressed);
+	}
+
+	/* errno of the caller for a "%m" of the message */
+	errno = errnum;
+
+#if defined(M_TTYPORTMUX_ASYNC)
+	if (s_mode == TTYMUX_MODE_async) {
+		ret = lib_ttyportmux__enqueue(_streamType, _format, _ap);
+		if (ret == -ESTD_AGAIN) {
+			tty_portmux_stats__drop(_streamType);
+		}
+		return ret;
+	}
+#endif
+	return lib_ttyportmux__vdispatch(&fanout, _streamType, _format, _ap);
+}
+
+/* ************************************************************************//**
+ * \brief Printout of a character in the read section of the stream snapshot
+ *
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+static int lib_ttyportmux__produce_char(enum ttyStreamType _streamType, char _c)
+{
+	int ret = EOK, dev_ret;
+	unsigned int i;
+	struct ttyStreamFanout fanout;
+
+	if (tty_portmux_capture__enabled(_streamType)) {
+		return lib_ttyportmux__capture_fmt(_streamType, 0, "%c", _c);
+	}
+
+	ret = lib_ttyportmux__stream_to_fanout(_streamType, &fanout);
+	if (ret < EOK) {
+		return ret;
+	}
+
+#if defined(M_TTYPORTMUX_ASYNC)
+	if (s_mode == TTYMUX_MODE_async) {
+		ret = tty_portmux_async__putchar(_streamType, _c);
+		if (ret == -ESTD_AGAIN) {
+			tty_portmux_stats__drop(_streamType);
+		}
+		return ret;
+	}
+#endif
+	for (i = 0; i < fanout.count; i++) {
+		dev_ret = lib_ttyportmux__put_char(&fanout.dispatch[i], _streamType, _c);
+		if ((dev_ret < EOK) && (ret == EOK)) {
+			ret = dev_ret;
+		}
+	}
+	tty_portmux_stats__stream(_streamType, ret, 1);
+	return ret;
+}
+
+/* ************************************************************************//**
+ * \brief Printout of a formatted message in the read section of the stream
+ * 		   snapshot
+ *
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+static int lib_ttyportmux__produce_buf(enum ttyStreamType _streamType, const char *_buf, size_t _len)
+{
+	int ret;
+	struct ttyStreamFanout fanout;
+	uint64_t suppressed;
+
+	if (tty_portmux_capture__enabled(_streamType)) {
+		return lib_ttyportmux__capture_fmt(_streamType, 1, "%.*s", (int)_len, _buf);
+	}
+
+	if (!tty_portmux_ratelimit__admit(_streamType, &suppressed)) {
+		tty_portmux_stats__suppress(_streamType);
+		return EOK;
+	}
+
+	ret = lib_ttyportmux__stream_to_fanout(_streamType, &fanout);
+	if (ret < EOK) {
+		return ret;
+	}
+
+	if ((_streamType <= TTYSTREAM_error) && (tty_portmux_capture__pending() > 0)) {
+		lib_ttyportmux__capture_flush();
+	}
+
+	if (suppressed > 0) {
+		lib_ttyportmux__suppressed(&fanout, _streamType, suppressed);
+	}
+
+	return lib_ttyportmux__bdispatch(&fanout, _streamType, _buf, _len);
+}
+
+/* ************************************************************************//**
+ * \brief Request of the active stdio channel depending of the channel category
+ *
+ * \param   _streamType	Categorization of the requirements at the stdio device
+ * \return	Pointer to stdio channel if successful, or NULL on error
+ * ****************************************************************************/
+static ttydevice_t* lib_ttyportmux__stream_to_device(enum ttyStreamType _streamType)
+{
+	struct ttyStreamFanout fanout;
+
+	if (lib_ttyportmux__stream_to_fanout(_streamType, &fanout) < EOK) {
+		return NULL;
+	}
+	return fanout.dispatch[0].ttydevice;
  }
 
+/* ************************************************************************//**
+ * \brief Request of all ttydevices a stream is written to
+ *
+ * The devices are copied out of the current snapshot, so the snapshot is
+ * not referenced while the drivers are called.
+ *
+ * \param   _streamType	Categorization of the requirements at the stdio device
+ * \param   _fanout [out]	resolved devices of the stream
+ * \return	EOK if successful, -ESTD_NODEV if no device is mapped
+ * ****************************************************************************/
+static int lib_ttyportmux__stream_to_fanout(enum ttyStreamType _streamType, struct ttyStreamFanout *_fanout)
+{
+	struct ttyStreamTable *table;
+	const struct ttyStreamFanout *fanout;
+	unsigned int epoch;
+
+	if (_streamType >= TTYSTREAM_CNT) {
+		return -ESTD_NODEV;
+	}
+
+	epoch = lib_ttyportmux__read_lock();
+	table = atomic_load_explicit(&s_stream.table, memory_order_acquire);
+	if ((table != NULL) && (_streamType < table->count)) {
+		/* only the resolved entries are copied */
+		fanout = &table->fanout[_streamType];
+		_fanout->count = fanout->count;
+		memcpy(&_fanout->dispatch[0], &fanout->dispatch[0], fanout->count * sizeof(struct ttyDispatch));
+	}
+	else {
+		_fanout->count = 0;
+	}
+	lib_ttyportmux__read_unlock(epoch);
+
+	return (_fanout->count > 0) ? EOK : -ESTD_NODEV;
+}
+
+/* ************************************************************************//**
+ * \brief Resolve of a stream map to opened ttydevices and publish as new
+ * 		   snapshot
+ *
+ * The device of deviceType and deviceIndex is the primary device of the
+ * stream, the first instance of each type of deviceMask follows in the
+ * order of the types. Streams not covered by _map keep their current
+ * mapping.
+ *
+ * \param   _map	: device types of the streams
+ * \param   _count	: number of entries of _map
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+static int lib_ttyportmux__resolve_streams(const struct ttyStreamMap *_map, unsigned int _count)
+{
+	ttydevice_t *ttydevice;
+	struct ttyStreamTable *table, *oldTable;
+	struct ttyStreamFanout *fanout;
+	unsigned int i, type, mask;
+	void *mem;
+
+	mem = alloc_memory(1, sizeof(struct ttyStreamTable) + M_TTYPORTMUX_CACHE_LINE);
+	if (mem == NULL) {
+		return -ESTD_NOMEM;
+	}
+	table = (struct ttyStreamTable*)(((uintptr_t)mem + M_TTYPORTMUX_CACHE_LINE - 1) & ~((uintptr_t)M_TTYPORTMUX_CACHE_LINE - 1));
+	memset(table, 0, sizeof(struct ttyStreamTable));
+	table->mem = mem;
+
+	lib_ttyportmux__update_lock();
+
+	oldTable = atomic_load_explicit(&s_stream.table, memory_order_relaxed);
+	if (oldTable != NULL) {
+		memcpy(&table->map[0], &oldTable->map[0], sizeof(table->map));
+		table->version = oldTable->version + 1;
+	}
+	table->count = s_streamMapCount;
+
+	for(i=0; i < _count; i++) {
+		table->map[i].deviceType = _map[i].deviceType;
+		table->map[i].deviceMask = _map[i].deviceMask;
+		table->map[i].deviceIndex = _map[i].deviceIndex;
+	}
+
+	for(i=0; i < table->count; i++) {
+		fanout = &table->fanout[i];
+		fanout->count = 0;
+
+		ttydevice = lib_ttyportmux__find_device(table->map[i].deviceType, table->map[i].deviceIndex);
+		if (ttydevice != NULL) {
+			lib_ttyportmux__set_dispatch(&fanout->dispatch[fanout->count++], ttydevice);
+		}
+
+		mask = table->map[i].deviceMask & ~M_TTYDEVICE_BIT(table->map[i].deviceType);
+		for (type = 0; (type < TTYDEVICE_CNT) && (fanout->count < M_TTYSTREAM_FANOUT_MAX); type++) {
+			if (!(mask & M_TTYDEVICE_BIT(type))) {
+				continue;
+			}
+			ttydevice = lib_ttyportmux__find_device(type, 0);
+			if (ttydevice != NULL) {
+				lib_ttyportmux__set_dispatch(&fanout->dispatch[fanout->count++], ttydevice);
+			}
+		}
+
+		table->map[i].streamType = i;
+		table->map[i].ttydevice = (fanout->count > 0) ? fanout->dispatch[0].ttydevice : NULL;
+	}
+
+	atomic_store_explicit(&s_stream.table, table, memory_order_seq_cst);
+	if (oldTable != NULL) {
+		lib_ttyportmux__synchronize();
+		free_memory(oldTable->mem);
+	}
+
+	atomic_flag_clear_explicit(&s_streamUpdateLock, memory_order_release);
+	return EOK;
+}
+
+/* ************************************************************************//**
+ * \brief Search of an instance of a ttydevice type
+ *
+ * \return	Pointer to the ttydevice if successful, or NULL if not registered
+ * 			or not opened
+ * ****************************************************************************/
+static ttydevice_t* lib_ttyportmux__find_device(enum ttyDeviceType _deviceType, unsigned int _deviceIndex)
+{
+	unsigned int deviceId;
+
+	if ((_deviceType >= TTYDEVICE_CNT) || (_deviceIndex >= s_deviceIndex[_deviceType].count)) {
+		return NULL;
+	}
+
+	deviceId = s_deviceIndex[_deviceType].first + _deviceIndex;
+	return (deviceId < s_deviceTableSize) ? s_deviceTable[deviceId] : NULL;
+}
+
+/* ************************************************************************//**
+ * \brief Build of the table of the opened ttydevices by deviceId, devices
+ * 		   which failed to open are not in the list and stay NULL
+ *
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+static int lib_ttyportmux__index_devices(void)
+{
+	struct list_node *ttydevice_node;
+	ttydevice_t *ttydevice;
+	int ret;
+
+	if (s_deviceTable != NULL) {
+		free_memory(s_deviceTable);
+		s_deviceTable = NULL;
+		s_deviceTableSize = 0;
+	}
+
+	s_deviceTable = (ttydevice_t**)alloc_memory(s_deviceCount, sizeof(ttydevice_t*));
+	if (s_deviceTable == NULL) {
+		return -ESTD_NOMEM;
+	}
+	memset(s_deviceTable, 0, s_deviceCount * sizeof(ttydevice_t*));
+	s_deviceTableSize = s_deviceCount;
+
+	ret = lib_list__get_begin(&s_ttydriverList ,&ttydevice_node, M_LIB_LIST_CONTEXT_ID, M_LIB_LIST_BASE_ADDR);
+	if (ret < EOK) {
+		return EOK;
+	}
+
+	do {
+		ttydevice = (ttydevice_t*)GET_CONTAINER_OF(ttydevice_node, struct ttydevice, node);
+		if (ttydevice->deviceId < s_deviceTableSize) {
+			s_deviceTable[ttydevice->deviceId] = ttydevice;
+		}
+	}while(ret = lib_list__get_next(&s_ttydriverList,&ttydevice_node, M_LIB_LIST_CONTEXT_ID, M_LIB_LIST_BASE_ADDR), (ret == LIB_LIST__EOK));
+
+	return EOK;
+}
+
+/* ************************************************************************//**
+ * \brief Check if a ttydevice is the device or a fanout device of a stream
+ * 		   of the map
+ *
+ * \return	1 if mapped, 0 otherwise
+ * ****************************************************************************/
+static int lib_ttyportmux__device_mapped(const struct ttyStreamMap *_map, unsigned int _count, const ttydevice_t *_ttydevice)
+{
+	unsigned int i, type;
+
+	type = _ttydevice->ttydriver->info.deviceType;
+	for (i = 0; i < _count; i++) {
+		if ((_map[i].deviceType == type) && (_map[i].deviceIndex == _ttydevice->deviceIndex)) {
+			return 1;
+		}
+		if ((type < TTYDEVICE_CNT) && (_map[i].deviceMask & M_TTYDEVICE_BIT(type)) && (_ttydevice->deviceIndex == 0)) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* ************************************************************************//**
+ * \brief Close of the opened ttydevices and release of the stream snapshot,
+ * 		   the device table and the device index which reference them
+ * ****************************************************************************/
+static void lib_ttyportmux__close_devices(void)
+{
+	struct list_node *ttydevice_node;
+	ttydevice_t *ttydevice;
+	struct ttyStreamTable *table;
+	int ret;
+
+	lib_ttyportmux__update_lock();
+	table = atomic_exchange_explicit(&s_stream.table, NULL, memory_order_seq_cst);
+	if (table != NULL) {
+		lib_ttyportmux__synchronize();
+		free_memory(table->mem);
+	}
+	atomic_flag_clear_explicit(&s_streamUpdateLock, memory_order_release);
+
+	ret = lib_list__get_begin(&s_ttydriverList ,&ttydevice_node, M_LIB_LIST_CONTEXT_ID, M_LIB_LIST_BASE_ADDR);
+	while (ret == LIB_LIST__EOK) {
+		ttydevice = (ttydevice_t*)GET_CONTAINER_OF(ttydevice_node, struct ttydevice, node);
+		if ((ttydevice->ttydriver != NULL) && (ttydevice->ttydriver->close != NULL)) {
+			(*ttydevice->ttydriver->close)(ttydevice);
+		}
+		ret = lib_list__get_next(&s_ttydriverList,&ttydevice_node, M_LIB_LIST_CONTEXT_ID, M_LIB_LIST_BASE_ADDR);
+	}
+	lib_list__init(&s_ttydriverList, M_LIB_LIST_CONTEXT_ID);
+
+	if (s_deviceTable != NULL) {
+		free_memory(s_deviceTable);
+		s_deviceTable = NULL;
+		s_deviceTableSize = 0;
+	}
+	s_deviceCount = 0;
+	memset(&s_deviceIndex[0], 0, sizeof(s_deviceIndex));
+}
+
+/* ************************************************************************//**
+ * \brief Copy of the operations of a ttydevice into a dispatch entry
+ * ****************************************************************************/
+static void lib_ttyportmux__set_dispatch(struct ttyDispatch *_dispatch, ttydevice_t *_ttydevice)
+{
+	_dispatch->write = _ttydevice->ttydriver->write;
+	_dispatch->write_buf = _ttydevice->ttydriver->write_buf;
+	_dispatch->put_char = _ttydevice->ttydriver->put_char;
+	_dispatch->ttydevice = _ttydevice;
+	_dispatch->deviceId = _ttydevice->deviceId;
+}
+
+/* ************************************************************************//**
+ * \brief Enter of a read section on the stream snapshot
+ *
+ * The counter is taken from the reader slot of the thread, assigned round
+ * robin at first use, so concurrent readers do not share a cache line.
+ *
+ * \return	epoch to pass to lib_ttyportmux__read_unlock
+ * ****************************************************************************/
+static unsigned int lib_ttyportmux__read_lock(void)
+{
+	unsigned int epoch;
+
+	if (s_streamReaderSlot == NULL) {
+		s_streamReaderSlot = &s_streamReaders[atomic_fetch_add_explicit(&s_streamReaderNext, 1, memory_order_relaxed) % M_TTYPORTMUX_READER_SLOTS];
+	}
+
+	epoch = atomic_load_explicit(&s_stream.epoch, memory_order_seq_cst) & 1;
+	atomic_fetch_add_explicit(&s_streamReaderSlot->count[epoch], 1, memory_order_seq_cst);
+	return epoch;
+}
+
+static void lib_ttyportmux__read_unlock(unsigned int _epoch)
+{
+	atomic_fetch_sub_explicit(&s_streamReaderSlot->count[_epoch], 1, memory_order_release);
+}
+
+/* ************************************************************************//**
+ * \brief Enter of the update section of the stream snapshot, a waiting
+ * 		   updater yields the cpu
+ * ****************************************************************************/
+static void lib_ttyportmux__update_lock(void)
+{
+	unsigned int spin = 0;
+
+	while (atomic_flag_test_and_set_explicit(&s_streamUpdateLock, memory_order_acquire)) {
+		if (++spin >= M_TTYPORTMUX_SPIN_MAX) {
+			M_TTYPORTMUX_YIELD();
+			spin = 0;
+		}
+	}
+}
+
+/* ************************************************************************//**
+ * \brief Wait until no reader can reference a snapshot which was replaced
+ * 		   before the call
+ *
+ * Each phase moves new readers to the other counter of their slot and
+ * waits for the readers of the previous counter of every slot. A reader
+ * that sampled the epoch before the flip but incremented the counter
+ * afterwards already sees the new snapshot; the second phase covers it for
+ * the next update. The updater polls a busy slot a few times and then
+ * yields the cpu to the reader.
+ * ****************************************************************************/
+static void lib_ttyportmux__synchronize(void)
+{
+	unsigned int phase, epoch, slot, spin;
+
+	for (phase = 0; phase < 2; phase++) {
+		epoch = atomic_fetch_add_explicit(&s_stream.epoch, 1, memory_order_seq_cst) & 1;
+		for (slot = 0; slot < M_TTYPORTMUX_READER_SLOTS; slot++) {
+			spin = 0;
+			while (atomic_load_explicit(&s_streamReaders[slot].count[epoch], memory_order_acquire) != 0) {
+				if (++spin >= M_TTYPORTMUX_SPIN_MAX) {
+					M_TTYPORTMUX_YIELD();
+					spin = 0;
+				}
+			}
+		}
+	}
+}
+
+/* ************************************************************************//**
+ * \brief Write of a message to all ttydevices of a stream
+ *
+ * A stream with a single device is formatted by its driver. Otherwise the
+ * message is formatted once into the scratch arena of the thread and the
+ * same bytes are written to each device. A coalesced or prefixed stream is
+ * always formatted here, a prefixed message exceeding the arena is cut to it
+ * keeping its last character.
+ *
+ * \return	EOK if successful, or the first negative errno value of a device
+ * ****************************************************************************/
+static int lib_ttyportmux__vdispatch(const struct ttyStreamFanout *_fanout, enum ttyStreamType _streamType, const char * const _format, va_list _ap)
+{
+	char scratch[M_TTYPORTMUX_SCRATCH_SIZE];
+	const struct ttyDispatch *dispatch;
+	unsigned int i;
+	int body, ret = EOK, dev_ret, coalesce, prefix, fits;
+	size_t size, len, prefixLen = 0;
+	char *buf;
+	va_list ap;
+
+	lib_ttyportmux__coalesce_due();
+
+	coalesce = tty_portmux_coalesce__enabled(_streamType);
+	prefix = tty_portmux_prefix__enabled();
+	if ((_fanout->count == 1) && !coalesce && !prefix) {
+		ret = lib_ttyportmux__write(&_fanout->dispatch[0], _streamType, _format, _ap);
+		tty_portmux_stats__stream(_streamType, ret, (ret > EOK) ? (size_t)ret : 0);
+		return (ret < EOK) ? ret : EOK;
+	}
+
+	buf = tty_portmux_arena__get(TTY_ARENA_core, &size);
+	if (buf == NULL) {
+		buf = &scratch[0];
+		size = sizeof(scratch);
+	}
+
+	if (prefix) {
+		prefixLen = tty_portmux_prefix__render(buf, lib_ttyportmux__stream_name(_streamType));
+	}
+
+	va_copy(ap, _ap);
+	body = tty_portmux_fmt__vformat(&buf[prefixLen], size - prefixLen, _format, ap);
+	va_end(ap);
+	if (body < 0) {
+		tty_portmux_stats__stream(_streamType, -ESTD_INVAL, 0);
+		return -ESTD_INVAL;
+	}
+
+	len = prefixLen + (size_t)body;
+	fits = (len < size);
+	if (!fits && (prefixLen > 0)) {
+		/* cut to the arena, the last character (the newline) is kept */
+		len = size - 1;
+		fits = 1;
+		va_copy(ap, _ap);
+		tty_portmux_fmt__vformat_at(&buf[len - 1], 1, (size_t)body - 1, _format, ap);
+		va_end(ap);
+		tty_portmux_stats__truncate(_streamType);
+	}
+
+	/* messages exceeding the scratch arena are not coalesced */
+	if (coalesce && fits) {
+		return lib_ttyportmux__coalesce(_fanout, _streamType, _format, buf, len, prefixLen);
+	}
+
+	for (i = 0; i < _fanout->count; i++) {
+		dispatch = &_fanout->dispatch[i];
+		if (fits) {
+			dev_ret = lib_ttyportmux__write_buf(dispatch, _streamType, buf, len);
+		}
+		else {
+			/* message exceeds the scratch arena, each driver formats on its own */
+			va_copy(ap, _ap);
+			dev_ret = lib_ttyportmux__write(dispatch, _streamType, _format, ap);
+			va_end(ap);
+		}
+		if ((dev_ret < EOK) && (ret == EOK)) {
+			ret = dev_ret;
+		}
+	}
+	tty_portmux_stats__stream(_streamType, ret, len);
+	return ret;
+}
+
+/* ************************************************************************//**
+ * \brief	Write of an already formatted message to all ttydevices of a
+ * 			stream in the current mode, the formatting of the drivers is
+ * 			bypassed. A prefixed message exceeding the arena is cut to it
+ * 			keeping its last character.
+ *
+ * \return	EOK if successful, or the first negative errno value of a device
+ * ****************************************************************************/
+static int lib_ttyportmux__bdispatch(const struct ttyStreamFanout *_fanout, enum ttyStreamType _streamType, const char *_buf, size_t _len)
+{
+	char scratch[M_TTYPORTMUX_SCRATCH_SIZE];
+	size_t size, prefixLen = 0;
+	char *buf;
+
+#if defined(M_TTYPORTMUX_ASYNC)
+	if (s_mode == TTYMUX_MODE_async) {
+		char prefix[M_TTYPREFIX_SIZE];
+		int ret;
+
+		if (tty_portmux_prefix__enabled()) {
+			prefixLen = tty_portmux_prefix__render(&prefix[0], lib_ttyportmux__stream_name(_streamType));
+		}
+		ret = tty_portmux_async__write(_streamType, &prefix[0], prefixLen, _buf, _len);
+		if (ret == -ESTD_AGAIN) {
+			tty_portmux_stats__drop(_streamType);
+		}
+		return ret;
+	}
+#endif
+
+	lib_ttyportmux__coalesce_due();
+
+	if (!tty_portmux_prefix__enabled()) {
+		if (tty_portmux_coalesce__enabled(_streamType)) {
+			return lib_ttyportmux__coalesce(_fanout, _streamType, NULL, _buf, _len, 0);
+		}
+		return lib_ttyportmux__dispatch_buf(_fanout, _streamType, _buf, _len);
+	}
+
+	buf = tty_portmux_arena__get(TTY_ARENA_core, &size);
+	if (buf == NULL) {
+		buf = &scratch[0];
+		size = sizeof(scratch);
+	}
+
+	prefixLen = tty_portmux_prefix__render(buf, lib_ttyportmux__stream_name(_streamType));
+	if (_len >= (size - prefixLen)) {
+		/* cut to the arena, the last character (the newline) is kept */
+		memcpy(&buf[prefixLen], _buf, size - prefixLen - 2);
+		buf[size - 2] = _buf[_len - 1];
+		_len = size - prefixLen - 1;
+		tty_portmux_stats__truncate(_streamType);
+	}
+	else {
+		memcpy(&buf[prefixLen], _buf, _len);
+	}
+
+	if (tty_portmux_coalesce__enabled(_streamType)) {
+		return lib_ttyportmux__coalesce(_fanout, _streamType, NULL, buf, prefixLen + _len, prefixLen);
+	}
+	return lib_ttyportmux__dispatch_buf(_fanout, _streamType, buf, prefixLen + _len);
+}
+
 static char* lib_ttyportmux__stream_name(enum ttyStreamType _streamType)
 {
 	switch(_streamType) {
@@ -560,12 +1708,369 @@ static char* lib_ttyportmux__stream_name(enum ttyStreamType _streamType)
 		case TTYSTREAM_info			: return "TTYSTREAM_info    ";
 		case TTYSTREAM_debug 		: return "TTYSTREAM_debug   ";
 		case TTYSTREAM_control		: return "TTYSTREAM_control ";
-		default:
-		{
-			static char name[20];
-			memset(&name[0],0,sizeof(name));
-			mini_snprintf(&name[0], sizeof(name), "TTY_STREAM_%u", (int)_streamType);
-			return &name[0];
+		default						: return "TTYSTREAM_unknown ";
+	}
+}
+
+/* ************************************************************************//**
+ * \brief	Write of a message to a ttydevice, accounted at the device counters
+ *
+ * \return	number of bytes, EOK if not known, or negative errno value on error
+ * ****************************************************************************/
+static int lib_ttyportmux__write(const struct ttyDispatch *_dispatch, enum ttyStreamType _streamType, const char * const _format, va_list _ap)
+{
+	uint64_t start;
+	int ret;
+
+	start = tty_portmux_latency__start();
+	ret = M_TTYDRIVER_WRITE(_dispatch)(_dispatch->ttydevice, _streamType, _format, _ap);
+	tty_portmux_latency__stop(_dispatch->deviceId, start);
+	tty_portmux_stats__device(_dispatch->deviceId, ret, (ret > EOK) ? (size_t)ret : 0);
+	return ret;
+}
+
+/* ************************************************************************//**
+ * \brief	Write of already formatted bytes to a ttydevice
+ *
+ * Drivers without a write_buf operation get the bytes through their format
+ * interface.
+ *
+ * \param   _dispatch	device to write to
+ * \param   _streamType	Categorization of the requirements at the stdio device
+ * \param   _buf			formatted bytes
+ * \param   _len			number of bytes
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+static int lib_ttyportmux__write_buf(const struct ttyDispatch *_dispatch, enum ttyStreamType _streamType, const char *_buf, size_t _len)
+{
+	uint64_t start;
+	int ret;
+
+	start = tty_portmux_latency__start();
+	if (M_TTYDRIVER_HAS_WRITE_BUF(_dispatch)) {
+		ret = M_TTYDRIVER_WRITE_BUF(_dispatch)(_dispatch->ttydevice, _streamType, _buf, _len);
+	}
+	else {
+		ret = lib_ttyportmux__write_fmt(_dispatch, _streamType, "%.*s", (int)_len, _buf);
+	}
+	tty_portmux_latency__stop(_dispatch->deviceId, start);
+	tty_portmux_stats__device(_dispatch->deviceId, ret, _len);
+	return ret;
+}
+
+/* ************************************************************************//**
+ * \brief	Write of a single character to a ttydevice
+ * ****************************************************************************/
+static int lib_ttyportmux__put_char(const struct ttyDispatch *_dispatch, enum ttyStreamType _streamType, char _c)
+{
+	uint64_t start;
+	int ret;
+
+	if (!M_TTYDRIVER_HAS_PUT_CHAR(_dispatch)) {
+		return lib_ttyportmux__write_buf(_dispatch, _streamType, &_c, 1);
+	}
+
+	start = tty_portmux_latency__start();
+	ret = M_TTYDRIVER_PUT_CHAR(_dispatch)(_dispatch->ttydevice, _streamType, _c);
+	tty_portmux_latency__stop(_dispatch->deviceId, start);
+	tty_portmux_stats__device(_dispatch->deviceId, ret, 1);
+	return ret;
+}
+
+static int lib_ttyportmux__write_fmt(const struct ttyDispatch *_dispatch, enum ttyStreamType _streamType, const char * const _format, ...)
+{
+	int ret;
+	va_list ap;
+
+	va_start(ap, _format);
+	ret = M_TTYDRIVER_WRITE(_dispatch)(_dispatch->ttydevice, _streamType, _format, ap);
+	va_end(ap);
+	return ret;
+}
+
+/* ************************************************************************//**
+ * \brief	Write of the buffered bytes of all ttydevices which provide a flush
+ * ****************************************************************************/
+static void lib_ttyportmux__flush_devices(void)
+{
+	struct list_node *ttydevice_node;
+	ttydevice_t *ttydevice;
+	int ret;
+
+	ret = lib_list__get_begin(&s_ttydriverList ,&ttydevice_node, M_LIB_LIST_CONTEXT_ID, M_LIB_LIST_BASE_ADDR);
+	if (ret < EOK) {
+		return;
+	}
+
+	do {
+		ttydevice = (ttydevice_t*)GET_CONTAINER_OF(ttydevice_node, struct ttydevice, node);
+		if ((ttydevice->ttydriver != NULL) && (ttydevice->ttydriver->flush != NULL)) {
+			(*ttydevice->ttydriver->flush)(ttydevice);
+		}
+	}while(ret = lib_list__get_next(&s_ttydriverList,&ttydevice_node, M_LIB_LIST_CONTEXT_ID, M_LIB_LIST_BASE_ADDR), (ret == LIB_LIST__EOK));
+}
+
+/* ************************************************************************//**
+ * \brief	Write of a message of the library itself in the current mode
+ * ****************************************************************************/
+static int lib_ttyportmux__emit(const struct ttyStreamFanout *_fanout, enum ttyStreamType _streamType, const char * const _format, ...)
+{
+	va_list ap;
+	int ret;
+
+	va_start(ap, _format);
+#if defined(M_TTYPORTMUX_ASYNC)
+	if (s_mode == TTYMUX_MODE_async) {
+		ret = lib_ttyportmux__enqueue(_streamType, _format, ap);
+		va_end(ap);
+		return ret;
+	}
+#endif
+	ret = lib_ttyportmux__vdispatch(_fanout, _streamType, _format, ap);
+	va_end(ap);
+	return ret;
+}
+
+/* ************************************************************************//**
+ * \brief	Report of the messages suppressed by the rate limit of a stream
+ * ****************************************************************************/
+static void lib_ttyportmux__suppressed(const struct ttyStreamFanout *_fanout, enum ttyStreamType _streamType, uint64_t _suppressed)
+{
+	const char *name = lib_ttyportmux__stream_name(_streamType);
+
+	lib_ttyportmux__emit(_fanout, _streamType, "%llu messages suppressed on %.*s\n",
+			(unsigned long long)_suppressed, (int)strcspn(name, " "), name);
+}
+
+/* ************************************************************************//**
+ * \brief	Write of a formatted message to all ttydevices of a stream
+ *
+ * \return	EOK if successful, or the first negative errno value of a device
+ * ****************************************************************************/
+static int lib_ttyportmux__dispatch_buf(const struct ttyStreamFanout *_fanout, enum ttyStreamType _streamType, const char *_buf, size_t _len)
+{
+	unsigned int i;
+	int ret = EOK, dev_ret;
+
+	for (i = 0; i < _fanout->count; i++) {
+		dev_ret = lib_ttyportmux__write_buf(&_fanout->dispatch[i], _streamType, _buf, _len);
+		if ((dev_ret < EOK) && (ret == EOK)) {
+			ret = dev_ret;
+		}
+	}
+	tty_portmux_stats__stream(_streamType, ret, _len);
+	return ret;
+}
+
+/* ************************************************************************//**
+ * \brief	Write of a formatted message of a coalesced stream, a repeat of
+ * 			the previous message is only counted
+ * ****************************************************************************/
+static int lib_ttyportmux__coalesce(const struct ttyStreamFanout *_fanout, enum ttyStreamType _streamType, const void *_format, const char *_buf, size_t _len, size_t _prefixLen)
+{
+	uint64_t repeats;
+	int write;
+
+	write = tty_portmux_coalesce__check(_streamType, _format, _buf + _prefixLen, _len - _prefixLen, &repeats);
+	if (repeats > 0) {
+		lib_ttyportmux__repeated(_fanout, _streamType, repeats);
+	}
+
+	return write ? lib_ttyportmux__dispatch_buf(_fanout, _streamType, _buf, _len) : EOK;
+}
+
+/* ************************************************************************//**
+ * \brief	Report of the pending repeats of all coalesced streams
+ *
+ * \param	_all	: non zero reports all, otherwise those older than the interval
+ * ****************************************************************************/
+static void lib_ttyportmux__coalesce_expire(int _all)
+{
+	struct ttyStreamFanout fanout;
+	enum ttyStreamType streamType;
+	uint64_t repeats;
+
+	for (streamType = 0; streamType < TTYSTREAM_CNT; streamType++) {
+		repeats = tty_portmux_coalesce__expire(streamType, _all);
+		if ((repeats > 0) && (lib_ttyportmux__stream_to_fanout(streamType, &fanout) == EOK)) {
+			lib_ttyportmux__repeated(&fanout, streamType, repeats);
+		}
+	}
+}
+
+/* ************************************************************************//**
+ * \brief	Report of the pending repeats which are due in sync mode
+ *
+ * The sync mode has no timer, the repeats of a stream which went quiet are
+ * reported by the next message of any stream after the interval.
+ * ****************************************************************************/
+static void lib_ttyportmux__coalesce_due(void)
+{
+	if (tty_portmux_coalesce__take_due()) {
+		lib_ttyportmux__coalesce_expire(0);
+	}
+}
+
+#if defined(M_TTYPORTMUX_COALESCE)
+/* ************************************************************************//**
+ * \brief	Report of the pending repeats of the streams whose coalescing was
+ * 			switched, their previous message is discarded
+ *
+ * A stream coalesced again later does not take its first message for a
+ * repeat of a message of the previous period.
+ * ****************************************************************************/
+static void lib_ttyportmux__coalesce_reset(unsigned int _mask)
+{
+	struct ttyStreamFanout fanout;
+	enum ttyStreamType streamType;
+	unsigned int epoch;
+	uint64_t repeats;
+
+	for (streamType = 0; streamType < TTYSTREAM_CNT; streamType++) {
+		if ((_mask & M_TTYSTREAM_BIT(streamType)) == 0) {
+			continue;
+		}
+
+		repeats = tty_portmux_coalesce__reset(streamType);
+		if (repeats > 0) {
+			epoch = lib_ttyportmux__read_lock();
+			if ((s_initCount > 0) && (lib_ttyportmux__stream_to_fanout(streamType, &fanout) == EOK)) {
+				lib_ttyportmux__repeated(&fanout, streamType, repeats);
+			}
+			lib_ttyportmux__read_unlock(epoch);
 		}
 	}
-}
\ No newline at end of file
+}
+#endif
+
+static void lib_ttyportmux__repeated(const struct ttyStreamFanout *_fanout, enum ttyStreamType _streamType, uint64_t _repeats)
+{
+	char line[M_TTYPREFIX_SIZE + 64];
+	size_t prefixLen = 0;
+	int len;
+
+	if (tty_portmux_prefix__enabled()) {
+		prefixLen = tty_portmux_prefix__render(&line[0], lib_ttyportmux__stream_name(_streamType));
+	}
+	len = tty_portmux_fmt__format(&line[prefixLen], sizeof(line) - prefixLen, "last message repeated %llu times\n", (unsigned long long)_repeats);
+	lib_ttyportmux__dispatch_buf(_fanout, _streamType, &line[0], prefixLen + (size_t)len);
+}
+
+/* ************************************************************************//**
+ * \brief	Capture of a message into the ring of the calling thread, it is
+ * 			only written if an error is printed on this thread
+ * ****************************************************************************/
+static int lib_ttyportmux__capture(enum ttyStreamType _streamType, const char * const _format, va_list _ap)
+{
+	char prefix[M_TTYPREFIX_SIZE];
+	size_t prefixLen = 0;
+
+	if (tty_portmux_prefix__enabled()) {
+		prefixLen = tty_portmux_prefix__render(&prefix[0], lib_ttyportmux__stream_name(_streamType));
+	}
+	return tty_portmux_capture__vprint(_streamType, &prefix[0], prefixLen, _format, _ap);
+}
+
+/* ************************************************************************//**
+ * \brief	Capture of a record, a character of putchar is captured without
+ * 			prefix
+ * ****************************************************************************/
+static int lib_ttyportmux__capture_fmt(enum ttyStreamType _streamType, int _prefix, const char * const _format, ...)
+{
+	va_list ap;
+	int ret;
+
+	va_start(ap, _format);
+	if (_prefix) {
+		ret = lib_ttyportmux__capture(_streamType, _format, ap);
+	}
+	else {
+		ret = tty_portmux_capture__vprint(_streamType, "", 0, _format, ap);
+	}
+	va_end(ap);
+	return ret;
+}
+
+/* ************************************************************************//**
+ * \brief	Write of the captured records of the calling thread, oldest first,
+ * 			to the devices of their streams
+ * ****************************************************************************/
+static void lib_ttyportmux__capture_flush(void)
+{
+	char scratch[M_TTYPORTMUX_SCRATCH_SIZE];
+	struct ttyStreamFanout fanout;
+	enum ttyStreamType streamType;
+	size_t len, size;
+	char *buf;
+
+	buf = tty_portmux_arena__get(TTY_ARENA_core, &size);
+	if (buf == NULL) {
+		buf = &scratch[0];
+		size = sizeof(scratch);
+	}
+
+	while ((len = tty_portmux_capture__next(buf, size, &streamType)) > 0) {
+		if (lib_ttyportmux__stream_to_fanout(streamType, &fanout) < EOK) {
+			continue;
+		}
+#if defined(M_TTYPORTMUX_ASYNC)
+		if (s_mode == TTYMUX_MODE_async) {
+			if (tty_portmux_async__write(streamType, "", 0, buf, len) == -ESTD_AGAIN) {
+				tty_portmux_stats__drop(streamType);
+			}
+			continue;
+		}
+#endif
+		lib_ttyportmux__dispatch_buf(&fanout, streamType, buf, len);
+	}
+}
+
+#if defined(M_TTYPORTMUX_ASYNC)
+/* ************************************************************************//**
+ * \brief	Dispatch of a queued record, called on the drain thread
+ *
+ * \param   _streamType	Categorization of the requirements at the stdio device
+ * \param   _buf			formatted record
+ * \param   _len			length of the record
+ * \param   _prefixLen	length of the prefix at the start of the record
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+static int lib_ttyportmux__async_sink(enum ttyStreamType _streamType, const char *_buf, size_t _len, size_t _prefixLen)
+{
+	struct ttyStreamFanout fanout;
+	int ret;
+
+	ret = lib_ttyportmux__stream_to_fanout(_streamType, &fanout);
+	if (ret < EOK) {
+		return ret;
+	}
+
+	if (tty_portmux_coalesce__enabled(_streamType)) {
+		return lib_ttyportmux__coalesce(&fanout, _streamType, NULL, _buf, _len, _prefixLen);
+	}
+	return lib_ttyportmux__dispatch_buf(&fanout, _streamType, _buf, _len);
+}
+
+/* ************************************************************************//**
+ * \brief	Called on the drain thread after a burst of records was written
+ * ****************************************************************************/
+static void lib_ttyportmux__async_idle(void)
+{
+	lib_ttyportmux__coalesce_expire(0);
+	lib_ttyportmux__flush_devices();
+}
+
+/* ************************************************************************//**
+ * \brief	Queue of a message, the prefix is rendered on the thread of the caller
+ * ****************************************************************************/
+static int lib_ttyportmux__enqueue(enum ttyStreamType _streamType, const char * const _format, va_list _ap)
+{
+	char prefix[M_TTYPREFIX_SIZE];
+	size_t prefixLen = 0;
+
+	if (tty_portmux_prefix__enabled()) {
+		prefixLen = tty_portmux_prefix__render(&prefix[0], lib_ttyportmux__stream_name(_streamType));
+	}
+	return tty_portmux_async__vprint(_streamType, &prefix[0], prefixLen, _format, _ap);
+}
+#endif
@@ -0,0 +1,233 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal 
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* *******************************************************************
+ * includes
+ * ******************************************************************/
+
+/* c -runtime */
+#include <stdatomic.h>
+#include <stdint.h>
+#include <pthread.h>
+
+/* frame */
+#include <lib_convention__errno.h>
+#include <lib_convention__mem.h>
+
+/* project */
+#include "tty_portmux_arena.h"
+
+/* *******************************************************************
+ * defines
+ * ******************************************************************/
+#define M_TTYARENA_CACHE_LINE		64
+
+/* *******************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ******************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Preallocated arenas, an arena is owned by a single thread
+ * ****************************************************************************/
+struct tty_arena_pool {
+	void *mem;
+	char *arenas;				/*!< cache line aligned start of the first arena */
+	atomic_uint *used;			/*!< 1 if the arena is owned by a thread */
+	unsigned int count;
+	size_t size;				/*!< bytes of a region, an arena holds TTY_ARENA_CNT regions */
+};
+
+/* ************************************************************************//**
+ * \brief	Arena of a thread
+ * ****************************************************************************/
+struct tty_arena {
+	char *mem;
+	size_t size;
+	unsigned int generation;	/*!< pool the arena was taken from */
+	int index;					/*!< arena of the pool, -1 if allocated for this thread */
+};
+
+/* *******************************************************************
+ * static function declarations
+ * ******************************************************************/
+static int tty_portmux_arena__acquire(struct tty_arena *_arena);
+static void tty_portmux_arena__key_create(void);
+static void tty_portmux_arena__release(void *_arena);
+
+/* *******************************************************************
+ * static data
+ * ******************************************************************/
+static struct tty_arena_pool s_pool = { .size = M_TTYARENA_SIZE_DEFAULT };
+static atomic_uint s_generation = 1;
+static pthread_once_t s_keyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t s_key;
+static _Thread_local struct tty_arena s_arena = { .index = -1 };
+
+/* *******************************************************************
+ * function definition
+ * ******************************************************************/
+
+int tty_portmux_arena__init(unsigned int _count, size_t _size)
+{
+	size_t arenaSize;
+	unsigned int i;
+
+	if (s_pool.mem != NULL) {
+		return EOK;
+	}
+
+	if (_size == 0) {
+		_size = M_TTYARENA_SIZE_DEFAULT;
+	}
+	else if (_size < M_TTYARENA_SIZE_MIN) {
+		_size = M_TTYARENA_SIZE_MIN;
+	}
+
+	s_pool.size = _size;
+	s_pool.count = 0;
+	if (_count > 0) {
+		arenaSize = (TTY_ARENA_CNT * _size + M_TTYARENA_CACHE_LINE - 1) & ~((size_t)M_TTYARENA_CACHE_LINE - 1);
+		s_pool.mem = alloc_memory(1, ((size_t)_count * arenaSize) + M_TTYARENA_CACHE_LINE);
+		s_pool.used = (atomic_uint*)alloc_memory(_count, sizeof(atomic_uint));
+		if ((s_pool.mem == NULL) || (s_pool.used == NULL)) {
+			if (s_pool.mem != NULL) {
+				free_memory(s_pool.mem);
+				s_pool.mem = NULL;
+			}
+			if (s_pool.used != NULL) {
+				free_memory(s_pool.used);
+				s_pool.used = NULL;
+			}
+			return -ESTD_NOMEM;
+		}
+
+		s_pool.arenas = (char*)(((uintptr_t)s_pool.mem + M_TTYARENA_CACHE_LINE - 1) & ~((uintptr_t)M_TTYARENA_CACHE_LINE - 1));
+		for (i = 0; i < _count; i++) {
+			atomic_init(&s_pool.used[i], 0);
+		}
+		s_pool.count = _count;
+	}
+
+	pthread_once(&s_keyOnce, &tty_portmux_arena__key_create);
+	atomic_fetch_add_explicit(&s_generation, 1, memory_order_release);
+	return EOK;
+}
+
+void tty_portmux_arena__cleanup(void)
+{
+	atomic_fetch_add_explicit(&s_generation, 1, memory_order_release);
+	if (s_pool.mem != NULL) {
+		free_memory(s_pool.mem);
+		free_memory(s_pool.used);
+	}
+	s_pool.mem = NULL;
+	s_pool.arenas = NULL;
+	s_pool.used = NULL;
+	s_pool.count = 0;
+}
+
+char* tty_portmux_arena__get(enum tty_arena_use _use, size_t *_size)
+{
+	struct tty_arena *arena = &s_arena;
+
+	if ((arena->mem == NULL) || (arena->generation != atomic_load_explicit(&s_generation, memory_order_acquire))) {
+		if (tty_portmux_arena__acquire(arena) < EOK) {
+			*_size = 0;
+			return NULL;
+		}
+	}
+
+	*_size = arena->size;
+	return arena->mem + ((size_t)_use * arena->size);
+}
+
+/* *******************************************************************
+ * static function definitions
+ * ******************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Take of a free arena of the pool, or allocation of an arena for
+ * 			the calling thread if the pool is exhausted
+ * ****************************************************************************/
+static int tty_portmux_arena__acquire(struct tty_arena *_arena)
+{
+	unsigned int i, generation, expected;
+	size_t arenaSize;
+
+	/* an arena of a released pool is dropped, an own arena is replaced */
+	if ((_arena->mem != NULL) && (_arena->index < 0)) {
+		free_memory(_arena->mem);
+	}
+	_arena->mem = NULL;
+	_arena->index = -1;
+
+	generation = atomic_load_explicit(&s_generation, memory_order_acquire);
+	arenaSize = (TTY_ARENA_CNT * s_pool.size + M_TTYARENA_CACHE_LINE - 1) & ~((size_t)M_TTYARENA_CACHE_LINE - 1);
+
+	for (i = 0; i < s_pool.count; i++) {
+		expected = 0;
+		if (atomic_compare_exchange_strong_explicit(&s_pool.used[i], &expected, 1, memory_order_acquire, memory_order_relaxed)) {
+			_arena->mem = s_pool.arenas + ((size_t)i * arenaSize);
+			_arena->index = (int)i;
+			break;
+		}
+	}
+
+	if (_arena->mem == NULL) {
+		_arena->mem = (char*)alloc_memory(TTY_ARENA_CNT, s_pool.size);
+		if (_arena->mem == NULL) {
+			return -ESTD_NOMEM;
+		}
+	}
+
+	_arena->size = s_pool.size;
+	_arena->generation = generation;
+
+	pthread_once(&s_keyOnce, &tty_portmux_arena__key_create);
+	pthread_setspecific(s_key, _arena);
+	return EOK;
+}
+
+static void tty_portmux_arena__key_create(void)
+{
+	pthread_key_create(&s_key, &tty_portmux_arena__release);
+}
+
+/* ************************************************************************//**
+ * \brief	Return of the arena at the exit of its thread
+ * ****************************************************************************/
+static void tty_portmux_arena__release(void *_arena)
+{
+	struct tty_arena *arena = (struct tty_arena*)_arena;
+
+	if (arena->index < 0) {
+		free_memory(arena->mem);
+	}
+	else if (arena->generation == atomic_load_explicit(&s_generation, memory_order_acquire)) {
+		atomic_store_explicit(&s_pool.used[arena->index], 0, memory_order_release);
+	}
+	arena->mem = NULL;
+	arena->index = -1;
+}
@@ -0,0 +1,98 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal 
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _TTY_PORTMUX_ARENA_H_
+#define _TTY_PORTMUX_ARENA_H_
+
+/* *******************************************************************
+ * includes
+ * ******************************************************************/
+
+/* c runtime */
+#include <stddef.h>
+
+/* *******************************************************************
+ * defines
+ * ******************************************************************/
+#define M_TTYARENA_SIZE_DEFAULT		1024	/*!< bytes of each region if not configured */
+#define M_TTYARENA_SIZE_MIN			256
+
+/* *******************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ******************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Region of a thread arena, the mux core formats into its own
+ * 			region while the drivers it calls format into theirs
+ * ****************************************************************************/
+enum tty_arena_use {
+	TTY_ARENA_core,
+	TTY_ARENA_driver,
+	TTY_ARENA_CNT
+};
+
+/* *******************************************************************
+ * function declarations
+ * ******************************************************************/
+#if defined(M_TTYPORTMUX_ARENA)
+
+/* ************************************************************************//**
+ * \brief	Preallocation of the arena pool
+ *
+ * An existing pool is kept.
+ *
+ * \param   _count	: arenas of the pool, 0 allocates an arena per thread
+ * 					  on its first message
+ * \param   _size	: bytes of each region of an arena, 0 selects the default
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+int tty_portmux_arena__init(unsigned int _count, size_t _size);
+
+/* ************************************************************************//**
+ * \brief	Release of the arena pool, threads take a new arena on their
+ * 			next message
+ * ****************************************************************************/
+void tty_portmux_arena__cleanup(void);
+
+/* ************************************************************************//**
+ * \brief	Region of the arena of the calling thread
+ *
+ * The arena is taken from the pool on the first call of a thread and is
+ * returned at thread exit. If the pool is exhausted, the arena of the
+ * thread is allocated once.
+ *
+ * \param   _use			: region of the arena
+ * \param   _size [out]	: bytes of the region
+ * \return	region, NULL if no arena is available
+ * ****************************************************************************/
+char* tty_portmux_arena__get(enum tty_arena_use _use, size_t *_size);
+
+#else
+
+static inline char* tty_portmux_arena__get(enum tty_arena_use _use, size_t *_size) { (void)_use; *_size = 0; return NULL; }
+
+#endif /* M_TTYPORTMUX_ARENA */
+
+#endif /* _TTY_PORTMUX_ARENA_H_ */
@@ -0,0 +1,461 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal 
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* *******************************************************************
+ * includes
+ * ******************************************************************/
+
+/* c -runtime */
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sched.h>
+
+/* frame */
+#include <lib_convention__errno.h>
+#include <lib_convention__mem.h>
+
+/* project */
+#include "tty_portmux_async.h"
+#include "tty_portmux_fmt.h"
+#include "tty_portmux_stats.h"
+
+/* *******************************************************************
+ * defines
+ * ******************************************************************/
+#define M_TTYMUX_CACHE_LINE			64
+#define M_TTYMUX_SLOT_MIN			64
+#define M_TTYMUX_RENDER_SIZE		1024
+#define M_TTYMUX_SLOT_PACKED		0x0001
+#define M_TTYMUX_SLOT(__pos)		((struct tty_portmux_slot*)(s_ring.slots + (((__pos) & s_ring.mask) * s_ring.slotSize)))
+
+/* *******************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ******************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Header of a ring slot, the payload follows inline.
+ *
+ * seq == pos       : slot is free for the producer at enqueue position pos
+ * seq == pos + 1   : slot is committed and ready for the drain thread
+ * ****************************************************************************/
+struct tty_portmux_slot {
+	atomic_size_t seq;
+	uint8_t streamType;
+	uint8_t flags;
+	uint16_t prefixLen;		/*!< formatted prefix at the start of data */
+	uint32_t len;			/*!< bytes of data including the prefix */
+	char data[];
+};
+
+struct tty_portmux_ring {
+	_Alignas(M_TTYMUX_CACHE_LINE) atomic_size_t enqueuePos;		/*!< shared by all producers */
+	_Alignas(M_TTYMUX_CACHE_LINE) atomic_int sleeping;			/*!< drain thread waits on wakeup */
+	_Alignas(M_TTYMUX_CACHE_LINE) size_t dequeuePos;			/*!< owned by the drain thread */
+	atomic_int running;
+	void *mem;
+	char *slots;
+	size_t slotSize;
+	size_t dataSize;
+	size_t mask;
+	enum ttyMuxOverflow overflow;
+	enum ttyMuxFormat format;
+	tty_portmux_sink_t *sink;
+	tty_portmux_idle_t *idle;
+	sem_t wakeup;
+	pthread_t drainThread;
+};
+
+/* *******************************************************************
+ * static function declarations
+ * ******************************************************************/
+static struct tty_portmux_slot* tty_portmux_async__reserve(size_t *_pos);
+static void tty_portmux_async__commit(struct tty_portmux_slot *_slot, size_t _pos);
+static void* tty_portmux_async__drain(void *_arg);
+
+/* *******************************************************************
+ * static data
+ * ******************************************************************/
+static struct tty_portmux_ring s_ring;
+
+/* *******************************************************************
+ * function definition
+ * ******************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Allocation of the record ring and start of the drain thread
+ *
+ * \param	_config	: ring dimensions and overflow behaviour
+ * \param	_sink	: consumer of the queued records
+ * \param	_idle	: called after a burst of records was drained, optional
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+int tty_portmux_async__start(const struct ttyMuxConfig *_config, tty_portmux_sink_t *_sink, tty_portmux_idle_t *_idle)
+{
+	size_t i, slotCount, slotSize;
+	struct tty_portmux_slot *slot;
+	int ret;
+
+	if ((_config == NULL) || (_sink == NULL)) {
+		return -EPAR_NULL;
+	}
+
+	if ((_config->ringSlots < 2) || (_config->slotSize < M_TTYMUX_SLOT_MIN)) {
+		return -ESTD_INVAL;
+	}
+
+	if (s_ring.mem != NULL) {
+		return -ESTD_BUSY;
+	}
+
+	for (slotCount = 2; slotCount < _config->ringSlots; slotCount <<= 1);
+	slotSize = (_config->slotSize + M_TTYMUX_CACHE_LINE - 1) & ~((size_t)M_TTYMUX_CACHE_LINE - 1);
+
+	s_ring.mem = alloc_memory(1, (slotCount * slotSize) + M_TTYMUX_CACHE_LINE);
+	if (s_ring.mem == NULL) {
+		return -ESTD_NOMEM;
+	}
+
+	s_ring.slots = (char*)(((uintptr_t)s_ring.mem + M_TTYMUX_CACHE_LINE - 1) & ~((uintptr_t)M_TTYMUX_CACHE_LINE - 1));
+	s_ring.slotSize = slotSize;
+	s_ring.dataSize = slotSize - sizeof(struct tty_portmux_slot);
+	s_ring.mask = slotCount - 1;
+	s_ring.overflow = _config->overflow;
+	s_ring.format = _config->format;
+	s_ring.sink = _sink;
+	s_ring.idle = _idle;
+	s_ring.dequeuePos = 0;
+	atomic_init(&s_ring.enqueuePos, 0);
+	atomic_init(&s_ring.sleeping, 0);
+	atomic_init(&s_ring.running, 1);
+
+	for (i = 0; i < slotCount; i++) {
+		slot = M_TTYMUX_SLOT(i);
+		atomic_init(&slot->seq, i);
+	}
+
+	if (sem_init(&s_ring.wakeup, 0, 0) != 0) {
+		ret = convert_std_errno(errno);
+		goto ERR_SEM;
+	}
+
+	ret = pthread_create(&s_ring.drainThread, NULL, &tty_portmux_async__drain, NULL);
+	if (ret != 0) {
+		ret = convert_std_errno(ret);
+		goto ERR_THREAD;
+	}
+
+#if defined(_GNU_SOURCE)
+	pthread_setname_np(s_ring.drainThread, "ttyportmux");
+#endif
+	return EOK;
+
+	ERR_THREAD:
+	sem_destroy(&s_ring.wakeup);
+
+	ERR_SEM:
+	free_memory(s_ring.mem);
+	s_ring.mem = NULL;
+	return ret;
+}
+
+/* ************************************************************************//**
+ * \brief	Drain of all queued records, stop of the drain thread and
+ * 			release of the ring
+ *
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+int tty_portmux_async__stop(void)
+{
+	if (s_ring.mem == NULL) {
+		return -EEXEC_NOINIT;
+	}
+
+	atomic_store(&s_ring.running, 0);
+	sem_post(&s_ring.wakeup);
+	pthread_join(s_ring.drainThread, NULL);
+
+	sem_destroy(&s_ring.wakeup);
+	free_memory(s_ring.mem);
+	s_ring.mem = NULL;
+	return EOK;
+}
+
+/* ************************************************************************//**
+ * \brief	Formatting of a message into the next free record of the ring
+ *
+ * \param   _streamType	: stream the record is dispatched to by the drain thread
+ * \param   _prefix		: formatted prefix of the message, copied in front of it
+ * \param   _prefixLen	: length of the prefix, 0 if none
+ * \param   _format		: "printf" style formatted string argument
+ * \param	_ap			: variable argument list
+ * \return	EOK if successful, -ESTD_AGAIN if the record was dropped
+ * ****************************************************************************/
+int tty_portmux_async__vprint(enum ttyStreamType _streamType, const char *_prefix, size_t _prefixLen, const char * const _format, va_list _ap)
+{
+	struct tty_portmux_slot *slot;
+	size_t pos, size;
+	char *data;
+	va_list ap;
+	int len, cut = 0;
+
+	slot = tty_portmux_async__reserve(&pos);
+	if (slot == NULL) {
+		return -ESTD_AGAIN;
+	}
+
+	/* a prefix of half the slot or more is left out */
+	if (_prefixLen >= (s_ring.dataSize / 2)) {
+		_prefixLen = 0;
+		cut = 1;
+	}
+	memcpy(slot->data, _prefix, _prefixLen);
+	data = slot->data + _prefixLen;
+	size = s_ring.dataSize - _prefixLen;
+
+	if (s_ring.format == TTYMUX_FORMAT_deferred) {
+		/* a packed record may use the whole slot */
+		len = tty_portmux_fmt__pack(data, size, _format, _ap);
+		slot->flags = M_TTYMUX_SLOT_PACKED;
+	}
+	else {
+		va_copy(ap, _ap);
+		len = tty_portmux_fmt__vformat(data, size, _format, ap);
+		va_end(ap);
+		if ((len > 0) && ((size_t)len >= size)) {
+			/* cut to the slot, the last character (the newline) is kept */
+			tty_portmux_fmt__vformat_at(&data[size - 2], 1, (size_t)len - 1, _format, _ap);
+			len = size - 1;
+			cut = 1;
+		}
+		slot->flags = 0;
+	}
+
+	if (len < 0) {
+		len = 0;
+	}
+
+	if (cut) {
+		tty_portmux_stats__truncate(_streamType);
+	}
+
+	slot->streamType = (uint8_t)_streamType;
+	slot->prefixLen = (uint16_t)_prefixLen;
+	slot->len = (uint32_t)(_prefixLen + len);
+	tty_portmux_async__commit(slot, pos);
+	return EOK;
+}
+
+/* ************************************************************************//**
+ * \brief	Queue of an already formatted message, cut to the slot size
+ * 			keeping its last character
+ *
+ * \param   _streamType	: stream the record is dispatched to by the drain thread
+ * \param   _prefix		: message prefix, copied in front of the message
+ * \param   _prefixLen	: length of the prefix, 0 if none
+ * \param   _buf			: formatted message
+ * \param   _len			: length of the message
+ * \return	EOK if successful, -ESTD_AGAIN if the record was dropped
+ * ****************************************************************************/
+int tty_portmux_async__write(enum ttyStreamType _streamType, const char *_prefix, size_t _prefixLen, const char *_buf, size_t _len)
+{
+	struct tty_portmux_slot *slot;
+	size_t pos;
+	int cut = 0;
+
+	slot = tty_portmux_async__reserve(&pos);
+	if (slot == NULL) {
+		return -ESTD_AGAIN;
+	}
+
+	/* a prefix of half the slot or more is left out */
+	if (_prefixLen >= (s_ring.dataSize / 2)) {
+		_prefixLen = 0;
+		cut = 1;
+	}
+	memcpy(slot->data, _prefix, _prefixLen);
+
+	if (_len > (s_ring.dataSize - _prefixLen)) {
+		/* cut to the slot, the last character (the newline) is kept */
+		memcpy(slot->data + _prefixLen, _buf, s_ring.dataSize - _prefixLen - 1);
+		slot->data[s_ring.dataSize - 1] = _buf[_len - 1];
+		_len = s_ring.dataSize - _prefixLen;
+		cut = 1;
+	}
+	else {
+		memcpy(slot->data + _prefixLen, _buf, _len);
+	}
+
+	if (cut) {
+		tty_portmux_stats__truncate(_streamType);
+	}
+	slot->flags = 0;
+	slot->streamType = (uint8_t)_streamType;
+	slot->prefixLen = (uint16_t)_prefixLen;
+	slot->len = (uint32_t)(_prefixLen + _len);
+	tty_portmux_async__commit(slot, pos);
+	return EOK;
+}
+
+/* ************************************************************************//**
+ * \brief	Queue of a single character
+ *
+ * \param   _streamType	: stream the record is dispatched to by the drain thread
+ * \param   _c			: character to queue
+ * \return	EOK if successful, -ESTD_AGAIN if the record was dropped
+ * ****************************************************************************/
+int tty_portmux_async__putchar(enum ttyStreamType _streamType, char _c)
+{
+	struct tty_portmux_slot *slot;
+	size_t pos;
+
+	slot = tty_portmux_async__reserve(&pos);
+	if (slot == NULL) {
+		return -ESTD_AGAIN;
+	}
+
+	slot->data[0] = _c;
+	slot->flags = 0;
+	slot->streamType = (uint8_t)_streamType;
+	slot->prefixLen = 0;
+	slot->len = 1;
+	tty_portmux_async__commit(slot, pos);
+	return EOK;
+}
+
+/* *******************************************************************
+ * static function definitions
+ * ******************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Claim of the slot at the enqueue position (Vyukov bounded queue)
+ *
+ * \param   _pos [out]	: enqueue position of the claimed slot
+ * \return	pointer to the slot, or NULL if the ring is full in drop mode
+ * ****************************************************************************/
+static struct tty_portmux_slot* tty_portmux_async__reserve(size_t *_pos)
+{
+	struct tty_portmux_slot *slot;
+	size_t pos, seq;
+	intptr_t dif;
+
+	pos = atomic_load_explicit(&s_ring.enqueuePos, memory_order_relaxed);
+	for (;;) {
+		slot = M_TTYMUX_SLOT(pos);
+		seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+		dif = (intptr_t)seq - (intptr_t)pos;
+
+		if (dif == 0) {
+			if (atomic_compare_exchange_weak_explicit(&s_ring.enqueuePos, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed)) {
+				*_pos = pos;
+				return slot;
+			}
+		}
+		else if (dif < 0) {
+			if (s_ring.overflow == TTYMUX_OVERFLOW_drop) {
+				return NULL;
+			}
+			sched_yield();
+			pos = atomic_load_explicit(&s_ring.enqueuePos, memory_order_relaxed);
+		}
+		else {
+			pos = atomic_load_explicit(&s_ring.enqueuePos, memory_order_relaxed);
+		}
+	}
+}
+
+/* ************************************************************************//**
+ * \brief	Publish of a filled slot and wakeup of a sleeping drain thread
+ *
+ * The sequentially consistent store pairs with the sleeping flag of the
+ * drain thread, so either the drain thread sees the record or the producer
+ * sees the flag.
+ * ****************************************************************************/
+static void tty_portmux_async__commit(struct tty_portmux_slot *_slot, size_t _pos)
+{
+	atomic_store_explicit(&_slot->seq, _pos + 1, memory_order_seq_cst);
+
+	if (atomic_load_explicit(&s_ring.sleeping, memory_order_seq_cst) != 0) {
+		if (atomic_exchange(&s_ring.sleeping, 0) != 0) {
+			sem_post(&s_ring.wakeup);
+		}
+	}
+}
+
+static void* tty_portmux_async__drain(void *_arg)
+{
+	struct tty_portmux_slot *slot;
+	size_t pos = s_ring.dequeuePos;
+	char render[M_TTYMUX_RENDER_SIZE];
+	int drained = 0;
+	size_t len;
+
+	(void)_arg;
+
+	for (;;) {
+		slot = M_TTYMUX_SLOT(pos);
+		if (atomic_load_explicit(&slot->seq, memory_order_acquire) == (pos + 1)) {
+			if (slot->flags & M_TTYMUX_SLOT_PACKED) {
+				memcpy(render, slot->data, slot->prefixLen);
+				len = tty_portmux_fmt__render(render + slot->prefixLen, sizeof(render) - slot->prefixLen,
+						slot->data + slot->prefixLen, slot->len - slot->prefixLen);
+				if (len > 0) {
+					(*s_ring.sink)((enum ttyStreamType)slot->streamType, render, slot->prefixLen + len, slot->prefixLen);
+				}
+			}
+			else if (slot->len > slot->prefixLen) {
+				(*s_ring.sink)((enum ttyStreamType)slot->streamType, slot->data, slot->len, slot->prefixLen);
+			}
+			atomic_store_explicit(&slot->seq, pos + s_ring.mask + 1, memory_order_release);
+			pos++;
+			drained = 1;
+			continue;
+		}
+
+		if (drained && (s_ring.idle != NULL)) {
+			(*s_ring.idle)();
+			drained = 0;
+			continue;
+		}
+
+		if (atomic_load(&s_ring.running) == 0) {
+			break;
+		}
+
+		atomic_store_explicit(&s_ring.sleeping, 1, memory_order_seq_cst);
+		if ((atomic_load_explicit(&slot->seq, memory_order_seq_cst) == (pos + 1)) || (atomic_load(&s_ring.running) == 0)) {
+			atomic_store(&s_ring.sleeping, 0);
+			continue;
+		}
+		sem_wait(&s_ring.wakeup);
+	}
+
+	s_ring.dequeuePos = pos;
+	return NULL;
+}
@@ -0,0 +1,114 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal 
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _TTY_PORTMUX_ASYNC_H_
+#define _TTY_PORTMUX_ASYNC_H_
+
+/* *******************************************************************
+ * includes
+ * ******************************************************************/
+
+/* c runtime */
+#include <stdarg.h>
+#include <stddef.h>
+
+/* project */
+#include "lib_ttyportmux_types.h"
+
+/* *******************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ******************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Consumer of a formatted record, called on the drain thread
+ *
+ * The first _prefixLen bytes of _buf are the prefix of the message.
+ * ****************************************************************************/
+typedef int (tty_portmux_sink_t)(enum ttyStreamType _streamType, const char *_buf, size_t _len, size_t _prefixLen);
+
+/* ************************************************************************//**
+ * \brief	Called on the drain thread if the ring ran empty
+ * ****************************************************************************/
+typedef void (tty_portmux_idle_t)(void);
+
+/* *******************************************************************
+ * function declarations
+ * ******************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Allocation of the record ring and start of the drain thread
+ *
+ * \param	_config	: ring dimensions and overflow behaviour
+ * \param	_sink	: consumer of the queued records
+ * \param	_idle	: called after a burst of records was drained, optional
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+int tty_portmux_async__start(const struct ttyMuxConfig *_config, tty_portmux_sink_t *_sink, tty_portmux_idle_t *_idle);
+
+/* ************************************************************************//**
+ * \brief	Drain of all queued records, stop of the drain thread and
+ * 			release of the ring
+ *
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+int tty_portmux_async__stop(void);
+
+/* ************************************************************************//**
+ * \brief	Formatting of a message into the next free record of the ring
+ *
+ * In TTYMUX_FORMAT_deferred only the format pointer and the raw arguments
+ * are captured, the text is rendered on the drain thread.
+ *
+ * \param   _streamType	: stream the record is dispatched to by the drain thread
+ * \param   _prefix		: formatted prefix of the message, copied in front of it
+ * \param   _prefixLen	: length of the prefix, 0 if none
+ * \param   _format		: "printf" style formatted string argument
+ * \param	_ap			: variable argument list
+ * \return	EOK if successful, -ESTD_AGAIN if the record was dropped
+ * ****************************************************************************/
+int tty_portmux_async__vprint(enum ttyStreamType _streamType, const char *_prefix, size_t _prefixLen, const char * const _format, va_list _ap);
+
+/* ************************************************************************//**
+ * \brief	Queue of an already formatted message, truncated to the slot size
+ *
+ * \param   _streamType	: stream the record is dispatched to by the drain thread
+ * \param   _prefix		: message prefix, copied in front of the message
+ * \param   _prefixLen	: length of the prefix, 0 if none
+ * \param   _buf			: formatted message
+ * \param   _len			: length of the message
+ * \return	EOK if successful, -ESTD_AGAIN if the record was dropped
+ * ****************************************************************************/
+int tty_portmux_async__write(enum ttyStreamType _streamType, const char *_prefix, size_t _prefixLen, const char *_buf, size_t _len);
+
+/* ************************************************************************//**
+ * \brief	Queue of a single character
+ *
+ * \param   _streamType	: stream the record is dispatched to by the drain thread
+ * \param   _c			: character to queue
+ * \return	EOK if successful, -ESTD_AGAIN if the record was dropped
+ * ****************************************************************************/
+int tty_portmux_async__putchar(enum ttyStreamType _streamType, char _c);
+
+#endif /* _TTY_PORTMUX_ASYNC_H_ */
@@ -0,0 +1,243 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal 
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* *******************************************************************
+ * includes
+ * ******************************************************************/
+
+/* c -runtime */
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+/* frame */
+#include <lib_convention__errno.h>
+#include <lib_convention__mem.h>
+
+/* project */
+#include "tty_portmux_capture.h"
+#include "tty_portmux_fmt.h"
+
+/* *******************************************************************
+ * defines
+ * ******************************************************************/
+#define M_TTYCAPTURE_RECORD(__ring, __idx)	((struct tty_capture_record*)((__ring)->records + ((size_t)(__idx) * M_TTYCAPTURE_RECORD_SIZE)))
+#define M_TTYCAPTURE_DATA_SIZE				(M_TTYCAPTURE_RECORD_SIZE - sizeof(struct tty_capture_record))
+
+/* *******************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ******************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Captured message, the prefix is followed by the packed arguments
+ * ****************************************************************************/
+struct tty_capture_record {
+	uint8_t streamType;
+	uint8_t reserved;
+	uint16_t prefixLen;
+	uint32_t len;			/*!< bytes of data including the prefix */
+	char data[];
+};
+
+/* ************************************************************************//**
+ * \brief	Records of a single thread, only accessed by this thread
+ * ****************************************************************************/
+struct tty_capture_ring {
+	unsigned int depth;
+	unsigned int head;		/*!< index of the next record to write */
+	unsigned int count;
+	char records[];
+};
+
+/* *******************************************************************
+ * static function declarations
+ * ******************************************************************/
+static struct tty_capture_ring* tty_portmux_capture__ring(unsigned int _depth);
+static void tty_portmux_capture__key_create(void);
+static void tty_portmux_capture__release(void *_ring);
+
+/* *******************************************************************
+ * static data
+ * ******************************************************************/
+static atomic_uint s_mask = 0;
+static atomic_uint s_depth = 0;
+static pthread_once_t s_keyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t s_key;
+static _Thread_local struct tty_capture_ring *s_ring = NULL;
+
+/* *******************************************************************
+ * function definition
+ * ******************************************************************/
+
+void tty_portmux_capture__set(unsigned int _mask, unsigned int _depth)
+{
+	atomic_store_explicit(&s_depth, _depth, memory_order_relaxed);
+	atomic_store_explicit(&s_mask, _mask, memory_order_relaxed);
+}
+
+unsigned int tty_portmux_capture__get(unsigned int *_depth)
+{
+	if (_depth != NULL) {
+		*_depth = atomic_load_explicit(&s_depth, memory_order_relaxed);
+	}
+	return atomic_load_explicit(&s_mask, memory_order_relaxed);
+}
+
+int tty_portmux_capture__enabled(enum ttyStreamType _streamType)
+{
+	return (atomic_load_explicit(&s_mask, memory_order_relaxed) & M_TTYSTREAM_BIT(_streamType)) != 0;
+}
+
+int tty_portmux_capture__vprint(enum ttyStreamType _streamType, const char *_prefix, size_t _prefixLen, const char * const _format, va_list _ap)
+{
+	struct tty_capture_ring *ring;
+	struct tty_capture_record *rec;
+	int len;
+
+	ring = tty_portmux_capture__ring(atomic_load_explicit(&s_depth, memory_order_relaxed));
+	if (ring == NULL) {
+		return -ESTD_NOMEM;
+	}
+
+	if (_prefixLen >= (M_TTYCAPTURE_DATA_SIZE / 2)) {
+		_prefixLen = 0;
+	}
+
+	rec = M_TTYCAPTURE_RECORD(ring, ring->head);
+	memcpy(rec->data, _prefix, _prefixLen);
+	len = tty_portmux_fmt__pack(rec->data + _prefixLen, M_TTYCAPTURE_DATA_SIZE - _prefixLen, _format, _ap);
+	if (len < 0) {
+		return len;
+	}
+
+	rec->streamType = (uint8_t)_streamType;
+	rec->prefixLen = (uint16_t)_prefixLen;
+	rec->len = (uint32_t)(_prefixLen + (size_t)len);
+
+	ring->head = (ring->head + 1) % ring->depth;
+	if (ring->count < ring->depth) {
+		ring->count++;
+	}
+	return EOK;
+}
+
+unsigned int tty_portmux_capture__pending(void)
+{
+	return (s_ring != NULL) ? s_ring->count : 0;
+}
+
+size_t tty_portmux_capture__next(char *_buf, size_t _size, enum ttyStreamType *_streamType)
+{
+	struct tty_capture_ring *ring = s_ring;
+	struct tty_capture_record *rec;
+	size_t len = 0;
+
+	while ((ring != NULL) && (ring->count > 0) && (len == 0)) {
+		rec = M_TTYCAPTURE_RECORD(ring, (ring->head + ring->depth - ring->count) % ring->depth);
+		ring->count--;
+
+		if (rec->prefixLen >= _size) {
+			continue;
+		}
+		memcpy(_buf, rec->data, rec->prefixLen);
+		len = tty_portmux_fmt__render(_buf + rec->prefixLen, _size - rec->prefixLen,
+				rec->data + rec->prefixLen, rec->len - rec->prefixLen);
+		if (len > 0) {
+			len += rec->prefixLen;
+			*_streamType = (enum ttyStreamType)rec->streamType;
+		}
+	}
+	return len;
+}
+
+/* *******************************************************************
+ * static function definitions
+ * ******************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Ring of the calling thread, (re)allocated on the first capture and
+ * 			after a change of the depth
+ *
+ * The pending records are moved to the new ring, if it is shallower the
+ * oldest ones are dropped like by an overwrite. The thread specific value
+ * is replaced before the previous ring is released, so the release at the
+ * thread exit never sees a freed ring.
+ * ****************************************************************************/
+static struct tty_capture_ring* tty_portmux_capture__ring(unsigned int _depth)
+{
+	struct tty_capture_ring *ring = s_ring;
+	unsigned int i, count;
+
+	if ((ring != NULL) && (ring->depth == _depth)) {
+		return ring;
+	}
+
+	if ((_depth == 0) || (_depth > M_TTYCAPTURE_DEPTH_MAX)) {
+		return NULL;
+	}
+
+	pthread_once(&s_keyOnce, &tty_portmux_capture__key_create);
+	ring = (struct tty_capture_ring*)alloc_memory(1, sizeof(struct tty_capture_ring) + ((size_t)_depth * M_TTYCAPTURE_RECORD_SIZE));
+	if (ring == NULL) {
+		return NULL;
+	}
+	ring->depth = _depth;
+
+	if (s_ring != NULL) {
+		count = (s_ring->count < _depth) ? s_ring->count : _depth;
+		for (i = 0; i < count; i++) {
+			memcpy(M_TTYCAPTURE_RECORD(ring, i),
+					M_TTYCAPTURE_RECORD(s_ring, (s_ring->head + s_ring->depth - count + i) % s_ring->depth),
+					M_TTYCAPTURE_RECORD_SIZE);
+		}
+		ring->count = count;
+		ring->head = count % _depth;
+	}
+
+	if (pthread_setspecific(s_key, ring) != 0) {
+		free_memory(ring);
+		return NULL;
+	}
+
+	if (s_ring != NULL) {
+		free_memory(s_ring);
+	}
+	s_ring = ring;
+	return ring;
+}
+
+static void tty_portmux_capture__key_create(void)
+{
+	pthread_key_create(&s_key, &tty_portmux_capture__release);
+}
+
+/* ************************************************************************//**
+ * \brief	Release of the ring at the exit of its thread
+ * ****************************************************************************/
+static void tty_portmux_capture__release(void *_ring)
+{
+	free_memory(_ring);
+}
@@ -0,0 +1,104 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal 
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _TTY_PORTMUX_CAPTURE_H_
+#define _TTY_PORTMUX_CAPTURE_H_
+
+/* *******************************************************************
+ * includes
+ * ******************************************************************/
+
+/* c runtime */
+#include <stdarg.h>
+#include <stddef.h>
+
+/* project */
+#include "lib_ttyportmux_types.h"
+
+/* *******************************************************************
+ * defines
+ * ******************************************************************/
+#define M_TTYCAPTURE_RECORD_SIZE	256		/*!< bytes per captured record including its header */
+#define M_TTYCAPTURE_DEPTH_MAX		4096	/*!< most records per thread */
+
+/* *******************************************************************
+ * function declarations
+ * ******************************************************************/
+#if defined(M_TTYPORTMUX_CAPTURE)
+
+/* ************************************************************************//**
+ * \brief	Setup of the captured streams and of the records kept per thread
+ *
+ * \param   _mask		: M_TTYSTREAM_BIT() of each captured stream
+ * \param   _depth		: records kept per thread, the oldest is overwritten
+ * ****************************************************************************/
+void tty_portmux_capture__set(unsigned int _mask, unsigned int _depth);
+unsigned int tty_portmux_capture__get(unsigned int *_depth);
+
+/* ************************************************************************//**
+ * \brief	Check if the messages of a stream are captured, a single relaxed load
+ * ****************************************************************************/
+int tty_portmux_capture__enabled(enum ttyStreamType _streamType);
+
+/* ************************************************************************//**
+ * \brief	Capture of a message into the ring of the calling thread
+ *
+ * The arguments are packed by tty_portmux_fmt__pack, the format string
+ * must have static storage duration.
+ *
+ * \param   _streamType	: stream of the message
+ * \param   _prefix		: formatted prefix of the message
+ * \param   _prefixLen	: length of the prefix, 0 if none
+ * \param   _format		: "printf" style formatted string argument
+ * \param	_ap			: variable argument list
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+int tty_portmux_capture__vprint(enum ttyStreamType _streamType, const char *_prefix, size_t _prefixLen, const char * const _format, va_list _ap);
+
+/* ************************************************************************//**
+ * \brief	Number of captured records of the calling thread
+ * ****************************************************************************/
+unsigned int tty_portmux_capture__pending(void);
+
+/* ************************************************************************//**
+ * \brief	Take of the oldest captured record of the calling thread
+ *
+ * \param   _buf [out]			: rendered record including its prefix
+ * \param   _size				: size of _buf
+ * \param   _streamType [out]	: stream of the record
+ * \return	length of the record, 0 if no record is left
+ * ****************************************************************************/
+size_t tty_portmux_capture__next(char *_buf, size_t _size, enum ttyStreamType *_streamType);
+
+#else
+
+static inline int tty_portmux_capture__enabled(enum ttyStreamType _streamType) { (void)_streamType; return 0; }
+static inline int tty_portmux_capture__vprint(enum ttyStreamType _streamType, const char *_prefix, size_t _prefixLen, const char * const _format, va_list _ap) { (void)_streamType; (void)_prefix; (void)_prefixLen; (void)_format; (void)_ap; return EOK; }
+static inline unsigned int tty_portmux_capture__pending(void) { return 0; }
+static inline size_t tty_portmux_capture__next(char *_buf, size_t _size, enum ttyStreamType *_streamType) { (void)_buf; (void)_size; (void)_streamType; return 0; }
+
+#endif /* M_TTYPORTMUX_CAPTURE */
+
+#endif /* _TTY_PORTMUX_CAPTURE_H_ */
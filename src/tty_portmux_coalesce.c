@@ -0,0 +1,227 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal 
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* *******************************************************************
+ * includes
+ * ******************************************************************/
+
+/* c -runtime */
+#include <stdatomic.h>
+#include <stdint.h>
+
+/* frame */
+#include <lib_convention__errno.h>
+
+/* project */
+#include "tty_portmux_coalesce.h"
+#include "tty_portmux_clock.h"
+
+/* *******************************************************************
+ * defines
+ * ******************************************************************/
+#define M_TTYCOALESCE_CACHE_LINE	64
+#define M_TTYCOALESCE_FNV_OFFSET	0xcbf29ce484222325ULL
+#define M_TTYCOALESCE_FNV_PRIME		0x100000001b3ULL
+
+/* *******************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ******************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Previous message of a stream, messages are compared by hash and
+ * 			length only
+ * ****************************************************************************/
+struct tty_coalesce_entry {
+	_Alignas(M_TTYCOALESCE_CACHE_LINE) atomic_flag lock;
+	uint64_t hash;
+	size_t len;
+	uint64_t repeats;		/*!< repeats of the previous message not reported yet */
+	uint64_t since;			/*!< coarse time of the first unreported repeat */
+};
+
+/* *******************************************************************
+ * static function declarations
+ * ******************************************************************/
+static uint64_t tty_portmux_coalesce__hash(const void *_format, const char *_buf, size_t _len);
+static void tty_portmux_coalesce__lock(struct tty_coalesce_entry *_entry);
+static void tty_portmux_coalesce__unlock(struct tty_coalesce_entry *_entry);
+static void tty_portmux_coalesce__arm(uint64_t _due);
+
+/* *******************************************************************
+ * static data
+ * ******************************************************************/
+static struct tty_coalesce_entry s_entries[TTYSTREAM_CNT] = {
+	[0 ... (TTYSTREAM_CNT - 1)] = { .lock = ATOMIC_FLAG_INIT }
+};
+static atomic_uint s_mask = 0;
+static atomic_ullong s_interval = 0;	/*!< ns */
+static atomic_ullong s_due = UINT64_MAX;	/*!< coarse time the first pending repeats are due, UINT64_MAX if none */
+
+/* *******************************************************************
+ * function definition
+ * ******************************************************************/
+
+unsigned int tty_portmux_coalesce__set(unsigned int _mask, unsigned int _intervalMs)
+{
+	atomic_store_explicit(&s_interval, (unsigned long long)_intervalMs * 1000000ULL, memory_order_relaxed);
+	return atomic_exchange_explicit(&s_mask, _mask, memory_order_relaxed);
+}
+
+unsigned int tty_portmux_coalesce__get(void)
+{
+	return atomic_load_explicit(&s_mask, memory_order_relaxed);
+}
+
+int tty_portmux_coalesce__enabled(enum ttyStreamType _streamType)
+{
+	return (atomic_load_explicit(&s_mask, memory_order_relaxed) & M_TTYSTREAM_BIT(_streamType)) != 0;
+}
+
+int tty_portmux_coalesce__check(enum ttyStreamType _streamType, const void *_format, const char *_buf, size_t _len, uint64_t *_repeats)
+{
+	struct tty_coalesce_entry *entry = &s_entries[_streamType];
+	uint64_t hash, now, interval;
+	int write;
+
+	hash = tty_portmux_coalesce__hash(_format, _buf, _len);
+	*_repeats = 0;
+
+	tty_portmux_coalesce__lock(entry);
+	if ((hash == entry->hash) && (_len == entry->len)) {
+		write = 0;
+		now = tty_portmux_clock__coarse_ns();
+		interval = atomic_load_explicit(&s_interval, memory_order_relaxed);
+		if (entry->repeats++ == 0) {
+			entry->since = now;
+			if (interval > 0) {
+				tty_portmux_coalesce__arm(now + interval);
+			}
+		}
+		else {
+			if ((interval > 0) && ((now - entry->since) >= interval)) {
+				*_repeats = entry->repeats;
+				entry->repeats = 0;
+			}
+		}
+	}
+	else {
+		write = 1;
+		*_repeats = entry->repeats;
+		entry->repeats = 0;
+		entry->hash = hash;
+		entry->len = _len;
+	}
+	tty_portmux_coalesce__unlock(entry);
+	return write;
+}
+
+uint64_t tty_portmux_coalesce__reset(enum ttyStreamType _streamType)
+{
+	struct tty_coalesce_entry *entry = &s_entries[_streamType];
+	uint64_t repeats;
+
+	tty_portmux_coalesce__lock(entry);
+	repeats = entry->repeats;
+	entry->repeats = 0;
+	entry->hash = 0;
+	entry->len = 0;
+	tty_portmux_coalesce__unlock(entry);
+	return repeats;
+}
+
+uint64_t tty_portmux_coalesce__expire(enum ttyStreamType _streamType, int _all)
+{
+	struct tty_coalesce_entry *entry = &s_entries[_streamType];
+	uint64_t repeats = 0, interval;
+
+	tty_portmux_coalesce__lock(entry);
+	if (entry->repeats > 0) {
+		interval = atomic_load_explicit(&s_interval, memory_order_relaxed);
+		if (_all || ((interval > 0) && ((tty_portmux_clock__coarse_ns() - entry->since) >= interval))) {
+			repeats = entry->repeats;
+			entry->repeats = 0;
+		}
+		else if (interval > 0) {
+			/* still pending, due again after its interval */
+			tty_portmux_coalesce__arm(entry->since + interval);
+		}
+	}
+	tty_portmux_coalesce__unlock(entry);
+	return repeats;
+}
+
+int tty_portmux_coalesce__take_due(void)
+{
+	unsigned long long due;
+
+	due = atomic_load_explicit(&s_due, memory_order_relaxed);
+	if ((due == UINT64_MAX) || (tty_portmux_clock__coarse_ns() < due)) {
+		return 0;
+	}
+
+	/* a single caller takes it, the streams not expired yet arm it again */
+	return atomic_compare_exchange_strong_explicit(&s_due, &due, UINT64_MAX, memory_order_relaxed, memory_order_relaxed);
+}
+
+/* *******************************************************************
+ * static function definitions
+ * ******************************************************************/
+
+/* ************************************************************************//**
+ * \brief	FNV-1a of the formatted bytes, seeded by the format pointer
+ * ****************************************************************************/
+static uint64_t tty_portmux_coalesce__hash(const void *_format, const char *_buf, size_t _len)
+{
+	uint64_t hash = M_TTYCOALESCE_FNV_OFFSET ^ (uint64_t)(uintptr_t)_format;
+	size_t i;
+
+	for (i = 0; i < _len; i++) {
+		hash ^= (unsigned char)_buf[i];
+		hash *= M_TTYCOALESCE_FNV_PRIME;
+	}
+	return hash;
+}
+
+static void tty_portmux_coalesce__lock(struct tty_coalesce_entry *_entry)
+{
+	while (atomic_flag_test_and_set_explicit(&_entry->lock, memory_order_acquire));
+}
+
+static void tty_portmux_coalesce__unlock(struct tty_coalesce_entry *_entry)
+{
+	atomic_flag_clear_explicit(&_entry->lock, memory_order_release);
+}
+
+/* ************************************************************************//**
+ * \brief	Lower the time the first pending repeats are due to _due
+ * ****************************************************************************/
+static void tty_portmux_coalesce__arm(uint64_t _due)
+{
+	unsigned long long due;
+
+	due = atomic_load_explicit(&s_due, memory_order_relaxed);
+	while ((_due < due) && !atomic_compare_exchange_weak_explicit(&s_due, &due, _due,
+			memory_order_relaxed, memory_order_relaxed));
+}
@@ -0,0 +1,114 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal 
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _TTY_PORTMUX_COALESCE_H_
+#define _TTY_PORTMUX_COALESCE_H_
+
+/* *******************************************************************
+ * includes
+ * ******************************************************************/
+
+/* c runtime */
+#include <stddef.h>
+#include <stdint.h>
+
+/* project */
+#include "lib_ttyportmux_types.h"
+
+/* *******************************************************************
+ * function declarations
+ * ******************************************************************/
+#if defined(M_TTYPORTMUX_COALESCE)
+
+/* ************************************************************************//**
+ * \brief	Setup of the streams whose repeated messages are coalesced
+ *
+ * \param   _mask		: M_TTYSTREAM_BIT() of each coalesced stream
+ * \param   _intervalMs	: during a repetition the count is reported each
+ * 						  interval, 0 reports only at a change
+ * \return	previous mask, the streams whose bit changed are expected to be
+ * 			reset by tty_portmux_coalesce__reset
+ * ****************************************************************************/
+unsigned int tty_portmux_coalesce__set(unsigned int _mask, unsigned int _intervalMs);
+unsigned int tty_portmux_coalesce__get(void);
+
+/* ************************************************************************//**
+ * \brief	Check if the messages of a stream are coalesced, a single relaxed load
+ * ****************************************************************************/
+int tty_portmux_coalesce__enabled(enum ttyStreamType _streamType);
+
+/* ************************************************************************//**
+ * \brief	Comparison of a formatted message with the previous one of the
+ * 			stream
+ *
+ * \param   _streamType		: stream of the message
+ * \param   _format			: format string of the message, NULL if not known
+ * \param   _buf			: formatted message
+ * \param   _len			: length of the message
+ * \param   _repeats [out]	: repeats of the previous message to be reported
+ * 							  now, before the message if it is written
+ * \return	non zero if the message is written, 0 if it is a repeat
+ * ****************************************************************************/
+int tty_portmux_coalesce__check(enum ttyStreamType _streamType, const void *_format, const char *_buf, size_t _len, uint64_t *_repeats);
+
+/* ************************************************************************//**
+ * \brief	Take of the pending repeats of a stream and discard of its
+ * 			previous message, the next message is always written
+ *
+ * \param   _streamType	: stream to reset
+ * \return	repeats to report
+ * ****************************************************************************/
+uint64_t tty_portmux_coalesce__reset(enum ttyStreamType _streamType);
+
+/* ************************************************************************//**
+ * \brief	Take of the pending repeats of a stream
+ *
+ * \param   _streamType	: stream to check
+ * \param   _all		: non zero takes the repeats regardless of their age
+ * \return	repeats to report, 0 if none are pending or the interval is not over
+ * ****************************************************************************/
+uint64_t tty_portmux_coalesce__expire(enum ttyStreamType _streamType, int _all);
+
+/* ************************************************************************//**
+ * \brief	Check if pending repeats of a stream are due, a single relaxed
+ * 			load while none are pending
+ *
+ * Only one of concurrent callers gets non zero, it is expected to call
+ * tty_portmux_coalesce__expire for each stream.
+ *
+ * \return	non zero if the interval of pending repeats is over
+ * ****************************************************************************/
+int tty_portmux_coalesce__take_due(void);
+
+#else
+
+static inline int tty_portmux_coalesce__enabled(enum ttyStreamType _streamType) { (void)_streamType; return 0; }
+static inline int tty_portmux_coalesce__check(enum ttyStreamType _streamType, const void *_format, const char *_buf, size_t _len, uint64_t *_repeats) { (void)_streamType; (void)_format; (void)_buf; (void)_len; *_repeats = 0; return 1; }
+static inline uint64_t tty_portmux_coalesce__expire(enum ttyStreamType _streamType, int _all) { (void)_streamType; (void)_all; return 0; }
+static inline int tty_portmux_coalesce__take_due(void) { return 0; }
+
+#endif /* M_TTYPORTMUX_COALESCE */
+
+#endif /* _TTY_PORTMUX_COALESCE_H_ */
@@ -0,0 +1,970 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal 
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* *******************************************************************
+ * includes
+ * ******************************************************************/
+
+/* c -runtime */
+#include <errno.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/* frame */
+#include <lib_convention__errno.h>
+
+/* project */
+#include "tty_portmux_fmt.h"
+
+/* *******************************************************************
+ * defines
+ * ******************************************************************/
+#define M_TTY_FMT_SPEC_MAX		32
+#define M_TTY_FMT_NULL_STR		"(null)"
+#define M_TTY_FMT_NIL_PTR		"(nil)"
+#define M_TTY_FMT_DIGITS_MAX	24
+
+/* store of a value in the record, packing stops if the record is full */
+#define M_TTY_FMT_PUT(__type, __val)								\
+	do {															\
+		__type __v = (__type)(__val);								\
+		if ((pos + sizeof(__type)) > _size) {						\
+			return (int)pos;										\
+		}															\
+		memcpy(&_rec[pos], &__v, sizeof(__type));					\
+		pos += sizeof(__type);										\
+	} while(0)
+
+/* load of a value from the record, rendering stops at the end of the record */
+#define M_TTY_FMT_GET(__type, __var)								\
+	do {															\
+		if ((recPos + sizeof(__type)) > _recLen) {					\
+			goto END;												\
+		}															\
+		memcpy(&(__var), &_rec[recPos], sizeof(__type));			\
+		recPos += sizeof(__type);									\
+	} while(0)
+
+/* formatting of a single conversion by the c-runtime, see tty_portmux_fmt__fallback */
+#define M_TTY_FMT_EMIT(__val)																		\
+	((_starCount == 0) ? snprintf(dst, avail, spec_str, __val) :									\
+	 (_starCount == 1) ? snprintf(dst, avail, spec_str, _star[0], __val) :							\
+						 snprintf(dst, avail, spec_str, _star[0], _star[1], __val))
+
+/* *******************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ******************************************************************/
+struct tty_fmt_out {
+	char *buf;
+	size_t size;			/*!< bytes of the output which may be written to buf */
+	size_t skip;			/*!< bytes of the output in front of buf, only counted */
+	size_t pos;				/*!< length of the complete output, may exceed the buffer */
+	int term;				/*!< buf has a further byte for the terminating zero */
+	int error;				/*!< a conversion of the c-runtime failed, e.g. an invalid wide character */
+};
+
+union tty_fmt_val {
+	intmax_t i;				/*!< integers and characters, sign extended from the argument type */
+	double d;
+	long double ld;
+	const void *p;
+	const char *s;
+	const wchar_t *ws;
+};
+
+/* *******************************************************************
+ * static data
+ * ******************************************************************/
+static const char s_dec2[] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+static const char s_hex2_lower[] =
+	"000102030405060708090a0b0c0d0e0f"
+	"101112131415161718191a1b1c1d1e1f"
+	"202122232425262728292a2b2c2d2e2f"
+	"303132333435363738393a3b3c3d3e3f"
+	"404142434445464748494a4b4c4d4e4f"
+	"505152535455565758595a5b5c5d5e5f"
+	"606162636465666768696a6b6c6d6e6f"
+	"707172737475767778797a7b7c7d7e7f"
+	"808182838485868788898a8b8c8d8e8f"
+	"909192939495969798999a9b9c9d9e9f"
+	"a0a1a2a3a4a5a6a7a8a9aaabacadaeaf"
+	"b0b1b2b3b4b5b6b7b8b9babbbcbdbebf"
+	"c0c1c2c3c4c5c6c7c8c9cacbcccdcecf"
+	"d0d1d2d3d4d5d6d7d8d9dadbdcdddedf"
+	"e0e1e2e3e4e5e6e7e8e9eaebecedeeef"
+	"f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff";
+
+static const char s_hex2_upper[] =
+	"000102030405060708090A0B0C0D0E0F"
+	"101112131415161718191A1B1C1D1E1F"
+	"202122232425262728292A2B2C2D2E2F"
+	"303132333435363738393A3B3C3D3E3F"
+	"404142434445464748494A4B4C4D4E4F"
+	"505152535455565758595A5B5C5D5E5F"
+	"606162636465666768696A6B6C6D6E6F"
+	"707172737475767778797A7B7C7D7E7F"
+	"808182838485868788898A8B8C8D8E8F"
+	"909192939495969798999A9B9C9D9E9F"
+	"A0A1A2A3A4A5A6A7A8A9AAABACADAEAF"
+	"B0B1B2B3B4B5B6B7B8B9BABBBCBDBEBF"
+	"C0C1C2C3C4C5C6C7C8C9CACBCCCDCECF"
+	"D0D1D2D3D4D5D6D7D8D9DADBDCDDDEDF"
+	"E0E1E2E3E4E5E6E7E8E9EAEBECEDEEEF"
+	"F0F1F2F3F4F5F6F7F8F9FAFBFCFDFEFF";
+
+/* *******************************************************************
+ * static function declarations
+ * ******************************************************************/
+static inline void tty_portmux_fmt__put(struct tty_fmt_out *_out, const char *_src, size_t _len);
+static inline void tty_portmux_fmt__fill(struct tty_fmt_out *_out, char _c, size_t _count);
+static inline size_t tty_portmux_fmt__dec(char *_end, uintmax_t _val);
+static inline size_t tty_portmux_fmt__hex(char *_end, uintmax_t _val, const char *_table);
+static void tty_portmux_fmt__pad(struct tty_fmt_out *_out, unsigned int _flags, int _width, const char *_src, size_t _len);
+static void tty_portmux_fmt__int(struct tty_fmt_out *_out, unsigned int _flags, int _width, int _prec, char _conv, uintmax_t _mag, int _neg);
+static void tty_portmux_fmt__emit(struct tty_fmt_out *_out, const struct tty_fmt_spec *_spec, const int *_star, int _starCount, const union tty_fmt_val *_val);
+static void tty_portmux_fmt__fallback(struct tty_fmt_out *_out, const struct tty_fmt_spec *_spec, const int *_star, int _starCount, const union tty_fmt_val *_val);
+static int tty_portmux_fmt__vwindow(struct tty_fmt_out *_out, const char *_format, va_list _ap);
+
+/* *******************************************************************
+ * function definition
+ * ******************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Parse of the conversion specification at _fmt
+ *
+ * \param	_fmt		: points to the '%' of the specification
+ * \param	_spec [out]	: parsed specification
+ * \return	pointer behind the specification
+ * ****************************************************************************/
+const char* tty_portmux_fmt__parse(const char *_fmt, struct tty_fmt_spec *_spec)
+{
+	const char *p = _fmt + 1;
+	char length = 0;
+	int wide = 0;
+
+	_spec->begin = _fmt;
+	_spec->flags = 0;
+	_spec->starWidth = 0;
+	_spec->starPrec = 0;
+	_spec->width = -1;
+	_spec->prec = -1;
+
+	for (;; p++) {
+		switch (*p) {
+			case '-': _spec->flags |= M_TTY_FMT_FLAG_MINUS; continue;
+			case '+': _spec->flags |= M_TTY_FMT_FLAG_PLUS; continue;
+			case ' ': _spec->flags |= M_TTY_FMT_FLAG_SPACE; continue;
+			case '#': _spec->flags |= M_TTY_FMT_FLAG_HASH; continue;
+			case '0': _spec->flags |= M_TTY_FMT_FLAG_ZERO; continue;
+			case '\'': continue;
+			default: break;
+		}
+		break;
+	}
+
+	if (*p == '*') {
+		_spec->starWidth = 1;
+		p++;
+	}
+	else if ((*p >= '0') && (*p <= '9')) {
+		_spec->width = 0;
+		while ((*p >= '0') && (*p <= '9')) {
+			_spec->width = (_spec->width * 10) + (*p - '0');
+			p++;
+		}
+	}
+
+	if (*p == '.') {
+		p++;
+		if (*p == '*') {
+			_spec->starPrec = 1;
+			p++;
+		}
+		else {
+			_spec->prec = 0;
+			while ((*p >= '0') && (*p <= '9')) {
+				_spec->prec = (_spec->prec * 10) + (*p - '0');
+				p++;
+			}
+		}
+	}
+
+	switch (*p) {
+		case 'h':
+			if (p[1] == 'h') {
+				length = 'H';
+				p += 2;
+			}
+			else {
+				length = 'h';
+				p++;
+			}
+			break;
+		case 'l':
+			wide = 1;
+			if (p[1] == 'l') {
+				length = 'q';
+				p += 2;
+			}
+			else {
+				length = 'l';
+				p++;
+			}
+			break;
+		case 'q': case 'j': case 'z': case 't': case 'L':
+			length = *p;
+			p++;
+			break;
+		default:
+			break;
+	}
+
+	_spec->length = length;
+	_spec->conv = *p;
+	if (*p != '\0') {
+		p++;
+	}
+	_spec->len = (size_t)(p - _fmt);
+
+	switch (_spec->conv)
+	{
+		case 'd': case 'i': case 'o': case 'u': case 'x': case 'X':
+			switch (length) {
+				case 'l': _spec->arg = TTY_FMT_ARG_long; break;
+				case 'q': _spec->arg = TTY_FMT_ARG_llong; break;
+				case 'j': _spec->arg = TTY_FMT_ARG_intmax; break;
+				case 'z': _spec->arg = TTY_FMT_ARG_size; break;
+				case 't': _spec->arg = TTY_FMT_ARG_ptrdiff; break;
+				default: _spec->arg = TTY_FMT_ARG_int; break;
+			}
+			break;
+		case 'c': case 'C':
+			_spec->arg = TTY_FMT_ARG_int;
+			break;
+		case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+			_spec->arg = (length == 'L') ? TTY_FMT_ARG_ldouble : TTY_FMT_ARG_double;
+			break;
+		case 's':
+			_spec->arg = wide ? TTY_FMT_ARG_wstr : TTY_FMT_ARG_str;
+			break;
+		case 'S':
+			_spec->arg = TTY_FMT_ARG_wstr;
+			break;
+		case 'm':
+			_spec->arg = TTY_FMT_ARG_errno;
+			break;
+		case 'p':
+			_spec->arg = TTY_FMT_ARG_ptr;
+			break;
+		case 'n':
+			_spec->arg = TTY_FMT_ARG_count;
+			break;
+		case '%':
+			_spec->arg = TTY_FMT_ARG_none;
+			break;
+		default:
+			_spec->arg = TTY_FMT_ARG_invalid;
+			break;
+	}
+	return p;
+}
+
+/* ************************************************************************//**
+ * \brief	Formatting of a message, a replacement of vsnprintf
+ *
+ * \param	_buf [out]	: output buffer, zero terminated if _size is not 0
+ * \param	_size		: size of the output buffer
+ * \param	_format		: "printf" style formatted string argument
+ * \param	_ap			: variable argument list
+ * \return	length of the complete message, or negative errno value on error
+ * ****************************************************************************/
+int tty_portmux_fmt__vformat(char *_buf, size_t _size, const char *_format, va_list _ap)
+{
+	struct tty_fmt_out out = { .buf = (_size > 0) ? _buf : NULL, .size = (_size > 0) ? (_size - 1) : 0, .skip = 0, .pos = 0, .term = 1, .error = 0 };
+	int ret;
+
+	if (_format == NULL) {
+		return -EPAR_NULL;
+	}
+
+	if ((_buf == NULL) && (_size > 0)) {
+		return -EPAR_NULL;
+	}
+
+	ret = tty_portmux_fmt__vwindow(&out, _format, _ap);
+	if (_size > 0) {
+		_buf[(out.pos < _size) ? out.pos : (_size - 1)] = '\0';
+	}
+	return ret;
+}
+
+/* ************************************************************************//**
+ * \brief	Formatting of a window of a message
+ *
+ * \param	_buf [out]	: output buffer, not zero terminated
+ * \param	_size		: size of the output buffer
+ * \param	_offset		: offset of the window in the message
+ * \param	_format		: "printf" style formatted string argument
+ * \param	_ap			: variable argument list
+ * \return	length of the complete message, or negative errno value on error
+ * ****************************************************************************/
+int tty_portmux_fmt__vformat_at(char *_buf, size_t _size, size_t _offset, const char *_format, va_list _ap)
+{
+	struct tty_fmt_out out = { .buf = _buf, .size = _size, .skip = _offset, .pos = 0, .term = 0, .error = 0 };
+
+	if ((_format == NULL) || ((_buf == NULL) && (_size > 0))) {
+		return -EPAR_NULL;
+	}
+
+	return tty_portmux_fmt__vwindow(&out, _format, _ap);
+}
+
+int tty_portmux_fmt__format(char *_buf, size_t _size, const char *_format, ...)
+{
+	va_list ap;
+	int ret;
+
+	va_start(ap, _format);
+	ret = tty_portmux_fmt__vformat(_buf, _size, _format, ap);
+	va_end(ap);
+	return ret;
+}
+
+/* ************************************************************************//**
+ * \brief	Capture of the format pointer and the raw argument values
+ *
+ * \param	_rec [out]	: record buffer
+ * \param	_size		: size of the record buffer
+ * \param	_format		: "printf" style formatted string argument
+ * \param	_ap			: variable argument list
+ * \return	length of the record, or negative errno value on error
+ * ****************************************************************************/
+int tty_portmux_fmt__pack(char *_rec, size_t _size, const char *_format, va_list _ap)
+{
+	struct tty_fmt_spec spec;
+	const char *p = _format;
+	const char *str;
+	const wchar_t *wstr;
+	size_t pos = 0, strLen, strMax;
+	int prec, n, errnum = errno;
+
+	if ((_rec == NULL) || (_format == NULL)) {
+		return -EPAR_NULL;
+	}
+
+	if (_size < sizeof(const char*)) {
+		return -ESTD_NOSPC;
+	}
+
+	M_TTY_FMT_PUT(const char*, _format);
+
+	while (*p != '\0') {
+		if (*p != '%') {
+			p++;
+			continue;
+		}
+
+		p = tty_portmux_fmt__parse(p, &spec);
+		if (spec.arg == TTY_FMT_ARG_invalid) {
+			break;
+		}
+
+		if (spec.starWidth) {
+			M_TTY_FMT_PUT(int, va_arg(_ap, int));
+		}
+
+		prec = spec.prec;
+		if (spec.starPrec) {
+			prec = va_arg(_ap, int);
+			M_TTY_FMT_PUT(int, prec);
+		}
+
+		switch (spec.arg)
+		{
+			case TTY_FMT_ARG_int: M_TTY_FMT_PUT(int, va_arg(_ap, int)); break;
+			case TTY_FMT_ARG_long: M_TTY_FMT_PUT(long, va_arg(_ap, long)); break;
+			case TTY_FMT_ARG_llong: M_TTY_FMT_PUT(long long, va_arg(_ap, long long)); break;
+			case TTY_FMT_ARG_intmax: M_TTY_FMT_PUT(intmax_t, va_arg(_ap, intmax_t)); break;
+			case TTY_FMT_ARG_size: M_TTY_FMT_PUT(size_t, va_arg(_ap, size_t)); break;
+			case TTY_FMT_ARG_ptrdiff: M_TTY_FMT_PUT(ptrdiff_t, va_arg(_ap, ptrdiff_t)); break;
+			case TTY_FMT_ARG_double: M_TTY_FMT_PUT(double, va_arg(_ap, double)); break;
+			case TTY_FMT_ARG_ldouble: M_TTY_FMT_PUT(long double, va_arg(_ap, long double)); break;
+			case TTY_FMT_ARG_ptr: M_TTY_FMT_PUT(void*, va_arg(_ap, void*)); break;
+			case TTY_FMT_ARG_count: (void)va_arg(_ap, void*); break;
+			case TTY_FMT_ARG_wstr:
+				/* converted with the precision, rendered as a string without */
+				wstr = va_arg(_ap, const wchar_t*);
+				if ((pos + sizeof(uint32_t) + 1) > _size) {
+					return (int)pos;
+				}
+				strMax = _size - pos - sizeof(uint32_t) - 1;
+				n = snprintf(&_rec[pos + sizeof(uint32_t)], strMax + 1, "%.*ls", (prec < 0) ? INT_MAX : prec, wstr);
+				strLen = (n < 0) ? 0 : ((size_t)n < strMax) ? (size_t)n : strMax;
+				M_TTY_FMT_PUT(uint32_t, strLen);
+				_rec[pos + strLen] = '\0';
+				pos += strLen + 1;
+				break;
+			case TTY_FMT_ARG_str:
+			case TTY_FMT_ARG_errno:
+				str = (spec.arg == TTY_FMT_ARG_str) ? va_arg(_ap, const char*) : strerror(errnum);
+				if (str == NULL) {
+					str = ((prec < 0) || (prec >= (int)(sizeof(M_TTY_FMT_NULL_STR) - 1))) ? M_TTY_FMT_NULL_STR : "";
+				}
+				if ((pos + sizeof(uint32_t) + 1) > _size) {
+					return (int)pos;
+				}
+				strMax = _size - pos - sizeof(uint32_t) - 1;
+				if ((prec >= 0) && ((size_t)prec < strMax)) {
+					strMax = (size_t)prec;
+				}
+				strLen = strnlen(str, strMax);
+				M_TTY_FMT_PUT(uint32_t, strLen);
+				memcpy(&_rec[pos], str, strLen);
+				_rec[pos + strLen] = '\0';
+				pos += strLen + 1;
+				break;
+			default:
+				break;
+		}
+	}
+	return (int)pos;
+}
+
+/* ************************************************************************//**
+ * \brief	Rendering of a record captured by tty_portmux_fmt__pack
+ *
+ * \param	_buf [out]	: output buffer, always zero terminated
+ * \param	_size		: size of the output buffer
+ * \param	_rec		: record
+ * \param	_recLen		: length of the record
+ * \return	number of characters written to _buf
+ * ****************************************************************************/
+size_t tty_portmux_fmt__render(char *_buf, size_t _size, const char *_rec, size_t _recLen)
+{
+	struct tty_fmt_out out = { .buf = _buf, .size = (_size > 0) ? (_size - 1) : 0, .skip = 0, .pos = 0, .term = 1, .error = 0 };
+	struct tty_fmt_spec spec;
+	union tty_fmt_val val;
+	const char *format, *p, *lit;
+	size_t recPos = 0;
+	int star[2], starCount;
+	uint32_t strLen;
+
+	if ((_buf == NULL) || (_size == 0)) {
+		return 0;
+	}
+
+	M_TTY_FMT_GET(const char*, format);
+	p = format;
+
+	while ((*p != '\0') && (out.pos < (_size - 1))) {
+		lit = p;
+		while ((*p != '\0') && (*p != '%')) {
+			p++;
+		}
+		tty_portmux_fmt__put(&out, lit, (size_t)(p - lit));
+		if (*p == '\0') {
+			break;
+		}
+
+		p = tty_portmux_fmt__parse(p, &spec);
+		if (spec.arg == TTY_FMT_ARG_invalid) {
+			break;
+		}
+
+		starCount = 0;
+		if (spec.starWidth) {
+			M_TTY_FMT_GET(int, star[starCount]);
+			starCount++;
+		}
+		if (spec.starPrec) {
+			M_TTY_FMT_GET(int, star[starCount]);
+			starCount++;
+		}
+
+		switch (spec.arg)
+		{
+			case TTY_FMT_ARG_int: { int v; M_TTY_FMT_GET(int, v); val.i = v; break; }
+			case TTY_FMT_ARG_long: { long v; M_TTY_FMT_GET(long, v); val.i = v; break; }
+			case TTY_FMT_ARG_llong: { long long v; M_TTY_FMT_GET(long long, v); val.i = v; break; }
+			case TTY_FMT_ARG_intmax: M_TTY_FMT_GET(intmax_t, val.i); break;
+			case TTY_FMT_ARG_size: { size_t v; M_TTY_FMT_GET(size_t, v); val.i = (intmax_t)v; break; }
+			case TTY_FMT_ARG_ptrdiff: { ptrdiff_t v; M_TTY_FMT_GET(ptrdiff_t, v); val.i = v; break; }
+			case TTY_FMT_ARG_double: M_TTY_FMT_GET(double, val.d); break;
+			case TTY_FMT_ARG_ldouble: M_TTY_FMT_GET(long double, val.ld); break;
+			case TTY_FMT_ARG_ptr: M_TTY_FMT_GET(void*, val.p); break;
+			case TTY_FMT_ARG_str:
+			case TTY_FMT_ARG_wstr:
+			case TTY_FMT_ARG_errno:
+				M_TTY_FMT_GET(uint32_t, strLen);
+				if ((recPos + strLen + 1) > _recLen) {
+					goto END;
+				}
+				val.s = &_rec[recPos];
+				recPos += strLen + 1;
+				if (spec.arg == TTY_FMT_ARG_wstr) {
+					/* converted and cut to the precision by tty_portmux_fmt__pack */
+					spec.arg = TTY_FMT_ARG_str;
+					spec.conv = 's';
+					spec.length = 0;
+					spec.prec = -1;
+					spec.starPrec = 0;
+				}
+				break;
+			case TTY_FMT_ARG_count:
+				continue;
+			default:
+				break;
+		}
+		tty_portmux_fmt__emit(&out, &spec, star, starCount, &val);
+	}
+
+	END:
+	if (out.pos >= _size) {
+		out.pos = _size - 1;
+	}
+	_buf[out.pos] = '\0';
+	return out.pos;
+}
+
+/* *******************************************************************
+ * static function definitions
+ * ******************************************************************/
+
+static inline void tty_portmux_fmt__put(struct tty_fmt_out *_out, const char *_src, size_t _len)
+{
+	size_t from = 0, at, avail;
+
+	/* bytes in front of the window are only counted */
+	if (_out->pos < _out->skip) {
+		from = _out->skip - _out->pos;
+		if (from >= _len) {
+			_out->pos += _len;
+			return;
+		}
+	}
+
+	at = _out->pos + from - _out->skip;
+	if (at < _out->size) {
+		avail = _out->size - at;
+		memcpy(&_out->buf[at], _src + from, ((_len - from) < avail) ? (_len - from) : avail);
+	}
+	_out->pos += _len;
+}
+
+static inline void tty_portmux_fmt__fill(struct tty_fmt_out *_out, char _c, size_t _count)
+{
+	size_t from = 0, at, avail;
+
+	if (_out->pos < _out->skip) {
+		from = _out->skip - _out->pos;
+		if (from >= _count) {
+			_out->pos += _count;
+			return;
+		}
+	}
+
+	at = _out->pos + from - _out->skip;
+	if (at < _out->size) {
+		avail = _out->size - at;
+		memset(&_out->buf[at], _c, ((_count - from) < avail) ? (_count - from) : avail);
+	}
+	_out->pos += _count;
+}
+
+/* digits are written backwards, ending in front of _end */
+static inline size_t tty_portmux_fmt__dec(char *_end, uintmax_t _val)
+{
+	char *p = _end;
+
+	while (_val >= 100) {
+		p -= 2;
+		memcpy(p, &s_dec2[(_val % 100) * 2], 2);
+		_val /= 100;
+	}
+	if (_val >= 10) {
+		p -= 2;
+		memcpy(p, &s_dec2[_val * 2], 2);
+	}
+	else {
+		*--p = (char)('0' + _val);
+	}
+	return (size_t)(_end - p);
+}
+
+static inline size_t tty_portmux_fmt__hex(char *_end, uintmax_t _val, const char *_table)
+{
+	char *p = _end;
+
+	while (_val > 0xff) {
+		p -= 2;
+		memcpy(p, &_table[(_val & 0xff) * 2], 2);
+		_val >>= 8;
+	}
+	if (_val > 0xf) {
+		p -= 2;
+		memcpy(p, &_table[_val * 2], 2);
+	}
+	else {
+		*--p = _table[(_val * 2) + 1];
+	}
+	return (size_t)(_end - p);
+}
+
+static void tty_portmux_fmt__pad(struct tty_fmt_out *_out, unsigned int _flags, int _width, const char *_src, size_t _len)
+{
+	size_t pad = ((_width > 0) && ((size_t)_width > _len)) ? ((size_t)_width - _len) : 0;
+
+	if (_flags & M_TTY_FMT_FLAG_MINUS) {
+		tty_portmux_fmt__put(_out, _src, _len);
+		tty_portmux_fmt__fill(_out, ' ', pad);
+	}
+	else {
+		tty_portmux_fmt__fill(_out, ' ', pad);
+		tty_portmux_fmt__put(_out, _src, _len);
+	}
+}
+
+static void tty_portmux_fmt__int(struct tty_fmt_out *_out, unsigned int _flags, int _width, int _prec, char _conv, uintmax_t _mag, int _neg)
+{
+	char digits[M_TTY_FMT_DIGITS_MAX];
+	char *end = &digits[sizeof(digits)];
+	char prefix[2];
+	size_t count = 0, prefixLen = 0, zeros = 0, pad = 0, total;
+
+	if ((_prec != 0) || (_mag != 0)) {
+		switch (_conv) {
+			case 'x': count = tty_portmux_fmt__hex(end, _mag, s_hex2_lower); break;
+			case 'X': count = tty_portmux_fmt__hex(end, _mag, s_hex2_upper); break;
+			default: count = tty_portmux_fmt__dec(end, _mag); break;
+		}
+	}
+
+	if (_neg) {
+		prefix[prefixLen++] = '-';
+	}
+	else if (_conv == 'd') {
+		if (_flags & M_TTY_FMT_FLAG_PLUS) {
+			prefix[prefixLen++] = '+';
+		}
+		else if (_flags & M_TTY_FMT_FLAG_SPACE) {
+			prefix[prefixLen++] = ' ';
+		}
+	}
+	else if ((_flags & M_TTY_FMT_FLAG_HASH) && (_conv != 'u') && (_mag != 0)) {
+		prefix[prefixLen++] = '0';
+		prefix[prefixLen++] = _conv;
+	}
+
+	if ((_prec > 0) && ((size_t)_prec > count)) {
+		zeros = (size_t)_prec - count;
+	}
+
+	total = prefixLen + zeros + count;
+	if ((_width > 0) && ((size_t)_width > total)) {
+		pad = (size_t)_width - total;
+	}
+
+	if (_flags & M_TTY_FMT_FLAG_MINUS) {
+		tty_portmux_fmt__put(_out, prefix, prefixLen);
+		tty_portmux_fmt__fill(_out, '0', zeros);
+		tty_portmux_fmt__put(_out, end - count, count);
+		tty_portmux_fmt__fill(_out, ' ', pad);
+	}
+	else if ((_flags & M_TTY_FMT_FLAG_ZERO) && (_prec < 0)) {
+		tty_portmux_fmt__put(_out, prefix, prefixLen);
+		tty_portmux_fmt__fill(_out, '0', pad);
+		tty_portmux_fmt__put(_out, end - count, count);
+	}
+	else {
+		tty_portmux_fmt__fill(_out, ' ', pad);
+		tty_portmux_fmt__put(_out, prefix, prefixLen);
+		tty_portmux_fmt__fill(_out, '0', zeros);
+		tty_portmux_fmt__put(_out, end - count, count);
+	}
+}
+
+static void tty_portmux_fmt__emit(struct tty_fmt_out *_out, const struct tty_fmt_spec *_spec, const int *_star, int _starCount, const union tty_fmt_val *_val)
+{
+	char digits[M_TTY_FMT_DIGITS_MAX];
+	unsigned int flags = _spec->flags;
+	int width = _spec->width, prec = _spec->prec, i = 0;
+	uintmax_t mag;
+	intmax_t v;
+	size_t count;
+	char c;
+
+	if (_spec->starWidth) {
+		width = _star[i++];
+		if (width < 0) {
+			flags |= M_TTY_FMT_FLAG_MINUS;
+			width = -width;
+		}
+	}
+	if (_spec->starPrec) {
+		prec = (_star[i] < 0) ? -1 : _star[i];
+	}
+
+	switch (_spec->conv)
+	{
+		case 'd': case 'i':
+			v = _val->i;
+			if (_spec->arg == TTY_FMT_ARG_int) {
+				v = (_spec->length == 'H') ? (signed char)v : (_spec->length == 'h') ? (short)v : (int)v;
+			}
+			mag = (v < 0) ? (uintmax_t)0 - (uintmax_t)v : (uintmax_t)v;
+			tty_portmux_fmt__int(_out, flags, width, prec, 'd', mag, (v < 0));
+			return;
+		case 'u': case 'x': case 'X':
+			switch (_spec->arg) {
+				case TTY_FMT_ARG_int:
+					mag = (_spec->length == 'H') ? (unsigned char)_val->i :
+						  (_spec->length == 'h') ? (unsigned short)_val->i : (unsigned int)_val->i;
+					break;
+				case TTY_FMT_ARG_long: mag = (unsigned long)_val->i; break;
+				case TTY_FMT_ARG_llong: mag = (unsigned long long)_val->i; break;
+				case TTY_FMT_ARG_size: case TTY_FMT_ARG_ptrdiff: mag = (size_t)_val->i; break;
+				default: mag = (uintmax_t)_val->i; break;
+			}
+			tty_portmux_fmt__int(_out, flags, width, prec, _spec->conv, mag, 0);
+			return;
+		case 'c':
+			if (_spec->length == 'l') {
+				break;
+			}
+			c = (char)_val->i;
+			tty_portmux_fmt__pad(_out, flags, width, &c, 1);
+			return;
+		case 's': case 'm':
+			if (_spec->arg == TTY_FMT_ARG_wstr) {
+				break;
+			}
+			if (_val->s == NULL) {
+				count = ((prec < 0) || (prec >= (int)(sizeof(M_TTY_FMT_NULL_STR) - 1))) ? (sizeof(M_TTY_FMT_NULL_STR) - 1) : 0;
+				tty_portmux_fmt__pad(_out, flags, width, M_TTY_FMT_NULL_STR, count);
+			}
+			else {
+				count = (prec < 0) ? strlen(_val->s) : strnlen(_val->s, (size_t)prec);
+				tty_portmux_fmt__pad(_out, flags, width, _val->s, count);
+			}
+			return;
+		case 'p':
+			if (((flags & ~M_TTY_FMT_FLAG_MINUS) != 0) || (prec >= 0)) {
+				break;
+			}
+			if (_val->p == NULL) {
+				tty_portmux_fmt__pad(_out, flags, width, M_TTY_FMT_NIL_PTR, sizeof(M_TTY_FMT_NIL_PTR) - 1);
+			}
+			else {
+				count = tty_portmux_fmt__hex(&digits[sizeof(digits)], (uintptr_t)_val->p, s_hex2_lower);
+				digits[sizeof(digits) - count - 2] = '0';
+				digits[sizeof(digits) - count - 1] = 'x';
+				tty_portmux_fmt__pad(_out, flags, width, &digits[sizeof(digits) - count - 2], count + 2);
+			}
+			return;
+		case '%':
+			tty_portmux_fmt__put(_out, "%", 1);
+			return;
+		default:
+			break;
+	}
+	tty_portmux_fmt__fallback(_out, _spec, _star, _starCount, _val);
+}
+
+/* ************************************************************************//**
+ * \brief	Formatting of the window _out of a message
+ * ****************************************************************************/
+static int tty_portmux_fmt__vwindow(struct tty_fmt_out *_out, const char *_format, va_list _ap)
+{
+	struct tty_fmt_spec spec;
+	union tty_fmt_val val;
+	char digits[M_TTY_FMT_DIGITS_MAX];
+	const char *p = _format, *lit, *str;
+	int star[2], starCount, v, errnum = errno;
+	size_t count;
+	va_list ap;
+
+	/* arguments from the start, if a conversion of unknown type is found */
+	va_copy(ap, _ap);
+
+	while (*p != '\0') {
+		lit = p;
+		p = strchr(lit, '%');
+		if (p == NULL) {
+			tty_portmux_fmt__put(_out, lit, strlen(lit));
+			break;
+		}
+		tty_portmux_fmt__put(_out, lit, (size_t)(p - lit));
+
+		/* fast path of the conversions without flags, width and precision */
+		switch (p[1])
+		{
+			case 's':
+				str = va_arg(_ap, const char*);
+				if (str == NULL) {
+					str = M_TTY_FMT_NULL_STR;
+				}
+				tty_portmux_fmt__put(_out, str, strlen(str));
+				p += 2;
+				continue;
+			case 'd':
+				v = va_arg(_ap, int);
+				count = tty_portmux_fmt__dec(&digits[sizeof(digits)], (v < 0) ? 0U - (unsigned int)v : (unsigned int)v);
+				if (v < 0) {
+					digits[sizeof(digits) - (++count)] = '-';
+				}
+				tty_portmux_fmt__put(_out, &digits[sizeof(digits) - count], count);
+				p += 2;
+				continue;
+			case 'u':
+				count = tty_portmux_fmt__dec(&digits[sizeof(digits)], va_arg(_ap, unsigned int));
+				tty_portmux_fmt__put(_out, &digits[sizeof(digits) - count], count);
+				p += 2;
+				continue;
+			case 'x':
+				count = tty_portmux_fmt__hex(&digits[sizeof(digits)], va_arg(_ap, unsigned int), s_hex2_lower);
+				tty_portmux_fmt__put(_out, &digits[sizeof(digits) - count], count);
+				p += 2;
+				continue;
+			default:
+				break;
+		}
+
+		p = tty_portmux_fmt__parse(p, &spec);
+		if (spec.arg == TTY_FMT_ARG_invalid) {
+			/* the c-runtime formats the message as a whole, not a window of it */
+			v = -ESTD_NOSYS;
+			if ((_out->skip == 0) && _out->term) {
+				errno = errnum;
+				v = vsnprintf(_out->buf, (_out->buf != NULL) ? (_out->size + 1) : 0, _format, ap);
+				if (v >= 0) {
+					_out->pos = (size_t)v;
+				}
+			}
+			va_end(ap);
+			return (v < 0) ? ((v == -ESTD_NOSYS) ? v : -ESTD_INVAL) : v;
+		}
+
+		starCount = 0;
+		if (spec.starWidth) {
+			star[starCount++] = va_arg(_ap, int);
+		}
+		if (spec.starPrec) {
+			star[starCount++] = va_arg(_ap, int);
+		}
+
+		switch (spec.arg)
+		{
+			case TTY_FMT_ARG_int: val.i = va_arg(_ap, int); break;
+			case TTY_FMT_ARG_long: val.i = va_arg(_ap, long); break;
+			case TTY_FMT_ARG_llong: val.i = va_arg(_ap, long long); break;
+			case TTY_FMT_ARG_intmax: val.i = va_arg(_ap, intmax_t); break;
+			case TTY_FMT_ARG_size: val.i = (intmax_t)va_arg(_ap, size_t); break;
+			case TTY_FMT_ARG_ptrdiff: val.i = va_arg(_ap, ptrdiff_t); break;
+			case TTY_FMT_ARG_double: val.d = va_arg(_ap, double); break;
+			case TTY_FMT_ARG_ldouble: val.ld = va_arg(_ap, long double); break;
+			case TTY_FMT_ARG_ptr: val.p = va_arg(_ap, void*); break;
+			case TTY_FMT_ARG_str: val.s = va_arg(_ap, const char*); break;
+			case TTY_FMT_ARG_wstr: val.ws = va_arg(_ap, const wchar_t*); break;
+			case TTY_FMT_ARG_errno: val.s = strerror(errnum); break;
+			case TTY_FMT_ARG_count: (void)va_arg(_ap, void*); continue;
+			default: break;
+		}
+		tty_portmux_fmt__emit(_out, &spec, star, starCount, &val);
+	}
+	va_end(ap);
+
+	if (_out->error || (_out->pos > INT_MAX)) {
+		return -ESTD_INVAL;
+	}
+	return (int)_out->pos;
+}
+
+/* conversions without fast path, e.g. octal, floating point and wide characters */
+static void tty_portmux_fmt__fallback(struct tty_fmt_out *_out, const struct tty_fmt_spec *_spec, const int *_star, int _starCount, const union tty_fmt_val *_val)
+{
+	char spec_str[M_TTY_FMT_SPEC_MAX];
+	char conv[M_TTY_FMT_CONV_MAX];
+	char *dst = NULL;
+	size_t avail = 0;
+	int n, direct;
+
+	if (_spec->len >= sizeof(spec_str)) {
+		return;
+	}
+	memcpy(spec_str, _spec->begin, _spec->len);
+	spec_str[_spec->len] = '\0';
+
+	/* snprintf writes its terminating zero behind the conversion, a window
+	 * without a byte for it gets the conversion through a copy */
+	direct = (_out->skip == 0) && _out->term;
+	if (!direct) {
+		dst = &conv[0];
+		avail = sizeof(conv);
+	}
+	else if ((_out->buf != NULL) && (_out->pos <= _out->size)) {
+		dst = &_out->buf[_out->pos];
+		avail = _out->size - _out->pos + 1;
+	}
+
+	switch (_spec->arg)
+	{
+		case TTY_FMT_ARG_int: n = M_TTY_FMT_EMIT((int)_val->i); break;
+		case TTY_FMT_ARG_long: n = M_TTY_FMT_EMIT((long)_val->i); break;
+		case TTY_FMT_ARG_llong: n = M_TTY_FMT_EMIT((long long)_val->i); break;
+		case TTY_FMT_ARG_intmax: n = M_TTY_FMT_EMIT(_val->i); break;
+		case TTY_FMT_ARG_size: n = M_TTY_FMT_EMIT((size_t)_val->i); break;
+		case TTY_FMT_ARG_ptrdiff: n = M_TTY_FMT_EMIT((ptrdiff_t)_val->i); break;
+		case TTY_FMT_ARG_double: n = M_TTY_FMT_EMIT(_val->d); break;
+		case TTY_FMT_ARG_ldouble: n = M_TTY_FMT_EMIT(_val->ld); break;
+		case TTY_FMT_ARG_ptr: n = M_TTY_FMT_EMIT(_val->p); break;
+		case TTY_FMT_ARG_str: n = M_TTY_FMT_EMIT(_val->s); break;
+		case TTY_FMT_ARG_wstr: n = M_TTY_FMT_EMIT(_val->ws); break;
+		default: n = 0; break;
+	}
+
+	if ((n < 0) || (!direct && ((size_t)n >= avail))) {
+		_out->error = 1;
+	}
+	else if (!direct) {
+		tty_portmux_fmt__put(_out, &conv[0], (size_t)n);
+	}
+	else {
+		_out->pos += (size_t)n;
+	}
+}
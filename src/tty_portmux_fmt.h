@@ -0,0 +1,167 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal 
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _TTY_PORTMUX_FMT_H_
+#define _TTY_PORTMUX_FMT_H_
+
+/* *******************************************************************
+ * includes
+ * ******************************************************************/
+
+/* c runtime */
+#include <stdarg.h>
+#include <stddef.h>
+
+/* *******************************************************************
+ * defines
+ * ******************************************************************/
+#define M_TTY_FMT_FLAG_MINUS	0x01
+#define M_TTY_FMT_FLAG_PLUS		0x02
+#define M_TTY_FMT_FLAG_SPACE	0x04
+#define M_TTY_FMT_FLAG_HASH		0x08
+#define M_TTY_FMT_FLAG_ZERO		0x10
+
+#define M_TTY_FMT_CONV_MAX		256		/*!< longest conversion of the c-runtime in a window, see tty_portmux_fmt__vformat_at */
+
+/* *******************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ******************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Type of the argument consumed by a conversion specification
+ * ****************************************************************************/
+enum tty_fmt_arg {
+	TTY_FMT_ARG_none,		/*!< "%%", no argument */
+	TTY_FMT_ARG_int,
+	TTY_FMT_ARG_long,
+	TTY_FMT_ARG_llong,
+	TTY_FMT_ARG_intmax,
+	TTY_FMT_ARG_size,
+	TTY_FMT_ARG_ptrdiff,
+	TTY_FMT_ARG_double,
+	TTY_FMT_ARG_ldouble,
+	TTY_FMT_ARG_ptr,
+	TTY_FMT_ARG_str,
+	TTY_FMT_ARG_wstr,		/*!< "%ls", wide string, converted by the c-runtime */
+	TTY_FMT_ARG_errno,		/*!< "%m", no argument, strerror(errno) */
+	TTY_FMT_ARG_count,		/*!< "%n", pointer argument, never written */
+	TTY_FMT_ARG_invalid		/*!< unknown conversion, the argument type is not known */
+};
+
+/* ************************************************************************//**
+ * \brief	Conversion specification "%[flags][width][.precision][length]conv"
+ * ****************************************************************************/
+struct tty_fmt_spec {
+	const char *begin;			/*!< points to the '%' */
+	size_t len;					/*!< length including the conversion character */
+	enum tty_fmt_arg arg;
+	char conv;
+	char length;				/*!< 'H' hh, 'h', 'l', 'q' ll, 'j', 'z', 't', 'L', 0 if none */
+	unsigned char flags;		/*!< M_TTY_FMT_FLAG_* */
+	unsigned char starWidth;	/*!< width is passed as int argument */
+	unsigned char starPrec;		/*!< precision is passed as int argument */
+	int width;					/*!< literal width, -1 if not given or passed as argument */
+	int prec;					/*!< literal precision, -1 if not given or passed as argument */
+};
+
+/* *******************************************************************
+ * function declarations
+ * ******************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Parse of the conversion specification at _fmt
+ *
+ * \param	_fmt		: points to the '%' of the specification
+ * \param	_spec [out]	: parsed specification
+ * \return	pointer behind the specification
+ * ****************************************************************************/
+const char* tty_portmux_fmt__parse(const char *_fmt, struct tty_fmt_spec *_spec);
+
+/* ************************************************************************//**
+ * \brief	Formatting of a message, a replacement of vsnprintf
+ *
+ * Integers in decimal and hexadecimal, characters, strings and pointers
+ * are converted by digit pair tables, including flags, width and
+ * precision. The other conversions, e.g. floating point and wide
+ * characters, are formatted one by one by snprintf. A format with an
+ * unknown conversion is formatted as a whole by vsnprintf, the argument
+ * list is never read past a conversion of unknown type.
+ *
+ * \param	_buf [out]	: output buffer, zero terminated if _size is not 0
+ * \param	_size		: size of the output buffer
+ * \param	_format		: "printf" style formatted string argument
+ * \param	_ap			: variable argument list
+ * \return	length of the complete message like vsnprintf, or negative
+ * 			errno value on error
+ * ****************************************************************************/
+int tty_portmux_fmt__vformat(char *_buf, size_t _size, const char *_format, va_list _ap);
+int tty_portmux_fmt__format(char *_buf, size_t _size, const char *_format, ...);
+
+/* ************************************************************************//**
+ * \brief	Formatting of the bytes _offset .. _offset + _size - 1 of a
+ * 			message, a message exceeding a buffer is written in windows
+ * 			without a copy on the heap
+ *
+ * A conversion of the c-runtime longer than M_TTY_FMT_CONV_MAX bytes and
+ * an unknown conversion fail.
+ *
+ * \param	_buf [out]	: output buffer, not zero terminated
+ * \param	_size		: size of the output buffer
+ * \param	_offset		: offset of the first byte in the message
+ * \param	_format		: "printf" style formatted string argument
+ * \param	_ap			: variable argument list
+ * \return	length of the complete message, or negative errno value on error
+ * ****************************************************************************/
+int tty_portmux_fmt__vformat_at(char *_buf, size_t _size, size_t _offset, const char *_format, va_list _ap);
+
+/* ************************************************************************//**
+ * \brief	Capture of the format pointer and the raw argument values
+ *
+ * Only the argument types are taken from the format string. Strings are
+ * copied, so the record stays valid after the caller returns. Wide strings
+ * and "%m" are converted to a string at the time of the call. The format
+ * string itself is referenced and must have static storage duration.
+ * Packing stops at an unknown conversion.
+ *
+ * \param	_rec [out]	: record buffer
+ * \param	_size		: size of the record buffer
+ * \param	_format		: "printf" style formatted string argument
+ * \param	_ap			: variable argument list
+ * \return	length of the record, or negative errno value on error
+ * ****************************************************************************/
+int tty_portmux_fmt__pack(char *_rec, size_t _size, const char *_format, va_list _ap);
+
+/* ************************************************************************//**
+ * \brief	Rendering of a record captured by tty_portmux_fmt__pack
+ *
+ * \param	_buf [out]	: output buffer, always zero terminated
+ * \param	_size		: size of the output buffer
+ * \param	_rec		: record
+ * \param	_recLen		: length of the record
+ * \return	number of characters written to _buf
+ * ****************************************************************************/
+size_t tty_portmux_fmt__render(char *_buf, size_t _size, const char *_rec, size_t _recLen);
+
+#endif /* _TTY_PORTMUX_FMT_H_ */
@@ -0,0 +1,181 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal 
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* *******************************************************************
+ * includes
+ * ******************************************************************/
+
+/* c -runtime */
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+
+/* frame */
+#include <lib_convention__errno.h>
+
+/* project */
+#include "tty_portmux_latency.h"
+
+/* *******************************************************************
+ * defines
+ * ******************************************************************/
+#define M_TTYLATENCY_CACHE_LINE		64
+#define M_TTYLATENCY_SUB_BITS		4		/*!< 16 linear buckets per power of two, ~6% resolution */
+#define M_TTYLATENCY_SUB_COUNT		(1U << M_TTYLATENCY_SUB_BITS)
+#define M_TTYLATENCY_MAX_EXP		40		/*!< ~18 minutes, longer calls go to the last bucket */
+#define M_TTYLATENCY_BUCKETS		((M_TTYLATENCY_MAX_EXP - M_TTYLATENCY_SUB_BITS + 2) * M_TTYLATENCY_SUB_COUNT)
+
+/* *******************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ******************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Log-linear histogram of the driver calls of a ttydevice
+ *
+ * Values below M_TTYLATENCY_SUB_COUNT ns are counted exactly. Above, each
+ * power of two is split into M_TTYLATENCY_SUB_COUNT linear buckets.
+ * ****************************************************************************/
+struct tty_latency_histogram {
+	_Alignas(M_TTYLATENCY_CACHE_LINE) atomic_ullong max;
+	atomic_uint bucket[M_TTYLATENCY_BUCKETS];
+};
+
+/* *******************************************************************
+ * static function declarations
+ * ******************************************************************/
+static unsigned int tty_portmux_latency__bucket(uint64_t _ns);
+static uint64_t tty_portmux_latency__value(unsigned int _bucket);
+
+/* *******************************************************************
+ * static data
+ * ******************************************************************/
+static struct tty_latency_histogram s_histogram[M_TTYLATENCY_DEVICE_MAX];
+
+/* *******************************************************************
+ * function definition
+ * ******************************************************************/
+
+void tty_portmux_latency__stop(unsigned int _deviceId, uint64_t _start)
+{
+	struct tty_latency_histogram *histogram;
+	unsigned long long max;
+	uint64_t ns;
+
+	if (_deviceId >= M_TTYLATENCY_DEVICE_MAX) {
+		return;
+	}
+
+	ns = tty_portmux_clock__ns() - _start;
+	histogram = &s_histogram[_deviceId];
+	atomic_fetch_add_explicit(&histogram->bucket[tty_portmux_latency__bucket(ns)], 1, memory_order_relaxed);
+
+	max = atomic_load_explicit(&histogram->max, memory_order_relaxed);
+	while ((ns > max) && !atomic_compare_exchange_weak_explicit(&histogram->max, &max, ns,
+			memory_order_relaxed, memory_order_relaxed));
+}
+
+int tty_portmux_latency__get(unsigned int _deviceId, struct ttyLatency *_latency)
+{
+	static const unsigned int permille[] = { 500, 990, 999 };
+	unsigned int counts[M_TTYLATENCY_BUCKETS];
+	uint64_t *percentile[] = { &_latency->p50, &_latency->p99, &_latency->p999 };
+	uint64_t total = 0, sum = 0, rank;
+	unsigned int i, p = 0;
+
+	if (_deviceId >= M_TTYLATENCY_DEVICE_MAX) {
+		return -ESTD_NODEV;
+	}
+
+	memset(_latency, 0, sizeof(struct ttyLatency));
+	for (i = 0; i < M_TTYLATENCY_BUCKETS; i++) {
+		counts[i] = atomic_load_explicit(&s_histogram[_deviceId].bucket[i], memory_order_relaxed);
+		total += counts[i];
+	}
+	_latency->count = total;
+	_latency->max = atomic_load_explicit(&s_histogram[_deviceId].max, memory_order_relaxed);
+	if (total == 0) {
+		return EOK;
+	}
+
+	for (i = 0; (i < M_TTYLATENCY_BUCKETS) && (p < 3); i++) {
+		sum += counts[i];
+		while (p < 3) {
+			rank = ((total * permille[p]) + 999) / 1000;
+			if (sum < rank) {
+				break;
+			}
+			*percentile[p++] = tty_portmux_latency__value(i);
+		}
+	}
+	return EOK;
+}
+
+void tty_portmux_latency__reset(void)
+{
+	unsigned int dev, i;
+
+	for (dev = 0; dev < M_TTYLATENCY_DEVICE_MAX; dev++) {
+		for (i = 0; i < M_TTYLATENCY_BUCKETS; i++) {
+			atomic_store_explicit(&s_histogram[dev].bucket[i], 0, memory_order_relaxed);
+		}
+		atomic_store_explicit(&s_histogram[dev].max, 0, memory_order_relaxed);
+	}
+}
+
+/* *******************************************************************
+ * static function definitions
+ * ******************************************************************/
+
+static unsigned int tty_portmux_latency__bucket(uint64_t _ns)
+{
+	unsigned int exp;
+
+	if (_ns < M_TTYLATENCY_SUB_COUNT) {
+		return (unsigned int)_ns;
+	}
+
+	exp = 63 - __builtin_clzll(_ns);
+	if (exp > M_TTYLATENCY_MAX_EXP) {
+		return M_TTYLATENCY_BUCKETS - 1;
+	}
+	return ((exp - M_TTYLATENCY_SUB_BITS + 1) * M_TTYLATENCY_SUB_COUNT) +
+			(unsigned int)((_ns >> (exp - M_TTYLATENCY_SUB_BITS)) & (M_TTYLATENCY_SUB_COUNT - 1));
+}
+
+/* ************************************************************************//**
+ * \brief	Upper bound of a bucket in nanoseconds
+ * ****************************************************************************/
+static uint64_t tty_portmux_latency__value(unsigned int _bucket)
+{
+	unsigned int exp, sub;
+
+	if (_bucket < M_TTYLATENCY_SUB_COUNT) {
+		return _bucket;
+	}
+
+	exp = (_bucket / M_TTYLATENCY_SUB_COUNT) + M_TTYLATENCY_SUB_BITS - 1;
+	sub = _bucket % M_TTYLATENCY_SUB_COUNT;
+	return ((uint64_t)(M_TTYLATENCY_SUB_COUNT + sub + 1) << (exp - M_TTYLATENCY_SUB_BITS)) - 1;
+}
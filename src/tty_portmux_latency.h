@@ -0,0 +1,86 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal 
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _TTY_PORTMUX_LATENCY_H_
+#define _TTY_PORTMUX_LATENCY_H_
+
+/* *******************************************************************
+ * includes
+ * ******************************************************************/
+
+/* c runtime */
+#include <stdint.h>
+
+/* project */
+#include "lib_ttyportmux_types.h"
+#if defined(M_TTYPORTMUX_LATENCY)
+#include "tty_portmux_clock.h"
+#endif
+
+/* *******************************************************************
+ * defines
+ * ******************************************************************/
+#define M_TTYLATENCY_DEVICE_MAX		16		/*!< devices registered later are not measured */
+
+/* *******************************************************************
+ * function declarations
+ * ******************************************************************/
+#if defined(M_TTYPORTMUX_LATENCY)
+
+/* ************************************************************************//**
+ * \brief	Account of the duration of a driver call
+ *
+ * \param   _deviceId	: registration index of the ttydevice
+ * \param   _start		: time stamp of tty_portmux_latency__start() before the call
+ * ****************************************************************************/
+void tty_portmux_latency__stop(unsigned int _deviceId, uint64_t _start);
+
+/* ************************************************************************//**
+ * \brief	Percentiles of the driver calls of a ttydevice
+ *
+ * \param   _deviceId	: registration index of the ttydevice
+ * \param   _latency [out]	: percentiles in nanoseconds
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+int tty_portmux_latency__get(unsigned int _deviceId, struct ttyLatency *_latency);
+
+/* ************************************************************************//**
+ * \brief	Reset of the histograms of all ttydevices
+ * ****************************************************************************/
+void tty_portmux_latency__reset(void);
+
+static inline uint64_t tty_portmux_latency__start(void)
+{
+	return tty_portmux_clock__ns();
+}
+
+#else
+
+static inline uint64_t tty_portmux_latency__start(void) { return 0; }
+static inline void tty_portmux_latency__stop(unsigned int _deviceId, uint64_t _start) { (void)_deviceId; (void)_start; }
+
+#endif /* M_TTYPORTMUX_LATENCY */
+
+#endif /* _TTY_PORTMUX_LATENCY_H_ */
@@ -0,0 +1,192 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal 
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* *******************************************************************
+ * includes
+ * ******************************************************************/
+
+/* c -runtime */
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+
+/* project */
+#include "tty_portmux_prefix.h"
+
+/* *******************************************************************
+ * defines
+ * ******************************************************************/
+#if defined(CLOCK_REALTIME_COARSE)
+	#define M_TTYPREFIX_CLOCK		CLOCK_REALTIME_COARSE
+#else
+	#define M_TTYPREFIX_CLOCK		CLOCK_REALTIME
+#endif
+
+#define M_TTYPREFIX_DATE_LEN		19		/*!< "YYYY-MM-DD HH:MM:SS" */
+
+/* *******************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ******************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Per thread state of the prefix, no synchronisation required
+ * ****************************************************************************/
+struct tty_prefix_cache {
+	time_t sec;					/*!< second of date, -1 if not rendered yet */
+	char date[M_TTYPREFIX_DATE_LEN + 1];
+	char tid[24];				/*!< " [<tid>]", empty if not requested yet */
+	size_t tidLen;
+};
+
+/* *******************************************************************
+ * static function declarations
+ * ******************************************************************/
+static size_t tty_portmux_prefix__utoa(char *_buf, unsigned long _val);
+static void tty_portmux_prefix__atfork_register(void);
+static void tty_portmux_prefix__atfork_child(void);
+
+/* *******************************************************************
+ * static data
+ * ******************************************************************/
+static atomic_uint s_flags = 0;
+static _Thread_local struct tty_prefix_cache s_cache = { .sec = -1 };
+static pthread_once_t s_atforkOnce = PTHREAD_ONCE_INIT;
+
+/* *******************************************************************
+ * function definition
+ * ******************************************************************/
+
+void tty_portmux_prefix__set(unsigned int _flags)
+{
+	atomic_store_explicit(&s_flags, _flags, memory_order_relaxed);
+}
+
+unsigned int tty_portmux_prefix__get(void)
+{
+	return atomic_load_explicit(&s_flags, memory_order_relaxed);
+}
+
+int tty_portmux_prefix__enabled(void)
+{
+	return atomic_load_explicit(&s_flags, memory_order_relaxed) != 0;
+}
+
+size_t tty_portmux_prefix__render(char *_buf, const char *_streamName)
+{
+	struct timespec now;
+	struct tm tm;
+	unsigned int flags, ms;
+	size_t len = 0, nameLen;
+	int errnum;
+
+	flags = atomic_load_explicit(&s_flags, memory_order_relaxed);
+
+	if (flags & M_TTYPREFIX_TIME) {
+		clock_gettime(M_TTYPREFIX_CLOCK, &now);
+		if (now.tv_sec != s_cache.sec) {
+			/* errno of the caller is kept for a "%m" of the message */
+			errnum = errno;
+			localtime_r(&now.tv_sec, &tm);
+			strftime(&s_cache.date[0], sizeof(s_cache.date), "%Y-%m-%d %H:%M:%S", &tm);
+			s_cache.sec = now.tv_sec;
+			errno = errnum;
+		}
+
+		memcpy(&_buf[len], &s_cache.date[0], M_TTYPREFIX_DATE_LEN);
+		len += M_TTYPREFIX_DATE_LEN;
+
+		ms = (unsigned int)(now.tv_nsec / 1000000);
+		_buf[len++] = '.';
+		_buf[len++] = (char)('0' + (ms / 100));
+		_buf[len++] = (char)('0' + ((ms / 10) % 10));
+		_buf[len++] = (char)('0' + (ms % 10));
+		_buf[len++] = ' ';
+	}
+
+	if ((flags & M_TTYPREFIX_STREAM) && (_streamName != NULL)) {
+		nameLen = strnlen(_streamName, M_TTYPREFIX_NAME_MAX);
+		memcpy(&_buf[len], _streamName, nameLen);
+		len += nameLen;
+		_buf[len++] = ' ';
+	}
+
+	if (flags & M_TTYPREFIX_TID) {
+		if (s_cache.tidLen == 0) {
+			/* the forking thread continues with a new id in the child */
+			pthread_once(&s_atforkOnce, &tty_portmux_prefix__atfork_register);
+#if defined(SYS_gettid)
+			s_cache.tidLen = tty_portmux_prefix__utoa(&s_cache.tid[1], (unsigned long)syscall(SYS_gettid));
+#else
+			s_cache.tidLen = tty_portmux_prefix__utoa(&s_cache.tid[1], (unsigned long)pthread_self());
+#endif
+			s_cache.tid[0] = '[';
+			s_cache.tid[s_cache.tidLen + 1] = ']';
+			s_cache.tid[s_cache.tidLen + 2] = ' ';
+			s_cache.tidLen += 3;
+		}
+		memcpy(&_buf[len], &s_cache.tid[0], s_cache.tidLen);
+		len += s_cache.tidLen;
+	}
+
+	return len;
+}
+
+/* *******************************************************************
+ * static function definitions
+ * ******************************************************************/
+static size_t tty_portmux_prefix__utoa(char *_buf, unsigned long _val)
+{
+	char tmp[20];
+	size_t len = 0, i;
+
+	do {
+		tmp[len++] = (char)('0' + (_val % 10));
+		_val /= 10;
+	} while ((_val > 0) && (len < sizeof(tmp)));
+
+	for (i = 0; i < len; i++) {
+		_buf[i] = tmp[len - 1 - i];
+	}
+	return len;
+}
+
+static void tty_portmux_prefix__atfork_register(void)
+{
+	pthread_atfork(NULL, NULL, &tty_portmux_prefix__atfork_child);
+}
+
+/* ************************************************************************//**
+ * \brief	The calling thread is the only thread of the child, the thread id
+ * 			of its cache is the one of the parent
+ * ****************************************************************************/
+static void tty_portmux_prefix__atfork_child(void)
+{
+	s_cache.tidLen = 0;
+}
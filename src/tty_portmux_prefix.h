@@ -0,0 +1,80 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal 
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _TTY_PORTMUX_PREFIX_H_
+#define _TTY_PORTMUX_PREFIX_H_
+
+/* *******************************************************************
+ * includes
+ * ******************************************************************/
+
+/* c runtime */
+#include <stddef.h>
+
+/* project */
+#include "lib_ttyportmux_types.h"
+
+/* *******************************************************************
+ * defines
+ * ******************************************************************/
+#define M_TTYPREFIX_SIZE			80		/*!< longest prefix */
+#define M_TTYPREFIX_NAME_MAX		24		/*!< longest stream name of a prefix */
+
+/* *******************************************************************
+ * function declarations
+ * ******************************************************************/
+#if defined(M_TTYPORTMUX_PREFIX)
+
+/* ************************************************************************//**
+ * \brief	Set of the prefix fields, M_TTYPREFIX_*, 0 disables the prefix
+ * ****************************************************************************/
+void tty_portmux_prefix__set(unsigned int _flags);
+unsigned int tty_portmux_prefix__get(void);
+
+/* ************************************************************************//**
+ * \brief	Check if messages are prefixed, a single relaxed load
+ * ****************************************************************************/
+int tty_portmux_prefix__enabled(void);
+
+/* ************************************************************************//**
+ * \brief	Rendering of the prefix of a message of the calling thread
+ *
+ * The date and time string is rendered once per second and thread, the
+ * thread id is requested once per thread and again in the child of a fork.
+ *
+ * \param   _buf		: destination, at least M_TTYPREFIX_SIZE bytes
+ * \param   _streamName	: name of the stream of the message
+ * \return	length of the prefix, 0 if disabled
+ * ****************************************************************************/
+size_t tty_portmux_prefix__render(char *_buf, const char *_streamName);
+
+#else
+
+static inline int tty_portmux_prefix__enabled(void) { return 0; }
+static inline size_t tty_portmux_prefix__render(char *_buf, const char *_streamName) { (void)_buf; (void)_streamName; return 0; }
+
+#endif /* M_TTYPORTMUX_PREFIX */
+
+#endif /* _TTY_PORTMUX_PREFIX_H_ */
@@ -0,0 +1,141 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal 
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* *******************************************************************
+ * includes
+ * ******************************************************************/
+
+/* c -runtime */
+#include <stdatomic.h>
+#include <stdint.h>
+
+/* frame */
+#include <lib_convention__errno.h>
+
+/* project */
+#include "tty_portmux_ratelimit.h"
+#include "tty_portmux_clock.h"
+
+/* *******************************************************************
+ * defines
+ * ******************************************************************/
+#define M_TTYRATELIMIT_CACHE_LINE	64
+#define M_TTYRATELIMIT_NS			1000000000ULL
+
+/* *******************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ******************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Token bucket of a stream as generic cell rate algorithm
+ *
+ * tat is the theoretical arrival time of the next message. A message is
+ * admitted if tat is less than tolerance ahead of now, tat advances by
+ * interval then. The whole bucket state is the single word tat.
+ * ****************************************************************************/
+struct tty_ratelimit_bucket {
+	_Alignas(M_TTYRATELIMIT_CACHE_LINE) atomic_ullong tat;
+	atomic_ullong interval;		/*!< ns per message, 0 if not limited */
+	atomic_ullong tolerance;	/*!< interval * burst */
+	atomic_ullong suppressed;	/*!< messages suppressed since the last admitted one */
+	atomic_uint rate;
+	atomic_uint burst;
+};
+
+/* *******************************************************************
+ * static data
+ * ******************************************************************/
+static struct tty_ratelimit_bucket s_buckets[TTYSTREAM_CNT];
+
+/* *******************************************************************
+ * function definition
+ * ******************************************************************/
+
+int tty_portmux_ratelimit__set(enum ttyStreamType _streamType, unsigned int _rate, unsigned int _burst)
+{
+	struct tty_ratelimit_bucket *bucket;
+	uint64_t interval;
+
+	if (_streamType >= TTYSTREAM_CNT) {
+		return -ESTD_INVAL;
+	}
+
+	if (_burst == 0) {
+		_burst = 1;
+	}
+
+	bucket = &s_buckets[_streamType];
+	interval = (_rate > 0) ? (M_TTYRATELIMIT_NS / _rate) : 0;
+
+	atomic_store_explicit(&bucket->interval, 0, memory_order_relaxed);
+	atomic_store_explicit(&bucket->tat, 0, memory_order_relaxed);
+	atomic_store_explicit(&bucket->tolerance, interval * _burst, memory_order_relaxed);
+	atomic_store_explicit(&bucket->rate, _rate, memory_order_relaxed);
+	atomic_store_explicit(&bucket->burst, _burst, memory_order_relaxed);
+	atomic_store_explicit(&bucket->interval, interval, memory_order_release);
+	return EOK;
+}
+
+int tty_portmux_ratelimit__get(enum ttyStreamType _streamType, unsigned int *_rate, unsigned int *_burst)
+{
+	if (_streamType >= TTYSTREAM_CNT) {
+		return -ESTD_INVAL;
+	}
+
+	*_rate = atomic_load_explicit(&s_buckets[_streamType].rate, memory_order_relaxed);
+	*_burst = atomic_load_explicit(&s_buckets[_streamType].burst, memory_order_relaxed);
+	return EOK;
+}
+
+int tty_portmux_ratelimit__admit(enum ttyStreamType _streamType, uint64_t *_suppressed)
+{
+	struct tty_ratelimit_bucket *bucket = &s_buckets[_streamType];
+	unsigned long long interval, tolerance, now, tat, base;
+
+	*_suppressed = 0;
+
+	interval = atomic_load_explicit(&bucket->interval, memory_order_acquire);
+	if (interval == 0) {
+		return 1;
+	}
+
+	tolerance = atomic_load_explicit(&bucket->tolerance, memory_order_relaxed);
+	now = tty_portmux_clock__coarse_ns();
+	tat = atomic_load_explicit(&bucket->tat, memory_order_relaxed);
+
+	do {
+		base = (tat > now) ? tat : now;
+		if ((base - now) >= tolerance) {
+			atomic_fetch_add_explicit(&bucket->suppressed, 1, memory_order_relaxed);
+			return 0;
+		}
+	} while (!atomic_compare_exchange_weak_explicit(&bucket->tat, &tat, base + interval, memory_order_relaxed, memory_order_relaxed));
+
+	/* first admitted message after a storm reports the suppressed ones */
+	if (atomic_load_explicit(&bucket->suppressed, memory_order_relaxed) != 0) {
+		*_suppressed = atomic_exchange_explicit(&bucket->suppressed, 0, memory_order_relaxed);
+	}
+	return 1;
+}
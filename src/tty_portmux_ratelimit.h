@@ -0,0 +1,75 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal 
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _TTY_PORTMUX_RATELIMIT_H_
+#define _TTY_PORTMUX_RATELIMIT_H_
+
+/* *******************************************************************
+ * includes
+ * ******************************************************************/
+
+/* c runtime */
+#include <stdint.h>
+
+/* project */
+#include "lib_ttyportmux_types.h"
+
+/* *******************************************************************
+ * function declarations
+ * ******************************************************************/
+#if defined(M_TTYPORTMUX_RATELIMIT)
+
+/* ************************************************************************//**
+ * \brief	Setup of the token bucket of a stream
+ *
+ * \param   _streamType	: stream to limit
+ * \param   _rate		: messages per second, 0 disables the limit
+ * \param   _burst		: messages written at once after an idle period, at least 1
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+int tty_portmux_ratelimit__set(enum ttyStreamType _streamType, unsigned int _rate, unsigned int _burst);
+
+/* ************************************************************************//**
+ * \brief	Request of the token bucket setup of a stream
+ * ****************************************************************************/
+int tty_portmux_ratelimit__get(enum ttyStreamType _streamType, unsigned int *_rate, unsigned int *_burst);
+
+/* ************************************************************************//**
+ * \brief	Admission of a message, a single CAS if the stream is limited
+ *
+ * \param   _streamType		: stream of the message
+ * \param   _suppressed [out]: messages suppressed since the last admitted
+ * 							  one, to be reported before this message
+ * \return	non zero if the message is written, 0 if it is suppressed
+ * ****************************************************************************/
+int tty_portmux_ratelimit__admit(enum ttyStreamType _streamType, uint64_t *_suppressed);
+
+#else
+
+static inline int tty_portmux_ratelimit__admit(enum ttyStreamType _streamType, uint64_t *_suppressed) { (void)_streamType; *_suppressed = 0; return 1; }
+
+#endif /* M_TTYPORTMUX_RATELIMIT */
+
+#endif /* _TTY_PORTMUX_RATELIMIT_H_ */
@@ -0,0 +1,229 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal 
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* *******************************************************************
+ * includes
+ * ******************************************************************/
+
+/* c -runtime */
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+
+/* frame */
+#include <lib_convention__errno.h>
+
+/* project */
+#include "tty_portmux_stats.h"
+
+/* *******************************************************************
+ * defines
+ * ******************************************************************/
+#define M_TTYSTATS_CACHE_LINE		64
+#define M_TTYSTATS_SHARDS			8		/*!< threads share a shard beyond this count */
+
+/* *******************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ******************************************************************/
+
+/* 64 bit counters only where they are lock free, otherwise native width */
+#if (ATOMIC_LLONG_LOCK_FREE == 2)
+typedef atomic_ullong tty_stats_count_t;
+#else
+typedef atomic_ulong tty_stats_count_t;
+#endif
+
+struct tty_stats_counter {
+	tty_stats_count_t messages;
+	tty_stats_count_t bytes;
+	tty_stats_count_t errors;
+	tty_stats_count_t drops;
+	tty_stats_count_t suppressed;
+	tty_stats_count_t truncated;
+	atomic_uint maxPayload;
+};
+
+/* ************************************************************************//**
+ * \brief	Counters updated by the threads of a shard
+ *
+ * Each shard starts at its own cache line, so threads of different shards
+ * never write to the same line.
+ * ****************************************************************************/
+struct tty_stats_shard {
+	_Alignas(M_TTYSTATS_CACHE_LINE) struct tty_stats_counter stream[TTYSTREAM_CNT];
+	struct tty_stats_counter device[M_TTYSTATS_DEVICE_MAX];
+};
+
+/* *******************************************************************
+ * static function declarations
+ * ******************************************************************/
+static struct tty_stats_shard* tty_portmux_stats__shard(void);
+static void tty_portmux_stats__count(struct tty_stats_counter *_counter, int _ret, size_t _len);
+static void tty_portmux_stats__sum(size_t _offset, struct ttyStats *_stats);
+
+/* *******************************************************************
+ * static data
+ * ******************************************************************/
+static struct tty_stats_shard s_shards[M_TTYSTATS_SHARDS];
+static atomic_uint s_shardNext = 0;
+static _Thread_local unsigned int s_shardIndex = 0;	/*!< shard + 1, 0 if not assigned yet */
+
+/* *******************************************************************
+ * function definition
+ * ******************************************************************/
+
+void tty_portmux_stats__stream(enum ttyStreamType _streamType, int _ret, size_t _len)
+{
+	if (_streamType < TTYSTREAM_CNT) {
+		tty_portmux_stats__count(&tty_portmux_stats__shard()->stream[_streamType], _ret, _len);
+	}
+}
+
+void tty_portmux_stats__device(unsigned int _deviceId, int _ret, size_t _len)
+{
+	if (_deviceId < M_TTYSTATS_DEVICE_MAX) {
+		tty_portmux_stats__count(&tty_portmux_stats__shard()->device[_deviceId], _ret, _len);
+	}
+}
+
+void tty_portmux_stats__drop(enum ttyStreamType _streamType)
+{
+	if (_streamType < TTYSTREAM_CNT) {
+		atomic_fetch_add_explicit(&tty_portmux_stats__shard()->stream[_streamType].drops, 1, memory_order_relaxed);
+	}
+}
+
+void tty_portmux_stats__suppress(enum ttyStreamType _streamType)
+{
+	if (_streamType < TTYSTREAM_CNT) {
+		atomic_fetch_add_explicit(&tty_portmux_stats__shard()->stream[_streamType].suppressed, 1, memory_order_relaxed);
+	}
+}
+
+void tty_portmux_stats__truncate(enum ttyStreamType _streamType)
+{
+	if (_streamType < TTYSTREAM_CNT) {
+		atomic_fetch_add_explicit(&tty_portmux_stats__shard()->stream[_streamType].truncated, 1, memory_order_relaxed);
+	}
+}
+
+int tty_portmux_stats__get_stream(enum ttyStreamType _streamType, struct ttyStats *_stats)
+{
+	if (_streamType >= TTYSTREAM_CNT) {
+		return -ESTD_INVAL;
+	}
+
+	tty_portmux_stats__sum(offsetof(struct tty_stats_shard, stream) + (_streamType * sizeof(struct tty_stats_counter)), _stats);
+	return EOK;
+}
+
+int tty_portmux_stats__get_device(unsigned int _deviceId, struct ttyStats *_stats)
+{
+	if (_deviceId >= M_TTYSTATS_DEVICE_MAX) {
+		return -ESTD_NODEV;
+	}
+
+	tty_portmux_stats__sum(offsetof(struct tty_stats_shard, device) + (_deviceId * sizeof(struct tty_stats_counter)), _stats);
+	return EOK;
+}
+
+void tty_portmux_stats__reset(void)
+{
+	struct tty_stats_counter *counter;
+	unsigned int shard, i, count;
+
+	count = TTYSTREAM_CNT + M_TTYSTATS_DEVICE_MAX;
+	for (shard = 0; shard < M_TTYSTATS_SHARDS; shard++) {
+		for (i = 0; i < count; i++) {
+			counter = (i < TTYSTREAM_CNT) ? &s_shards[shard].stream[i] : &s_shards[shard].device[i - TTYSTREAM_CNT];
+			atomic_store_explicit(&counter->messages, 0, memory_order_relaxed);
+			atomic_store_explicit(&counter->bytes, 0, memory_order_relaxed);
+			atomic_store_explicit(&counter->errors, 0, memory_order_relaxed);
+			atomic_store_explicit(&counter->drops, 0, memory_order_relaxed);
+			atomic_store_explicit(&counter->suppressed, 0, memory_order_relaxed);
+			atomic_store_explicit(&counter->truncated, 0, memory_order_relaxed);
+			atomic_store_explicit(&counter->maxPayload, 0, memory_order_relaxed);
+		}
+	}
+}
+
+/* *******************************************************************
+ * static function definitions
+ * ******************************************************************/
+
+/* ************************************************************************//**
+ * \brief	Shard of the calling thread, assigned round robin at first use
+ * ****************************************************************************/
+static struct tty_stats_shard* tty_portmux_stats__shard(void)
+{
+	if (s_shardIndex == 0) {
+		s_shardIndex = (atomic_fetch_add_explicit(&s_shardNext, 1, memory_order_relaxed) % M_TTYSTATS_SHARDS) + 1;
+	}
+	return &s_shards[s_shardIndex - 1];
+}
+
+static void tty_portmux_stats__count(struct tty_stats_counter *_counter, int _ret, size_t _len)
+{
+	unsigned int max;
+
+	if (_ret < EOK) {
+		atomic_fetch_add_explicit(&_counter->errors, 1, memory_order_relaxed);
+		return;
+	}
+
+	atomic_fetch_add_explicit(&_counter->messages, 1, memory_order_relaxed);
+	if (_len == 0) {
+		return;
+	}
+
+	atomic_fetch_add_explicit(&_counter->bytes, _len, memory_order_relaxed);
+	max = atomic_load_explicit(&_counter->maxPayload, memory_order_relaxed);
+	while ((_len > max) && !atomic_compare_exchange_weak_explicit(&_counter->maxPayload, &max, (unsigned int)_len,
+			memory_order_relaxed, memory_order_relaxed));
+}
+
+/* ************************************************************************//**
+ * \brief	Sum of the counter at _offset of each shard
+ * ****************************************************************************/
+static void tty_portmux_stats__sum(size_t _offset, struct ttyStats *_stats)
+{
+	struct tty_stats_counter *counter;
+	unsigned int shard, max;
+
+	memset(_stats, 0, sizeof(struct ttyStats));
+	for (shard = 0; shard < M_TTYSTATS_SHARDS; shard++) {
+		counter = (struct tty_stats_counter*)((char*)&s_shards[shard] + _offset);
+		_stats->messages += atomic_load_explicit(&counter->messages, memory_order_relaxed);
+		_stats->bytes += atomic_load_explicit(&counter->bytes, memory_order_relaxed);
+		_stats->errors += atomic_load_explicit(&counter->errors, memory_order_relaxed);
+		_stats->drops += atomic_load_explicit(&counter->drops, memory_order_relaxed);
+		_stats->suppressed += atomic_load_explicit(&counter->suppressed, memory_order_relaxed);
+		_stats->truncated += atomic_load_explicit(&counter->truncated, memory_order_relaxed);
+		max = atomic_load_explicit(&counter->maxPayload, memory_order_relaxed);
+		if (max > _stats->maxPayload) {
+			_stats->maxPayload = max;
+		}
+	}
+}
@@ -0,0 +1,115 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal 
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _TTY_PORTMUX_STATS_H_
+#define _TTY_PORTMUX_STATS_H_
+
+/* *******************************************************************
+ * includes
+ * ******************************************************************/
+
+/* c runtime */
+#include <stddef.h>
+
+/* project */
+#include "lib_ttyportmux_types.h"
+
+/* *******************************************************************
+ * defines
+ * ******************************************************************/
+#define M_TTYSTATS_DEVICE_MAX		16		/*!< devices registered later are not counted */
+
+/* *******************************************************************
+ * function declarations
+ * ******************************************************************/
+#if defined(M_TTYPORTMUX_STATS)
+
+/* ************************************************************************//**
+ * \brief	Account of a message written to a stream
+ *
+ * \param   _streamType	: stream of the message
+ * \param   _ret		: result of the write, a negative value is counted as error
+ * \param   _len		: length of the message, 0 if not known
+ * ****************************************************************************/
+void tty_portmux_stats__stream(enum ttyStreamType _streamType, int _ret, size_t _len);
+
+/* ************************************************************************//**
+ * \brief	Account of a message written to a ttydevice
+ *
+ * \param   _deviceId	: registration index of the ttydevice
+ * \param   _ret		: result of the driver, a negative value is counted as error
+ * \param   _len		: length of the message, 0 if not known
+ * ****************************************************************************/
+void tty_portmux_stats__device(unsigned int _deviceId, int _ret, size_t _len);
+
+/* ************************************************************************//**
+ * \brief	Account of a message of a stream which was discarded
+ *
+ * \param   _streamType	: stream of the message
+ * ****************************************************************************/
+void tty_portmux_stats__drop(enum ttyStreamType _streamType);
+
+/* ************************************************************************//**
+ * \brief	Account of a message of a stream which was suppressed by the rate
+ * 			limit
+ *
+ * \param   _streamType	: stream of the message
+ * ****************************************************************************/
+void tty_portmux_stats__suppress(enum ttyStreamType _streamType);
+
+/* ************************************************************************//**
+ * \brief	Account of a message of a stream which was written cut to the
+ * 			formatting buffer
+ *
+ * \param   _streamType	: stream of the message
+ * ****************************************************************************/
+void tty_portmux_stats__truncate(enum ttyStreamType _streamType);
+
+/* ************************************************************************//**
+ * \brief	Sum of the counters of all shards of a stream or ttydevice
+ *
+ * \param   _streamType / _deviceId	: counters to request
+ * \param   _stats [out]				: summed counters
+ * \return	EOK if successful, or negative errno value on error
+ * ****************************************************************************/
+int tty_portmux_stats__get_stream(enum ttyStreamType _streamType, struct ttyStats *_stats);
+int tty_portmux_stats__get_device(unsigned int _deviceId, struct ttyStats *_stats);
+
+/* ************************************************************************//**
+ * \brief	Reset of all counters, concurrent updates may survive the reset
+ * ****************************************************************************/
+void tty_portmux_stats__reset(void);
+
+#else
+
+static inline void tty_portmux_stats__stream(enum ttyStreamType _streamType, int _ret, size_t _len) { (void)_streamType; (void)_ret; (void)_len; }
+static inline void tty_portmux_stats__device(unsigned int _deviceId, int _ret, size_t _len) { (void)_deviceId; (void)_ret; (void)_len; }
+static inline void tty_portmux_stats__drop(enum ttyStreamType _streamType) { (void)_streamType; }
+static inline void tty_portmux_stats__suppress(enum ttyStreamType _streamType) { (void)_streamType; }
+static inline void tty_portmux_stats__truncate(enum ttyStreamType _streamType) { (void)_streamType; }
+
+#endif /* M_TTYPORTMUX_STATS */
+
+#endif /* _TTY_PORTMUX_STATS_H_ */
@@ -48,26 +48,35 @@ struct ttydevice
 	struct list_node node;
 	void *port_hdl;
 	ttydriver_t *ttydriver;		/*driver structure passed during init*/
+	unsigned int deviceId;		/*!< registration order of all ttydevices */
+	unsigned int deviceIndex;	/*!< instance of the driver, 0 .. info.deviceNumber - 1 */
 };
 
 typedef int (tty_open_t)(ttydevice_t *_ttydevice);
 typedef int (tty_close_t)(ttydevice_t *_ttydevice);
 typedef int (tty_write_t)(ttydevice_t *_ttydevice, enum ttyStreamType _stream, const char * const _format, va_list _ap);
+typedef int (tty_write_buf_t)(ttydevice_t *_ttydevice, enum ttyStreamType _stream, const char *_buf, size_t _len);
 typedef int (tty_put_char_t)(ttydevice_t *_ttydevice, enum ttyStreamType _stream, char _c);
+typedef int (tty_flush_t)(ttydevice_t *_ttydevice);
 typedef int (tty_read_t)(ttydevice_t *_ttydevice, enum ttyStreamType _stream, char *_lineptr, size_t *_n, char _delimiter);
 
 /* ************************************************************************//**
  * \brief	actual structure which is used for exchanging the function
  * 			pointers.
+ *
+ * write, write_buf and put_char return the number of bytes written, EOK if
+ * the driver does not know it, or a negative errno value on error.
  * ****************************************************************************/
 struct ttydriver {
 	struct ttyDeviceInfo info;
 	tty_open_t *open;				/*!< initialization function */
 	tty_close_t *close;			/*!< cleanup function */
 	tty_write_t *write;				/*!<  */
+	tty_write_buf_t *write_buf;		/*!< write of already formatted bytes, optional */
 	tty_put_char_t *put_char;		/*!< seek function */
 	tty_read_t *read;
-	ttydevice_t *ttydevice;
+	tty_flush_t *flush;				/*!< write of buffered bytes, optional */
+	ttydevice_t *ttydevice;			/*!< instances of the driver, kept for the next registration */
 };
 
 
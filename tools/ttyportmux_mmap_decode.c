@@ -0,0 +1,215 @@
+/*
+ * This file is part of the EMBTOM project
+ * Copyright (c) 2018-2019 Thomas Willetal 
+ * (https://github.com/tom3333)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE
+ * LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION
+ * WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* *******************************************************************
+ * includes
+ * ******************************************************************/
+
+/* c -runtime */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+
+/* project */
+#include <lib_ttyportmux_types.h>
+#include <lib_ttyportmux_mmap.h>
+
+/* *******************************************************************
+ * custom data types (e.g. enumerations, structures, unions)
+ * ******************************************************************/
+struct decode_result {
+	uint64_t records;
+	uint64_t skipped;		/*!< bytes without a valid record */
+};
+
+/* *******************************************************************
+ * static function declarations
+ * ******************************************************************/
+static void decode__usage(const char *_prog);
+static char *decode__load(const char *_path, size_t *_size);
+static void decode__ring(const struct ttyMmapHeader *_header, const char *_ring, int _verbose, struct decode_result *_result);
+
+/* *******************************************************************
+ * (static) variables declarations
+ * ******************************************************************/
+static const char *s_streamName[TTYSTREAM_CNT] = {
+	[TTYSTREAM_critical]	= "critical",
+	[TTYSTREAM_error]		= "error",
+	[TTYSTREAM_warning]		= "warning",
+	[TTYSTREAM_info]		= "info",
+	[TTYSTREAM_debug]		= "debug",
+	[TTYSTREAM_control]		= "control"
+};
+
+/* ************************************************************************//**
+ * \brief	Decoder of the ring file of the mmap ttydevice
+ *
+ * The records are printed from the oldest to the newest. The ring is
+ * recovered by the positions of the records, the file may be a copy taken
+ * after a crash of the writing process.
+ * ****************************************************************************/
+int main(int argc, char *argv[])
+{
+	const struct ttyMmapHeader *header;
+	struct decode_result result = { 0 };
+	char *file;
+	size_t size;
+	int opt, verbose = 0;
+
+	while ((opt = getopt(argc, argv, "vh")) != -1) {
+		switch (opt) {
+			case 'v': verbose = 1; break;
+			default: decode__usage(argv[0]); return EXIT_FAILURE;
+		}
+	}
+
+	if (optind != argc - 1) {
+		decode__usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	file = decode__load(argv[optind], &size);
+	if (file == NULL) {
+		return EXIT_FAILURE;
+	}
+
+	header = (const struct ttyMmapHeader*)file;
+	if ((size < M_TTYMMAP_HEADER_SIZE) || (memcmp(&header->magic[0], M_TTYMMAP_MAGIC, sizeof(header->magic)) != 0)) {
+		fprintf(stderr, "%s: no ttyportmux ring file\n", argv[optind]);
+		goto ERR_FILE;
+	}
+
+	if ((header->version != M_TTYMMAP_VERSION) || (header->headerSize < sizeof(struct ttyMmapHeader)) ||
+		(header->ringSize == 0) || ((header->ringSize & (header->ringSize - 1)) != 0) ||
+		(size < header->headerSize + header->ringSize)) {
+		fprintf(stderr, "%s: unsupported or truncated ring file\n", argv[optind]);
+		goto ERR_FILE;
+	}
+
+	decode__ring(header, file + header->headerSize, verbose, &result);
+
+	fprintf(stderr, "%llu records, %llu bytes lost or torn, %llu bytes uncommitted\n",
+			(unsigned long long)result.records, (unsigned long long)result.skipped,
+			(unsigned long long)(header->write - header->commit));
+	free(file);
+	return EXIT_SUCCESS;
+
+	ERR_FILE:
+	free(file);
+	return EXIT_FAILURE;
+}
+
+/* *******************************************************************
+ * static function definition
+ * ******************************************************************/
+static void decode__usage(const char *_prog)
+{
+	fprintf(stderr, "usage: %s [-v] <ring file>\n", _prog);
+	fprintf(stderr, "  -v  prefix each record by its position and stream\n");
+}
+
+static char *decode__load(const char *_path, size_t *_size)
+{
+	FILE *fp;
+	char *buf;
+	long len;
+
+	fp = fopen(_path, "rb");
+	if (fp == NULL) {
+		perror(_path);
+		return NULL;
+	}
+
+	if ((fseek(fp, 0, SEEK_END) != 0) || ((len = ftell(fp)) < 0) || (fseek(fp, 0, SEEK_SET) != 0)) {
+		perror(_path);
+		fclose(fp);
+		return NULL;
+	}
+
+	buf = malloc((size_t)len + 1);
+	if ((buf == NULL) || (fread(buf, 1, (size_t)len, fp) != (size_t)len)) {
+		fprintf(stderr, "%s: read failed\n", _path);
+		free(buf);
+		fclose(fp);
+		return NULL;
+	}
+
+	fclose(fp);
+	*_size = (size_t)len;
+	return buf;
+}
+
+/* ************************************************************************//**
+ * \brief	Walk of the ring from write - ringSize up to write
+ *
+ * A record is accepted if its pos equals the position it is found at and
+ * it ends within the ring. Otherwise the walk resyncs at the next aligned
+ * position, e.g. at the partly overwritten oldest record.
+ * ****************************************************************************/
+static void decode__ring(const struct ttyMmapHeader *_header, const char *_ring, int _verbose, struct decode_result *_result)
+{
+	const struct ttyMmapRecord *record;
+	const uint64_t size = _header->ringSize;
+	const uint64_t mask = size - 1;
+	uint64_t pos, end, offset, recordSize;
+
+	end = _header->write;
+	pos = (end > size) ? (end - size) : 0;
+
+	while (pos < end) {
+		offset = pos & mask;
+
+		if ((size - offset) < sizeof(struct ttyMmapRecord)) {
+			/* remainder up to the end of the ring without pad record */
+			pos += size - offset;
+			continue;
+		}
+
+		record = (const struct ttyMmapRecord*)(_ring + offset);
+		recordSize = M_TTYMMAP_RECORD_SIZE(record->len);
+
+		if ((record->pos != pos) || (record->len > size) || ((offset + recordSize) > size)) {
+			_result->skipped += M_TTYMMAP_ALIGN;
+			pos += M_TTYMMAP_ALIGN;
+			continue;
+		}
+
+		if ((record->flags & M_TTYMMAP_FLAG_PAD) == 0) {
+			if (_verbose) {
+				printf("[%llu %s] ", (unsigned long long)pos,
+						(record->streamType < TTYSTREAM_CNT) ? s_streamName[record->streamType] : "?");
+			}
+			fwrite(record + 1, 1, record->len, stdout);
+			if (_verbose && ((record->len == 0) || (((const char*)(record + 1))[record->len - 1] != '\n'))) {
+				putchar('\n');
+			}
+			_result->records++;
+		}
+
+		pos += recordSize;
+	}
+}